@@ -0,0 +1,80 @@
+#!/bin/bash
+# Run distributed batch on localhost with two local worker nodes and one node that never answers,
+# checks every asset is finished once the stuck node hits the asset timeout.
+# Usage: shell/test-batch-cluster.sh [path to CollisionCraft binary]
+
+CWD=$PWD
+BIN_PATH=${1:-$CWD/build/bin/CollisionCraft}
+PORT=${BATCH_TEST_PORT:-47311}
+NUM_ASSETS=6
+
+TEST_PATH=$(mktemp -d)
+trap 'rm -rf $TEST_PATH' EXIT
+
+# Unit cube shifted along X, one asset each.
+for asset_idx in $(seq 1 $NUM_ASSETS); do
+cat > $TEST_PATH/cube_$asset_idx.usda << EOF
+#usda 1.0
+
+def Mesh "cube"
+{
+    point3f[] points = [($asset_idx, 0, 0), ($asset_idx.5, 0, 0), ($asset_idx.5, 0.5, 0), ($asset_idx, 0.5, 0), ($asset_idx, 0, 0.5), ($asset_idx.5, 0, 0.5), ($asset_idx.5, 0.5, 0.5), ($asset_idx, 0.5, 0.5)]
+    int[] faceVertexCounts = [4, 4, 4, 4, 4, 4]
+    int[] faceVertexIndices = [0, 3, 2, 1, 4, 5, 6, 7, 0, 1, 5, 4, 1, 2, 6, 5, 2, 3, 7, 6, 3, 0, 4, 7]
+}
+EOF
+done
+
+ASSETS=$(ls $TEST_PATH/*.usda | sed 's/.*/"&"/' | paste -sd, -)
+cat > $TEST_PATH/manifest.json << EOF
+{
+    "listen_address": "127.0.0.1",
+    "port": $PORT,
+    "local_workers": 2,
+    "asset_timeout": 5,
+    "output_directory": "$TEST_PATH/collision",
+    "settings": {"technique": "simple_hull"},
+    "assets": [$ASSETS]
+}
+EOF
+
+# Node taking an asset and never answering, its asset has to be handed to a local node.
+python3 - $PORT << 'EOF' &
+import json, socket, sys, time
+for attempt in range(100):
+    try:
+        node = socket.create_connection(("127.0.0.1", int(sys.argv[1])))
+        break
+    except OSError:
+        time.sleep(0.1)
+else:
+    sys.exit(1)
+
+stream = node.makefile("rw")
+for line in stream:
+    message = json.loads(line)
+    if message["type"] == "settings":
+        stream.write(json.dumps({"type": "ready"}) + "\n")
+        stream.flush()
+    elif message["type"] == "asset":
+        time.sleep(3600)
+EOF
+STUCK_NODE=$!
+
+$BIN_PATH --coordinate $TEST_PATH/manifest.json
+EXIT_CODE=$?
+kill $STUCK_NODE 2> /dev/null
+
+if [ $EXIT_CODE -ne 0 ]; then
+    echo "Batch coordinator failed with exit code $EXIT_CODE"
+    exit 1
+fi
+
+NUM_DONE=$(python3 -c "import json, sys; print(json.load(open(sys.argv[1]))['num_done'])" $TEST_PATH/collision/batch_summary.json)
+if [ "$NUM_DONE" != "$NUM_ASSETS" ]; then
+    echo "Batch finished $NUM_DONE of $NUM_ASSETS assets"
+    exit 1
+fi
+
+echo "Batch finished all $NUM_ASSETS assets"
+cd $CWD
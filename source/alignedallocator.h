@@ -0,0 +1,54 @@
+#ifndef ALIGNED_ALLOCATOR_H
+#define ALIGNED_ALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+
+
+/// Standard allocator returning storage aligned to given boundary, defaults to cache line size.
+/// Allows containers to be handed to vectorized and GPU upload code without realignment.
+template <typename T, size_t Alignment = 64>
+class AlignedAllocator
+{
+public:
+    static_assert(Alignment >= alignof(T), "Alignment must satisfy alignment of the element type");
+
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept
+    {
+    }
+
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T *ptr, size_t count) noexcept
+    {
+        ::operator delete(ptr, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept
+    {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept
+    {
+        return false;
+    }
+};
+
+#endif
@@ -1,5 +1,7 @@
 #include "appwindow.h"
+#include "collisioncache.h"
 #include "collisiongen.h"
+#include "collisionjob.h"
 #include "logging.h"
 #include "logwidget.h"
 #include "modelloader.h"
@@ -9,6 +11,7 @@
 #include "viewportwidget.h"
 #include "windowbase.h"
 
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
 #include <vector>
@@ -20,8 +23,6 @@
 
 AppWindow::AppWindow(QWidget *parent) : QMainWindow(parent)
 {
-    this->collision_gen = std::make_unique<CollisionGen>();
-
     this->ui.setupUi(this);
     this->resize(512, 512);
 
@@ -35,6 +36,17 @@ AppWindow::AppWindow(QWidget *parent) : QMainWindow(parent)
     this->registerEvents();
 }
 
+/// Default destructor.
+/// Ensures any background collision job is stopped before the scene is torn down.
+AppWindow::~AppWindow()
+{
+    if (this->collision_job)
+    {
+        this->collision_job->cancel();
+        this->collision_job->wait();
+    }
+}
+
 /// Create and append all UI widgets to this window.
 void AppWindow::initWidgets()
 {
@@ -106,6 +118,20 @@ void AppWindow::registerEvents()
         &AppWindow::onCollisionGenerationRequested
     );
 
+    connect(
+        this->property_panel,
+        &PropertyPanelWidget::collisionGenerationCancelRequested,
+        this,
+        &AppWindow::onCollisionGenerationCancelRequested
+    );
+
+    connect(
+        this->property_panel,
+        &PropertyPanelWidget::collisionAutoTuneRequested,
+        this,
+        &AppWindow::onCollisionAutoTuneRequested
+    );
+
     connect(
         this->property_panel,
         &PropertyPanelWidget::viewportSettingsChanged,
@@ -130,8 +156,9 @@ void AppWindow::clearAllModels()
 void AppWindow::clearAllCollisionModels()
 {
 
-    logDebug("Clearing all {} collision models in the scene", this->collision_models.size());
-    for (const std::unique_ptr<SceneModel> &model : this->collision_models)
+    std::vector<SceneModel*> collisions = this->getCollisionModels();
+    logDebug("Clearing all {} collision models in the scene", collisions.size());
+    for (SceneModel *model : collisions)
     {
         this->viewport_widget->removeRenderMesh(&model->getRenderMesh());
     }
@@ -139,13 +166,86 @@ void AppWindow::clearAllCollisionModels()
     this->collision_models.clear();
 }
 
+/// Unloads and removes collision models generated for given source model.
+/// @param: source Source model or nullptr to remove collision enveloping whole scene.
+void AppWindow::removeModelCollision(const SceneModel *source)
+{
+    auto it = this->collision_models.find(source);
+    if (it == this->collision_models.end())
+    {
+        return;
+    }
+
+    for (const std::unique_ptr<SceneModel> &model : it->second.models)
+    {
+        this->viewport_widget->removeRenderMesh(&model->getRenderMesh());
+    }
+
+    this->collision_models.erase(it);
+}
+
+/// Get all collision models in the scene ordered by their source models.
+/// Collision enveloping the whole scene comes last.
+std::vector<SceneModel*> AppWindow::getCollisionModels() const
+{
+    std::vector<const SceneModel*> sources;
+    sources.reserve(this->models.size() + 1);
+    for (const std::unique_ptr<SceneModel> &model : this->models)
+    {
+        sources.push_back(model.get());
+    }
+    sources.push_back(nullptr);
+
+    std::vector<SceneModel*> collisions;
+    for (const SceneModel *source : sources)
+    {
+        auto it = this->collision_models.find(source);
+        if (it == this->collision_models.end())
+        {
+            continue;
+        }
+
+        for (const std::unique_ptr<SceneModel> &model : it->second.models)
+        {
+            collisions.push_back(model.get());
+        }
+    }
+
+    return collisions;
+}
+
 /// Unloads all models and collisions from active scene.
+/// Active collision job is cancelled and its results dropped, as its source models are gone.
 void AppWindow::clearScene()
 {
+    if (this->collision_job)
+    {
+        logInfo("Cancelling collision generation of cleared scene");
+        this->collision_job->cancel();
+    }
+
+    this->job_sources.clear();
+    this->job_keys.clear();
+    this->job_scene_hull = false;
+
     this->clearAllModels();
     this->clearAllCollisionModels();
 }
 
+/// Bind persistent cache used to reuse previously generated collision.
+/// @param: cache Cache to use or nullptr to disable caching.
+void AppWindow::setCollisionCache(std::shared_ptr<CollisionCache> cache)
+{
+    this->collision_cache = cache;
+}
+
+/// Set directory collision metrics reports are written to.
+/// @param: directory Report directory or empty string to only log the metrics.
+void AppWindow::setReportDirectory(const std::string &directory)
+{
+    this->report_directory = directory;
+}
+
 /// Loads model from asset file.
 /// @param: filepath Location of model file on disk on in app resources.
 /// @param: clear_scene Reset active scene before loading.
@@ -170,13 +270,16 @@ void AppWindow::loadModel(const std::string &filepath, bool clear_scene)
 }
 
 /// Create collision model from given mesh and add it to current scene.
-void AppWindow::addCollisionModel(const Mesh &collision_mesh)
+/// @param: source Model the collision was generated for, nullptr if it envelops whole scene.
+void AppWindow::addCollisionModel(const Mesh &collision_mesh, const SceneModel *source)
 {
     this->viewport_widget->makeCurrent();
-    this->collision_models.push_back(std::make_unique<SceneModel>(collision_mesh));
-    this->collision_models.back()->getRenderMesh().setMaterial(RenderMeshMaterial::Collision);
-    this->collision_models.back()->getRenderMesh().setStyle(RenderMeshStyle::ShadedWireframe);
-    this->viewport_widget->addRenderMesh(&this->collision_models.back()->getRenderMesh());
+
+    std::vector<std::unique_ptr<SceneModel>> &collisions = this->collision_models[source].models;
+    collisions.push_back(std::make_unique<SceneModel>(collision_mesh));
+    collisions.back()->getRenderMesh().setMaterial(RenderMeshMaterial::Collision);
+    collisions.back()->getRenderMesh().setStyle(RenderMeshStyle::ShadedWireframe);
+    this->viewport_widget->addRenderMesh(&collisions.back()->getRenderMesh());
 }
 
 /// Event handler invoked when viewport graphics initialisation is completed.
@@ -197,34 +300,278 @@ void AppWindow::onViewportReady()
     this->updateViewportSettings(this->property_panel->getViewportSettings());
 }
 
-/// Generate approximate collision using approximate convex decomposition technique.
+/// Generate scene collision using technique selected in given settings.
+/// Only models whose geometry or relevant settings changed since their collision was generated
+/// are regenerated. Generation runs as background job, results are applied to the scene once
+/// the job completes.
 void AppWindow::generateApproximateCollision(const CollisionGenSettings &settings)
 {
-    logDebug("Generating scene approximate collision");
+    if (this->collision_job)
+    {
+        logWarning("Collision generation already in progress");
+        return;
+    }
+
+    logDebug("Generating scene collision");
+    this->job_sources.clear();
+    this->job_keys.clear();
+    this->job_settings = settings;
 
-    // Clear existing collision.
-    for (const auto &collision : this->collision_models)
+    this->job_scene_hull = CollisionGen::isSceneHull(settings);
+    if (this->job_scene_hull)
     {
-        this->viewport_widget->removeRenderMesh(&collision->getRenderMesh());
+        for (const auto &model : this->models)
+        {
+            this->job_sources.push_back(model.get());
+            this->job_keys.push_back(0);
+        }
+    }
+    else
+    {
+        /// Drop collision of models no longer in the scene or collision enveloping the whole scene.
+        std::vector<const SceneModel*> stale_sources;
+        for (const auto &[source, collision] : this->collision_models)
+        {
+            auto it = std::find_if(this->models.begin(), this->models.end(), [source](const auto &model)
+            {
+                return model.get() == source;
+            });
+
+            if (!source || it == this->models.end())
+            {
+                stale_sources.push_back(source);
+            }
+        }
+
+        for (const SceneModel *source : stale_sources)
+        {
+            this->removeModelCollision(source);
+        }
+
+        for (const auto &model : this->models)
+        {
+            const uint64_t key = CollisionGen::computeCacheKey(model->getMeshHash(), settings);
+            auto it = this->collision_models.find(model.get());
+            if (it != this->collision_models.end() && it->second.key == key)
+            {
+                continue;
+            }
+
+            this->job_sources.push_back(model.get());
+            this->job_keys.push_back(key);
+        }
+
+        logInfo(
+            "Regenerating collision for {} of {} models",
+            this->job_sources.size(),
+            this->models.size()
+        );
+
+        if (this->job_sources.empty())
+        {
+            this->updateViewportSettings(this->property_panel->getViewportSettings());
+            return;
+        }
+    }
+
+    this->collision_job = std::make_unique<CollisionJob>(settings);
+    this->startCollisionJob();
+}
+
+/// Search approximate decomposition settings for the cheapest collision of all scene models
+/// meeting given target. Settings variants are generated concurrently as single background job,
+/// selected settings are applied to the property panel along with their collision.
+/// @param: settings Settings the swept variants are derived from.
+/// @param: target Budget the selected collision has to meet.
+void AppWindow::autoTuneCollision(const CollisionGenSettings &settings, const CollisionSweepTarget &target)
+{
+    if (this->collision_job)
+    {
+        logWarning("Collision generation already in progress");
+        return;
     }
-    this->collision_models.clear();
 
-    // Reset collision generator.
-    this->collision_gen->clearInputMeshes();
+    if (this->models.empty())
+    {
+        logWarning("No models in the scene to tune collision for");
+        return;
+    }
+
+    std::vector<CollisionGenSettings> variants = CollisionSweep::generateVariants(settings, target);
+    logInfo("Auto-tuning collision of {} models over {} settings variants", this->models.size(), variants.size());
+
+    this->job_sources.clear();
+    this->job_keys.clear();
+    this->job_settings = settings;
+    this->job_scene_hull = false;
     for (const auto &model : this->models)
     {
-        this->collision_gen->addInputMesh(&model->getMesh());
+        this->job_sources.push_back(model.get());
+        this->job_keys.push_back(0);
+    }
+
+    this->collision_job = std::make_unique<CollisionJob>(settings);
+    this->collision_job->setSweep(variants, target);
+
+    connect(
+        this->collision_job.get(),
+        &CollisionJob::settingsTuned,
+        this,
+        &AppWindow::onCollisionSettingsTuned,
+        Qt::QueuedConnection
+    );
+
+    this->startCollisionJob();
+}
+
+/// Bind active collision job to the scene and start it on a background thread.
+/// Input meshes are taken from the job sources.
+void AppWindow::startCollisionJob()
+{
+    this->collision_job->setCache(this->collision_cache);
+    this->collision_job->setReportDirectory(this->report_directory);
+    for (const SceneModel *source : this->job_sources)
+    {
+        this->collision_job->addInputMesh(source->getMesh());
     }
 
-    std::vector<std::unique_ptr<Mesh>> collisions;
-    this->collision_gen->generateVHACD(settings, collisions);
+    connect(
+        this->collision_job.get(),
+        &CollisionJob::progressChanged,
+        this,
+        &AppWindow::onCollisionJobProgress,
+        Qt::QueuedConnection
+    );
+
+    connect(
+        this->collision_job.get(),
+        &CollisionJob::collisionGenerated,
+        this,
+        &AppWindow::onCollisionJobCompleted,
+        Qt::QueuedConnection
+    );
+
+    connect(
+        this->collision_job.get(),
+        &CollisionJob::collisionLODsGenerated,
+        this,
+        &AppWindow::onCollisionLODsGenerated,
+        Qt::QueuedConnection
+    );
+
+    connect(
+        this->collision_job.get(),
+        &QThread::finished,
+        this,
+        &AppWindow::onCollisionJobFinished,
+        Qt::QueuedConnection
+    );
+
+    this->property_panel->setGenerationActive(true);
+    this->collision_job->start();
+}
+
+/// Event handler invoked when background collision job reports progress.
+void AppWindow::onCollisionJobProgress(double progress, const QString &stage)
+{
+    if (this->collision_job)
+    {
+        this->property_panel->setGenerationProgress(progress, stage);
+    }
+}
 
-    logInfo("Generated {} approximate collision meshes", collisions.size());
+/// Event handler invoked when background collision job delivers generated collision.
+/// Replaces existing collision of each regenerated model, collision of other models is kept.
+void AppWindow::onCollisionJobCompleted(CollisionJobResult result)
+{
     this->viewport_widget->makeCurrent();
-    for (const auto &collision : collisions)
+    size_t num_collisions = 0;
+
+    if (this->job_scene_hull)
+    {
+        this->clearAllCollisionModels();
+        for (const std::unique_ptr<Mesh> &collision : result->front())
+        {
+            this->addCollisionModel(*collision, nullptr);
+            num_collisions++;
+        }
+    }
+    else
+    {
+        for (size_t i=0; i < result->size() && i < this->job_sources.size(); i++)
+        {
+            const SceneModel *source = this->job_sources.at(i);
+            const uint64_t key = this->job_keys.at(i);
+
+            /// Skip models removed from the scene or replaced while the job was running, a new
+            /// model reusing the address of a removed one does not match the collision key.
+            auto it = std::find_if(this->models.begin(), this->models.end(), [source](const auto &model)
+            {
+                return model.get() == source;
+            });
+
+            if (it == this->models.end() ||
+                CollisionGen::computeCacheKey((*it)->getMeshHash(), this->job_settings) != key)
+            {
+                continue;
+            }
+
+            this->removeModelCollision(nullptr);
+            this->removeModelCollision(source);
+            this->collision_models[source].key = key;
+            for (const std::unique_ptr<Mesh> &collision : result->at(i))
+            {
+                this->addCollisionModel(*collision, source);
+                num_collisions++;
+            }
+        }
+    }
+
+    logInfo("Generated {} collision meshes", num_collisions);
+    this->updateViewportSettings(this->property_panel->getViewportSettings());
+}
+
+/// Event handler invoked when background collision job delivers coarser collision LOD levels.
+/// Levels are attached to collision of each source model delivered by the same job.
+void AppWindow::onCollisionLODsGenerated(CollisionJobLODResult lods)
+{
+    if (this->job_scene_hull)
+    {
+        return;
+    }
+
+    for (size_t i=0; i < this->job_sources.size(); i++)
+    {
+        /// Skip models whose collision was removed or replaced since the finest level arrived.
+        auto it = this->collision_models.find(this->job_sources.at(i));
+        if (it == this->collision_models.end() || it->second.key != this->job_keys.at(i))
+        {
+            continue;
+        }
+
+        it->second.lods.clear();
+        for (std::vector<std::vector<std::unique_ptr<Mesh>>> &level : *lods)
+        {
+            if (i < level.size())
+            {
+                it->second.lods.push_back(std::move(level.at(i)));
+            }
+        }
+    }
+
+    logInfo("Generated {} additional collision LOD levels", lods->size());
+}
+
+/// Event handler invoked when background collision job thread exits.
+void AppWindow::onCollisionJobFinished()
+{
+    if (this->collision_job)
     {
-        this->addCollisionModel(*collision);
+        this->collision_job->wait();
+        this->collision_job.reset();
     }
+
+    this->property_panel->setGenerationActive(false);
 }
 
 /// Event handler invoked when user clicks on 'File -> Import Model' menu item.
@@ -246,14 +593,70 @@ void AppWindow::onExportCollisionClick()
     if (!filepath.isEmpty())
     {
         std::vector<const Mesh*> meshes;
-        meshes.reserve(this->collision_models.size());
-        for (const auto &collision : this->collision_models)
+        for (const SceneModel *collision : this->getCollisionModels())
         {
             meshes.push_back(&collision->getMesh());
         }
 
-        logInfo("Writing {} meshes to USD file -> {}", meshes.size(), filepath.toStdString());
-        ModelLoader::SaveUSD(filepath.toStdString(), meshes);
+        size_t num_levels = 1;
+        for (const auto &[source, collision] : this->collision_models)
+        {
+            num_levels = std::max(num_levels, collision.lods.size() + 1);
+        }
+
+        if (num_levels == 1)
+        {
+            logInfo("Writing {} meshes to USD file -> {}", meshes.size(), filepath.toStdString());
+            ModelLoader::SaveUSD(filepath.toStdString(), meshes);
+            return;
+        }
+
+        /// Sources are visited in the same order as in getCollisionModels, collision of models with
+        /// fewer levels than others repeats their coarsest level.
+        std::vector<const SceneModel*> sources;
+        for (const std::unique_ptr<SceneModel> &model : this->models)
+        {
+            sources.push_back(model.get());
+        }
+        sources.push_back(nullptr);
+
+        std::vector<std::vector<const Mesh*>> levels(num_levels);
+        levels.front() = meshes;
+        for (size_t level=1; level < num_levels; level++)
+        {
+            for (const SceneModel *source : sources)
+            {
+                auto it = this->collision_models.find(source);
+                if (it == this->collision_models.end())
+                {
+                    continue;
+                }
+
+                const ModelCollision &collision = it->second;
+                if (collision.lods.empty())
+                {
+                    for (const std::unique_ptr<SceneModel> &model : collision.models)
+                    {
+                        levels.at(level).push_back(&model->getMesh());
+                    }
+                    continue;
+                }
+
+                const size_t lod = std::min(level, collision.lods.size()) - 1;
+                for (const std::unique_ptr<Mesh> &mesh : collision.lods.at(lod))
+                {
+                    levels.at(level).push_back(mesh.get());
+                }
+            }
+        }
+
+        logInfo(
+            "Writing {} collision LOD levels with {} finest meshes to USD file -> {}",
+            num_levels,
+            meshes.size(),
+            filepath.toStdString()
+        );
+        ModelLoader::SaveLODsUSD(filepath.toStdString(), levels);
     }
 }
 
@@ -287,7 +690,51 @@ void AppWindow::onCollisionGenerationRequested()
 {
     CollisionGenSettings settings = this->property_panel->getSettings();
     this->generateApproximateCollision(settings);
-    this->viewport_widget->update();
+}
+
+/// Event handler invoked when user requests collision settings to be tuned to the target budget.
+void AppWindow::onCollisionAutoTuneRequested()
+{
+    CollisionGenSettings settings = this->property_panel->getSettings();
+    CollisionSweepTarget target = this->property_panel->getSweepTarget();
+    this->autoTuneCollision(settings, target);
+}
+
+/// Event handler invoked when auto-tuning job selects settings.
+/// Collision delivered by the job is keyed by the selected settings so later generation with
+/// the same settings reuses it.
+void AppWindow::onCollisionSettingsTuned(const CollisionGenSettings &settings)
+{
+    logInfo(
+        "Auto-tuned settings: resolution {:.0f}, concavity {:.4f}, max hulls {}, max hull vertices {}",
+        settings.resolution,
+        settings.concavity,
+        settings.max_hulls,
+        settings.max_hull_vertices
+    );
+
+    this->job_settings = settings;
+    for (const auto &model : this->models)
+    {
+        auto it = std::find(this->job_sources.begin(), this->job_sources.end(), model.get());
+        if (it != this->job_sources.end())
+        {
+            const size_t idx = std::distance(this->job_sources.begin(), it);
+            this->job_keys.at(idx) = CollisionGen::computeCacheKey(model->getMeshHash(), settings);
+        }
+    }
+
+    this->property_panel->applyTunedSettings(settings);
+}
+
+/// Event handler invoked when user requests active collision generation to stop.
+void AppWindow::onCollisionGenerationCancelRequested()
+{
+    if (this->collision_job)
+    {
+        logInfo("Cancelling collision generation");
+        this->collision_job->cancel();
+    }
 }
 
 /// Event handler invoked when the user updates any of the viewport settings properties on
@@ -319,7 +766,7 @@ void AppWindow::updateViewportSettings(const ViewportSettings &settings)
         collision_style = RenderMeshStyle::Shaded;
     }
 
-    for (const std::unique_ptr<SceneModel> &collision : this->collision_models)
+    for (SceneModel *collision : this->getCollisionModels())
     {
         collision->getRenderMesh().setStyle(collision_style);
         collision->getRenderMesh().setVisibility(!settings.collision_hidden);
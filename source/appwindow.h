@@ -3,10 +3,15 @@
 
 #include <QMainWindow>
 #include <QVBoxLayout>
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "collisioncache.h"
 #include "collisiongen.h"
+#include "collisionjob.h"
 #include "scenemodel.h"
 #include "windowbase.h"
 #include "viewportwidget.h"
@@ -14,17 +19,32 @@
 #include "propertypanel.h"
 
 
+/// Collision hulls generated for single source model.
+struct ModelCollision
+{
+    uint64_t key = 0;
+    std::vector<std::unique_ptr<SceneModel>> models;
+    /// Coarser collision LOD levels, level 1 first, empty when only single level was generated.
+    std::vector<std::vector<std::unique_ptr<Mesh>>> lods;
+};
+
+
 class AppWindow : public QMainWindow
 {
     Q_OBJECT
 
 public:
     AppWindow(QWidget *parent = nullptr);
+    ~AppWindow();
     void loadModel(const std::string &filepath, bool clear_scene=false);
-    void addCollisionModel(const Mesh &collision_mesh);
+    void addCollisionModel(const Mesh &collision_mesh, const SceneModel *source = nullptr);
+    void removeModelCollision(const SceneModel *source);
+    std::vector<SceneModel*> getCollisionModels() const;
     void clearAllModels();
     void clearAllCollisionModels();
     void clearScene();
+    void setCollisionCache(std::shared_ptr<CollisionCache> cache);
+    void setReportDirectory(const std::string &directory);
 
 protected:
     void onViewportReady();
@@ -33,13 +53,24 @@ protected:
     void onExportCollisionClick();
     void onFrameAllClick();
     void onCollisionGenerationRequested();
+    void onCollisionGenerationCancelRequested();
+    void onCollisionAutoTuneRequested();
+    void onCollisionSettingsTuned(const CollisionGenSettings &settings);
+    void onCollisionJobProgress(double progress, const QString &stage);
+    void onCollisionJobCompleted(CollisionJobResult result);
+    void onCollisionLODsGenerated(CollisionJobLODResult lods);
+    void onCollisionJobFinished();
     void onPropertyPanelViewportSettingsChanged(ViewportSettings settings);
 
     void generateApproximateCollision(const CollisionGenSettings &settings);
+    void autoTuneCollision(const CollisionGenSettings &settings, const CollisionSweepTarget &target);
+    void startCollisionJob();
     void updateViewportSettings(const ViewportSettings &settings);
 
 protected:
-    std::unique_ptr<CollisionGen> collision_gen;
+    std::unique_ptr<CollisionJob> collision_job;
+    std::shared_ptr<CollisionCache> collision_cache;
+    std::string report_directory;
 
 private:
     void initWidgets();
@@ -51,6 +82,14 @@ private:
     PropertyPanelWidget *property_panel;
 
     std::vector<std::unique_ptr<SceneModel>> models;
-    std::vector<std::unique_ptr<SceneModel>> collision_models;
+    /// Collision models keyed by their source model, nullptr key holds collision
+    /// which envelops the whole scene.
+    std::unordered_map<const SceneModel*, ModelCollision> collision_models;
+
+    /// Source models and their collision keys for each input mesh of the active job.
+    std::vector<const SceneModel*> job_sources;
+    std::vector<uint64_t> job_keys;
+    CollisionGenSettings job_settings = {};
+    bool job_scene_hull = false;
 };
 #endif
@@ -0,0 +1,487 @@
+#include "batchcluster.h"
+#include "collisionmetrics.h"
+#include "logging.h"
+
+#include <chrono>
+#include <deque>
+#include <optional>
+#include <unordered_map>
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QProcess>
+#include <QStringList>
+#include <QTcpServer>
+#include <QTimer>
+
+/// Number of times an asset is handed out before its node disconnecting marks it as failed.
+static const int MAX_ASSET_ATTEMPTS = 3;
+
+/// Number of times a local worker node is restarted after it exits unexpectedly.
+static const int MAX_NODE_RESTARTS = 8;
+
+/// Time given to local worker nodes to exit once the batch finished, in milliseconds.
+static const int NODE_EXIT_TIMEOUT_MS = 10000;
+
+/// Time given to a node to connect to its coordinator, in milliseconds.
+static const int CONNECT_TIMEOUT_MS = 30000;
+
+/// Seconds a node may spend on single asset unless the manifest sets "asset_timeout".
+static const double DEFAULT_ASSET_TIMEOUT = 3600.0;
+
+
+BatchCoordinator::BatchCoordinator(std::shared_ptr<CollisionCache> cache) :
+    BatchRunner(cache)
+{
+}
+
+/// Hand given assets out to connected worker nodes and gather their results.
+/// Messages in both directions are single line JSON objects. Coordinator sends "settings" to
+/// each new node, node answers "ready" and receives one "asset" at a time, each answered by
+/// a "result". Assets of disconnected nodes are handed to another node, node not answering
+/// within "asset_timeout" seconds is disconnected the same way. Once all assets are finished
+/// every node receives "done".
+/// @param: pending Indices of assets to process.
+void BatchCoordinator::processAssets(const std::vector<size_t> &pending)
+{
+    const QString listen_address = this->manifest.value("listen_address").toString("127.0.0.1");
+    const int port = this->manifest.value("port").toInt(0);
+    const int local_workers = this->manifest.value("local_workers").toInt(0);
+    const double asset_timeout = this->manifest.value("asset_timeout").toDouble(DEFAULT_ASSET_TIMEOUT);
+
+    QTcpServer server;
+    if (!server.listen(QHostAddress(listen_address), port))
+    {
+        logError(
+            "Batch coordinator failed to listen on {}:{} -> {}",
+            listen_address.toStdString(),
+            port,
+            server.errorString().toStdString()
+        );
+
+        for (size_t asset_idx : pending)
+        {
+            BatchAsset result = this->assets.at(asset_idx);
+            result.status = "failed";
+            result.error = "Batch coordinator failed to listen for worker nodes";
+            this->finishAsset(asset_idx, result);
+        }
+
+        return;
+    }
+
+    logInfo("Batch coordinator listening on {}:{}", listen_address.toStdString(), server.serverPort());
+
+    QEventLoop loop;
+    std::deque<size_t> queue(pending.begin(), pending.end());
+    std::vector<int> attempts(this->assets.size(), 0);
+    size_t num_remaining = pending.size();
+
+    /// Asset each connected node is processing, if any.
+    std::unordered_map<QTcpSocket*, std::optional<size_t>> nodes;
+
+    /// Deadline timer of each connected node, running while the node has an asset assigned.
+    std::unordered_map<QTcpSocket*, QTimer*> deadlines;
+
+    auto complete = [&](size_t asset_idx, const BatchAsset &result)
+    {
+        this->finishAsset(asset_idx, result);
+        if (--num_remaining == 0)
+        {
+            loop.quit();
+        }
+    };
+
+    auto dispatch = [&](QTcpSocket *socket)
+    {
+        if (queue.empty())
+        {
+            return;
+        }
+
+        const size_t asset_idx = queue.front();
+        queue.pop_front();
+        attempts.at(asset_idx)++;
+        nodes.at(socket) = asset_idx;
+        if (asset_timeout > 0.0)
+        {
+            deadlines.at(socket)->start(std::chrono::milliseconds(qint64(asset_timeout * 1000.0)));
+        }
+
+        QJsonObject message;
+        message["type"] = "asset";
+        message["index"] = qint64(asset_idx);
+        message["input"] = QString::fromStdString(this->assets.at(asset_idx).input);
+        message["output"] = QString::fromStdString(this->assets.at(asset_idx).output);
+        BatchNode::sendMessage(*socket, message);
+    };
+
+    auto receive = [&](QTcpSocket *socket, const QJsonObject &message)
+    {
+        const QString type = message["type"].toString();
+        if (type == "ready")
+        {
+            dispatch(socket);
+        }
+        else if (type == "result")
+        {
+            std::optional<size_t> &assigned = nodes.at(socket);
+            const qint64 asset_idx = message["index"].toInteger(-1);
+            if (!assigned || qint64(*assigned) != asset_idx)
+            {
+                logWarning("Batch node sent result of asset it was not assigned -> {}", asset_idx);
+                return;
+            }
+
+            BatchAsset result = this->assets.at(*assigned);
+            BatchRunner::assetFromJson(message["asset"].toObject(), result);
+            assigned.reset();
+            deadlines.at(socket)->stop();
+            complete(asset_idx, result);
+            dispatch(socket);
+        }
+    };
+
+    /// Local nodes which are running or will be restarted.
+    int num_local_alive = local_workers;
+
+    /// Batch started with local nodes cannot finish once all of them gave up and no other node
+    /// is connected, remaining assets are failed instead of waiting forever.
+    auto check_stalled = [&]()
+    {
+        if (num_remaining == 0 || !nodes.empty() || local_workers == 0 || num_local_alive > 0)
+        {
+            return;
+        }
+
+        logError("All local batch nodes gave up and no other node is connected, failing {} remaining assets", num_remaining);
+        while (!queue.empty())
+        {
+            const size_t asset_idx = queue.front();
+            queue.pop_front();
+
+            BatchAsset result = this->assets.at(asset_idx);
+            result.status = "failed";
+            result.error = "No batch node left to process asset";
+            complete(asset_idx, result);
+        }
+    };
+
+    auto remove_node = [&](QTcpSocket *socket)
+    {
+        auto it = nodes.find(socket);
+        if (it == nodes.end())
+        {
+            return;
+        }
+
+        const std::optional<size_t> assigned = it->second;
+        nodes.erase(it);
+        deadlines.erase(socket);
+        socket->deleteLater();
+
+        if (!assigned)
+        {
+            logInfo("Batch node disconnected");
+            return;
+        }
+
+        BatchAsset result = this->assets.at(*assigned);
+        if (attempts.at(*assigned) >= MAX_ASSET_ATTEMPTS)
+        {
+            result.status = "failed";
+            result.error = "Worker node disconnected or timed out while processing asset";
+            complete(*assigned, result);
+        }
+        else
+        {
+            logWarning("Batch node disconnected, asset handed to another node -> {}", result.input);
+            queue.push_front(*assigned);
+            for (auto &[node, node_asset] : nodes)
+            {
+                if (!node_asset)
+                {
+                    dispatch(node);
+                    break;
+                }
+            }
+        }
+
+        if (nodes.empty() && num_remaining > 0)
+        {
+            logWarning("No batch nodes connected, waiting for nodes on port {}", server.serverPort());
+            check_stalled();
+        }
+    };
+
+    QObject::connect(&server, &QTcpServer::newConnection, &server, [&]()
+    {
+        while (QTcpSocket *socket = server.nextPendingConnection())
+        {
+            logInfo("Batch node connected -> {}", socket->peerAddress().toString().toStdString());
+            nodes.emplace(socket, std::nullopt);
+
+            /// Node stuck on an asset is dropped, so the asset is handed to another node or failed.
+            QTimer *deadline = new QTimer(socket);
+            deadline->setSingleShot(true);
+            deadlines.emplace(socket, deadline);
+            QObject::connect(deadline, &QTimer::timeout, socket, [&, socket]()
+            {
+                logWarning(
+                    "Batch node exceeded asset timeout of {:.0f}s, disconnecting -> {}",
+                    asset_timeout,
+                    socket->peerAddress().toString().toStdString()
+                );
+
+                remove_node(socket);
+                socket->abort();
+            });
+
+            QObject::connect(socket, &QTcpSocket::readyRead, socket, [&, socket]()
+            {
+                while (socket->canReadLine() && nodes.contains(socket))
+                {
+                    receive(socket, QJsonDocument::fromJson(socket->readLine()).object());
+                }
+            });
+
+            QObject::connect(socket, &QTcpSocket::disconnected, socket, [&, socket]()
+            {
+                remove_node(socket);
+            });
+
+            QJsonObject message;
+            message["type"] = "settings";
+            message["settings"] = CollisionMetrics::settingsToJson(this->settings);
+            BatchNode::sendMessage(*socket, message);
+        }
+    });
+
+    /// Local nodes connect over loopback unless the coordinator only listens on another interface.
+    QHostAddress local_address = server.serverAddress();
+    if (local_address == QHostAddress::Any || local_address == QHostAddress::AnyIPv4)
+    {
+        local_address = QHostAddress::LocalHost;
+    }
+    else if (local_address == QHostAddress::AnyIPv6)
+    {
+        local_address = QHostAddress::LocalHostIPv6;
+    }
+
+    const QString node_address = local_address.protocol() == QAbstractSocket::IPv6Protocol
+        ? QString("[%1]:%2").arg(local_address.toString()).arg(server.serverPort())
+        : QString("%1:%2").arg(local_address.toString()).arg(server.serverPort());
+
+    std::vector<std::unique_ptr<QProcess>> workers;
+    std::vector<int> restarts(local_workers, 0);
+    for (int worker_idx=0; worker_idx < local_workers; worker_idx++)
+    {
+        QProcess *worker = workers.emplace_back(std::make_unique<QProcess>()).get();
+        worker->setProgram(QCoreApplication::applicationFilePath());
+        worker->setArguments(QStringList() << "--node" << node_address);
+        worker->setStandardOutputFile(QProcess::nullDevice());
+        worker->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+
+        /// Nodes crashing on an asset or failing to start are started again while there is work left.
+        auto restart = [&, worker, worker_idx]()
+        {
+            if (num_remaining == 0)
+            {
+                return;
+            }
+
+            if (restarts.at(worker_idx)++ >= MAX_NODE_RESTARTS)
+            {
+                logError("Local batch node {} exited too many times, not restarting", worker_idx);
+                num_local_alive--;
+                check_stalled();
+                return;
+            }
+
+            logWarning("Local batch node {} exited unexpectedly, restarting", worker_idx);
+            QTimer::singleShot(0, worker, [worker]()
+            {
+                worker->start();
+            });
+        };
+
+        QObject::connect(worker, &QProcess::finished, worker, [restart](int exit_code, QProcess::ExitStatus status)
+        {
+            if (status != QProcess::NormalExit || exit_code != 0)
+            {
+                restart();
+            }
+        });
+
+        QObject::connect(worker, &QProcess::errorOccurred, worker, [restart](QProcess::ProcessError error)
+        {
+            if (error == QProcess::FailedToStart)
+            {
+                restart();
+            }
+        });
+
+        worker->start();
+    }
+
+    if (local_workers > 0)
+    {
+        logInfo("Started {} local batch nodes", local_workers);
+    }
+
+    loop.exec();
+
+    for (auto &[socket, deadline] : deadlines)
+    {
+        deadline->stop();
+    }
+
+    QJsonObject message;
+    message["type"] = "done";
+    for (auto &[socket, assigned] : nodes)
+    {
+        BatchNode::sendMessage(*socket, message);
+        socket->flush();
+    }
+
+    for (std::unique_ptr<QProcess> &worker : workers)
+    {
+        if (!worker->waitForFinished(NODE_EXIT_TIMEOUT_MS))
+        {
+            worker->kill();
+            worker->waitForFinished();
+        }
+    }
+
+    for (auto &[socket, assigned] : nodes)
+    {
+        socket->disconnect();
+        socket->disconnectFromHost();
+        socket->deleteLater();
+    }
+
+    nodes.clear();
+    deadlines.clear();
+}
+
+
+BatchNode::BatchNode(std::shared_ptr<CollisionCache> cache) :
+    BatchRunner(cache)
+{
+}
+
+/// Connect to batch coordinator and process assets it hands out until it reports the batch done.
+/// @param: address Coordinator address in host:port form.
+/// Returns process exit code, zero once the coordinator finished the batch.
+int BatchNode::runNode(const std::string &address)
+{
+    std::string host;
+    int port = 0;
+    if (!BatchNode::parseAddress(address, host, port))
+    {
+        logError("Invalid batch coordinator address -> {}", address);
+        return 2;
+    }
+
+    QTcpSocket socket;
+    socket.connectToHost(QString::fromStdString(host), port);
+    if (!socket.waitForConnected(CONNECT_TIMEOUT_MS))
+    {
+        logError("Failed to connect to batch coordinator {} -> {}", address, socket.errorString().toStdString());
+        return 2;
+    }
+
+    logInfo("Batch node connected to coordinator -> {}", address);
+    while (true)
+    {
+        while (!socket.canReadLine())
+        {
+            if (!socket.waitForReadyRead(-1))
+            {
+                logError("Lost connection to batch coordinator -> {}", address);
+                return 1;
+            }
+        }
+
+        const QJsonObject message = QJsonDocument::fromJson(socket.readLine()).object();
+        const QString type = message["type"].toString();
+
+        QJsonObject reply;
+        if (type == "settings")
+        {
+            this->settings = BatchRunner::getDefaultSettings();
+            if (!BatchRunner::readSettings(message["settings"].toObject(), this->settings))
+            {
+                return 2;
+            }
+
+            reply["type"] = "ready";
+        }
+        else if (type == "asset")
+        {
+            BatchAsset asset;
+            asset.input = message["input"].toString().toStdString();
+            asset.output = message["output"].toString().toStdString();
+            this->processAsset(asset);
+            logInfo("Batch node asset {} in {:.2f}s -> {}", asset.status, asset.total_duration, asset.input);
+
+            reply["type"] = "result";
+            reply["index"] = message["index"];
+            reply["asset"] = BatchRunner::assetToJson(asset);
+        }
+        else if (type == "done")
+        {
+            logInfo("Batch coordinator finished, node exiting");
+            return 0;
+        }
+        else
+        {
+            continue;
+        }
+
+        BatchNode::sendMessage(socket, reply);
+        while (socket.bytesToWrite() > 0)
+        {
+            if (!socket.waitForBytesWritten(-1))
+            {
+                logError("Lost connection to batch coordinator -> {}", address);
+                return 1;
+            }
+        }
+    }
+}
+
+/// Queue single line JSON message for sending over given socket.
+/// @param: socket Socket to send message over.
+/// @param: message Message to send.
+/// Returns true if the message was queued.
+bool BatchNode::sendMessage(QTcpSocket &socket, const QJsonObject &message)
+{
+    const QByteArray line = QJsonDocument(message).toJson(QJsonDocument::Compact) + '\n';
+    return socket.write(line) == line.size();
+}
+
+/// Split network address into host and port, IPv6 hosts are enclosed in square brackets.
+/// @param: address Address in host:port form.
+/// @param: out_host Receives host part of the address.
+/// @param: out_port Receives port part of the address.
+/// Returns true if the address holds both host and valid port.
+bool BatchNode::parseAddress(const std::string &address, std::string &out_host, int &out_port)
+{
+    const size_t separator = address.rfind(':');
+    if (separator == std::string::npos || separator == 0)
+    {
+        return false;
+    }
+
+    out_host = address.substr(0, separator);
+    if (out_host.size() > 2 && out_host.front() == '[' && out_host.back() == ']')
+    {
+        out_host = out_host.substr(1, out_host.size() - 2);
+    }
+
+    bool valid = false;
+    out_port = QString::fromStdString(address.substr(separator + 1)).toInt(&valid);
+    return valid && out_port > 0 && out_port < 65536;
+}
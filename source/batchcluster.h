@@ -0,0 +1,45 @@
+#ifndef BATCH_CLUSTER_H
+#define BATCH_CLUSTER_H
+
+#include "batchrunner.h"
+#include "collisioncache.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include <QJsonObject>
+#include <QTcpSocket>
+
+
+/// Batch runner handing assets out to worker nodes connected over TCP instead of processing
+/// them itself. Nodes pull one asset at a time, so faster machines take on more of the batch.
+/// Manifest "listen_address" and "port" select where nodes connect to, "local_workers" starts
+/// given number of nodes on this machine and "asset_timeout" limits seconds a node may spend on
+/// single asset, 0=Unlimited. Results and metrics reported by the nodes are gathered
+/// into the checkpoint and summary of the coordinator.
+class BatchCoordinator : public BatchRunner
+{
+public:
+    BatchCoordinator(std::shared_ptr<CollisionCache> cache);
+
+protected:
+    void processAssets(const std::vector<size_t> &pending) override;
+};
+
+
+/// Worker node of distributed batch, processes assets handed out by a coordinator.
+/// Input and output paths are used as sent by the coordinator, so all nodes need to see the
+/// asset library and output directory under the same paths.
+class BatchNode : public BatchRunner
+{
+public:
+    BatchNode(std::shared_ptr<CollisionCache> cache);
+
+    int runNode(const std::string &address);
+
+    static bool sendMessage(QTcpSocket &socket, const QJsonObject &message);
+    static bool parseAddress(const std::string &address, std::string &out_host, int &out_port);
+};
+
+#endif
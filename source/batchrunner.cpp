@@ -0,0 +1,703 @@
+#include "batchrunner.h"
+#include "collisionmetrics.h"
+#include "hashing.h"
+#include "logging.h"
+#include "modelloader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <filesystem>
+#include <numeric>
+#include <unordered_map>
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonValue>
+#include <QString>
+
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+/// Number of slowest assets listed in the log once the batch finishes.
+static const size_t NUM_SLOWEST_ASSETS = 10;
+
+/// Size of chunks input files are read in while hashing their contents.
+static const size_t HASH_CHUNK_SIZE = 1024 * 1024;
+
+
+BatchRunner::BatchRunner(std::shared_ptr<CollisionCache> cache) :
+    cache(cache),
+    settings(BatchRunner::getDefaultSettings()),
+    parallel_assets(0),
+    num_pending(0),
+    num_finished(0)
+{
+}
+
+/// Load list of assets and generation settings from JSON manifest on disk.
+/// Relative paths in the manifest are resolved against the manifest location.
+/// Each asset is either an input path or an object with "input" and optional "output" paths,
+/// assets without an output are written to the output directory mirroring the input layout.
+/// @param: filepath Location of the manifest file on disk.
+/// Returns true if the manifest was loaded and all its assets and settings are valid.
+bool BatchRunner::loadManifest(const std::string &filepath)
+{
+    QFile file(QString::fromStdString(filepath));
+    if (!file.open(QFile::ReadOnly))
+    {
+        logError("Failed to open batch manifest -> {}", filepath);
+        return false;
+    }
+
+    QJsonParseError parse_error;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parse_error);
+    if (!document.isObject())
+    {
+        logError("Failed to parse batch manifest -> {}: {}", filepath, parse_error.errorString().toStdString());
+        return false;
+    }
+
+    const QJsonObject json = document.object();
+    this->manifest = json;
+    const std::filesystem::path manifest_dir = std::filesystem::absolute(filepath).parent_path();
+    auto resolve = [&](const QJsonValue &value, const std::filesystem::path &fallback)
+    {
+        const std::filesystem::path path = value.isString() ? std::filesystem::path(value.toString().toStdString()) : fallback;
+        return (path.is_absolute() ? path : manifest_dir / path).lexically_normal();
+    };
+
+    const std::filesystem::path output_dir = resolve(json["output_directory"], "collision");
+    const std::filesystem::path input_root = resolve(json["input_root"], "");
+    this->checkpoint_path = resolve(json["checkpoint"], output_dir / "batch_checkpoint.jsonl").string();
+    this->summary_path = resolve(json["summary"], output_dir / "batch_summary.json").string();
+    this->parallel_assets = json["parallel_assets"].toInt(0);
+
+    this->settings = BatchRunner::getDefaultSettings();
+    if (json["settings"].isObject() && !BatchRunner::readSettings(json["settings"].toObject(), this->settings))
+    {
+        return false;
+    }
+
+    this->assets.clear();
+    const QJsonArray json_assets = json["assets"].toArray();
+    for (qsizetype asset_idx=0; asset_idx < json_assets.size(); asset_idx++)
+    {
+        const QJsonValue json_asset = json_assets.at(asset_idx);
+        const QJsonValue json_input = json_asset.isObject() ? json_asset.toObject()["input"] : json_asset;
+        if (!json_input.isString() || json_input.toString().isEmpty())
+        {
+            logError("Batch manifest asset {} has no input path", asset_idx);
+            return false;
+        }
+
+        const std::filesystem::path input = resolve(json_input, "");
+        std::filesystem::path relative = input.lexically_relative(input_root);
+        if (relative.empty() || *relative.begin() == "..")
+        {
+            relative = input.filename();
+        }
+
+        relative.replace_filename(relative.stem().string() + "_collision.usd");
+
+        BatchAsset asset;
+        asset.input = input.string();
+        asset.output = resolve(json_asset.toObject()["output"], output_dir / relative).string();
+        this->assets.push_back(asset);
+    }
+
+    logInfo("Batch manifest loaded -> {} ({} assets)", filepath, this->assets.size());
+    return true;
+}
+
+/// Process all assets of the loaded manifest that did not finish in a previous run.
+/// Returns process exit code, zero if every asset was processed successfully.
+int BatchRunner::run()
+{
+    if (!this->openCheckpoint())
+    {
+        return 2;
+    }
+
+    std::vector<size_t> pending;
+    for (size_t asset_idx=0; asset_idx < this->assets.size(); asset_idx++)
+    {
+        if (this->assets.at(asset_idx).status != "done")
+        {
+            pending.push_back(asset_idx);
+        }
+    }
+
+    logInfo(
+        "Batch processing {} assets, {} already finished in previous run",
+        pending.size(),
+        this->assets.size() - pending.size()
+    );
+
+    const auto start_time = std::chrono::steady_clock::now();
+    this->num_pending = pending.size();
+    this->num_finished = 0;
+    if (!pending.empty())
+    {
+        this->processAssets(pending);
+    }
+
+    const double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    this->checkpoint_file.close();
+
+    std::vector<size_t> order(this->assets.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+    {
+        return this->assets.at(a).total_duration > this->assets.at(b).total_duration;
+    });
+
+    for (size_t idx=0; idx < std::min(order.size(), NUM_SLOWEST_ASSETS); idx++)
+    {
+        const BatchAsset &asset = this->assets.at(order.at(idx));
+        logInfo(
+            "Slow asset {:.2f}s (load {:.2f}s, generate {:.2f}s, export {:.2f}s) -> {}",
+            asset.total_duration,
+            asset.load_duration,
+            asset.generate_duration,
+            asset.export_duration,
+            asset.input
+        );
+    }
+
+    const size_t num_failed = std::count_if(this->assets.begin(), this->assets.end(), [](const BatchAsset &asset)
+    {
+        return asset.status != "done";
+    });
+
+    this->writeSummary(duration);
+    logInfo("Batch finished in {:.2f}s, {} assets failed", duration, num_failed);
+    return num_failed > 0 ? 1 : 0;
+}
+
+/// Process given assets on this machine.
+/// Each asset runs its own collision generation, which parallelises over meshes of the
+/// asset. Limiting concurrent assets bounds number of models held in memory at once.
+/// @param: pending Indices of assets to process.
+void BatchRunner::processAssets(const std::vector<size_t> &pending)
+{
+    tbb::task_arena arena(this->parallel_assets > 0 ? this->parallel_assets : tbb::task_arena::automatic);
+    arena.execute([&]()
+    {
+        tbb::parallel_for(size_t(0), pending.size(), [&](size_t pending_idx)
+        {
+            const size_t asset_idx = pending.at(pending_idx);
+            BatchAsset result = this->assets.at(asset_idx);
+            this->processAsset(result);
+            this->finishAsset(asset_idx, result);
+        });
+    });
+}
+
+/// Load, generate collision for and export single asset.
+/// Failures are recorded in the asset status instead of interrupting the batch.
+/// @param: asset Asset to process, receives status and timings.
+void BatchRunner::processAsset(BatchAsset &asset) const
+{
+    const auto start_time = std::chrono::steady_clock::now();
+    auto elapsed = [](std::chrono::steady_clock::time_point since)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+    };
+
+    asset.status = "failed";
+    asset.error.clear();
+    asset.num_hulls = 0;
+    asset.num_degraded = 0;
+    asset.metrics = QJsonArray();
+
+    try
+    {
+        auto stage_time = std::chrono::steady_clock::now();
+        asset.content_hash = BatchRunner::hashFile(asset.input);
+        std::vector<Mesh> meshes;
+        ModelLoader::LoadUSD(asset.input, meshes);
+        asset.load_duration = elapsed(stage_time);
+        asset.num_meshes = meshes.size();
+
+        if (meshes.empty())
+        {
+            asset.error = "No meshes loaded from model file";
+            asset.total_duration = elapsed(start_time);
+            return;
+        }
+
+        stage_time = std::chrono::steady_clock::now();
+        CollisionGen collision_gen;
+        collision_gen.setCache(this->cache);
+        for (const Mesh &mesh : meshes)
+        {
+            collision_gen.addInputMesh(&mesh);
+        }
+
+        CollisionLODChain levels;
+        if (this->settings.lod_levels > 1)
+        {
+            collision_gen.generateLODChain(this->settings, levels);
+        }
+        else
+        {
+            levels.resize(1);
+            collision_gen.generate(this->settings, levels.front());
+        }
+
+        asset.generate_duration = elapsed(stage_time);
+        std::vector<std::vector<CollisionDegradation>> degradations = collision_gen.getMeshDegradations();
+        for (const std::vector<CollisionDegradation> &mesh_degradations : degradations)
+        {
+            asset.num_degraded += mesh_degradations.empty() ? 0 : 1;
+        }
+
+        /// Collision enveloping the whole scene has no per mesh metrics.
+        if (this->settings.compute_metrics &&
+            !CollisionGen::isSceneHull(this->settings) &&
+            levels.front().size() == meshes.size())
+        {
+            CollisionMetrics metrics;
+            std::vector<CollisionMetricsResult> results(meshes.size());
+            for (size_t mesh_idx=0; mesh_idx < meshes.size(); mesh_idx++)
+            {
+                results.at(mesh_idx) = metrics.evaluate(meshes.at(mesh_idx), levels.front().at(mesh_idx));
+                if (mesh_idx < degradations.size())
+                {
+                    results.at(mesh_idx).degradations = std::move(degradations.at(mesh_idx));
+                }
+
+                asset.metrics.append(CollisionMetrics::resultToJson(results.at(mesh_idx)));
+            }
+        }
+
+        stage_time = std::chrono::steady_clock::now();
+        std::vector<std::vector<const Mesh*>> export_levels(levels.size());
+        for (size_t level=0; level < levels.size(); level++)
+        {
+            for (const std::vector<std::unique_ptr<Mesh>> &hulls : levels.at(level))
+            {
+                for (const std::unique_ptr<Mesh> &hull : hulls)
+                {
+                    export_levels.at(level).push_back(hull.get());
+                }
+            }
+        }
+
+        asset.num_hulls = export_levels.empty() ? 0 : export_levels.front().size();
+
+        /// Output left behind by an interrupted run is replaced rather than appended to.
+        const std::filesystem::path output(asset.output);
+        std::filesystem::create_directories(output.parent_path());
+        std::filesystem::remove(output);
+        if (export_levels.size() > 1)
+        {
+            ModelLoader::SaveLODsUSD(asset.output, export_levels);
+        }
+        else
+        {
+            ModelLoader::SaveUSD(asset.output, export_levels.front());
+        }
+
+        asset.export_duration = elapsed(stage_time);
+        if (!std::filesystem::exists(output))
+        {
+            asset.error = "Failed to write collision model file";
+        }
+        else
+        {
+            asset.status = "done";
+        }
+    }
+    catch (const std::exception &err)
+    {
+        asset.error = err.what();
+    }
+
+    asset.total_duration = elapsed(start_time);
+}
+
+/// Store result of processed asset and append it to the checkpoint file.
+/// @param: asset_idx Index of the asset in the manifest.
+/// @param: result Processed asset.
+void BatchRunner::finishAsset(size_t asset_idx, const BatchAsset &result)
+{
+    const QByteArray line = QJsonDocument(BatchRunner::assetToJson(result)).toJson(QJsonDocument::Compact);
+    {
+        std::lock_guard<std::mutex> lock(this->checkpoint_mutex);
+        this->assets.at(asset_idx) = result;
+        this->checkpoint_file << line.toStdString() << std::endl;
+    }
+
+    const size_t count = ++this->num_finished;
+    if (result.status == "done")
+    {
+        logInfo("Batch [{}/{}] done in {:.2f}s -> {}", count, this->num_pending, result.total_duration, result.input);
+    }
+    else
+    {
+        logError("Batch [{}/{}] failed -> {}: {}", count, this->num_pending, result.input, result.error);
+    }
+}
+
+/// Restore assets finished by previous run from the checkpoint file and open it for appending.
+/// Checkpoint is a JSON object per line, the first line holds the settings of the run and each
+/// following line one processed asset. Checkpoint written with different settings is discarded,
+/// assets whose input file contents changed since they were processed are processed again.
+/// Returns true if the checkpoint file could be opened for writing.
+bool BatchRunner::openCheckpoint()
+{
+    const QJsonObject json_settings = CollisionMetrics::settingsToJson(this->settings);
+
+    bool resume = false;
+    std::ifstream input(this->checkpoint_path);
+    std::string line;
+    if (input && std::getline(input, line))
+    {
+        const QJsonObject json_header = QJsonDocument::fromJson(QByteArray::fromStdString(line)).object();
+        resume = json_header["settings"].toObject() == json_settings;
+        if (!resume)
+        {
+            logWarning("Batch checkpoint was written with different settings, starting over -> {}", this->checkpoint_path);
+        }
+    }
+
+    if (resume)
+    {
+        std::unordered_map<std::string, size_t> asset_indices;
+        for (size_t asset_idx=0; asset_idx < this->assets.size(); asset_idx++)
+        {
+            asset_indices.emplace(this->assets.at(asset_idx).input, asset_idx);
+        }
+
+        /// Later records override earlier ones, incomplete last line of an interrupted run
+        /// fails to parse and is skipped.
+        while (std::getline(input, line))
+        {
+            const QJsonObject json_asset = QJsonDocument::fromJson(QByteArray::fromStdString(line)).object();
+            auto it = asset_indices.find(json_asset["input"].toString().toStdString());
+            if (it != asset_indices.end())
+            {
+                BatchRunner::assetFromJson(json_asset, this->assets.at(it->second));
+            }
+        }
+
+        tbb::parallel_for(size_t(0), this->assets.size(), [&](size_t asset_idx)
+        {
+            BatchAsset &asset = this->assets.at(asset_idx);
+            if (asset.status == "done" && (
+                !std::filesystem::exists(asset.output) ||
+                BatchRunner::hashFile(asset.input) != asset.content_hash))
+            {
+                asset.status = "pending";
+            }
+        });
+    }
+
+    input.close();
+
+    const std::filesystem::path checkpoint(this->checkpoint_path);
+    std::filesystem::create_directories(checkpoint.parent_path());
+    this->checkpoint_file.open(checkpoint, resume ? std::ios::app : std::ios::trunc);
+    if (!this->checkpoint_file)
+    {
+        logError("Failed to open batch checkpoint for writing -> {}", this->checkpoint_path);
+        return false;
+    }
+
+    if (!resume)
+    {
+        QJsonObject json_header;
+        json_header["settings"] = json_settings;
+        this->checkpoint_file << QJsonDocument(json_header).toJson(QJsonDocument::Compact).toStdString() << std::endl;
+    }
+
+    return true;
+}
+
+/// Write JSON summary of the batch with status and timings of each asset in manifest order.
+/// @param: duration Time spent processing the batch in this run in seconds.
+/// Returns true if the summary was written.
+bool BatchRunner::writeSummary(double duration) const
+{
+    QJsonArray json_assets;
+    size_t num_done = 0;
+    for (const BatchAsset &asset : this->assets)
+    {
+        json_assets.append(BatchRunner::assetToJson(asset));
+        num_done += asset.status == "done" ? 1 : 0;
+    }
+
+    QJsonObject json_summary;
+    json_summary["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    json_summary["duration"] = duration;
+    json_summary["num_assets"] = qint64(this->assets.size());
+    json_summary["num_done"] = qint64(num_done);
+    json_summary["num_failed"] = qint64(this->assets.size() - num_done);
+    json_summary["settings"] = CollisionMetrics::settingsToJson(this->settings);
+    json_summary["assets"] = json_assets;
+
+    QFile file(QString::fromStdString(this->summary_path));
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+    {
+        logError("Failed to open batch summary for writing -> {}", this->summary_path);
+        return false;
+    }
+
+    file.write(QJsonDocument(json_summary).toJson(QJsonDocument::Indented));
+    logInfo("Batch summary written -> {}", this->summary_path);
+    return true;
+}
+
+/// Convert asset record to JSON object.
+/// @param: asset Asset to convert.
+/// Returns JSON object holding paths, status and timings of the asset.
+QJsonObject BatchRunner::assetToJson(const BatchAsset &asset)
+{
+    QJsonObject json_asset;
+    json_asset["input"] = QString::fromStdString(asset.input);
+    json_asset["output"] = QString::fromStdString(asset.output);
+    json_asset["status"] = QString::fromStdString(asset.status);
+    json_asset["error"] = QString::fromStdString(asset.error);
+    json_asset["content_hash"] = QString::number(asset.content_hash, 16);
+    json_asset["num_meshes"] = qint64(asset.num_meshes);
+    json_asset["num_hulls"] = qint64(asset.num_hulls);
+    json_asset["num_degraded"] = qint64(asset.num_degraded);
+    json_asset["load_duration"] = asset.load_duration;
+    json_asset["generate_duration"] = asset.generate_duration;
+    json_asset["export_duration"] = asset.export_duration;
+    json_asset["total_duration"] = asset.total_duration;
+    json_asset["metrics"] = asset.metrics;
+
+    return json_asset;
+}
+
+/// Restore asset record from JSON object, input and output paths are kept from the manifest.
+/// @param: json Object written by assetToJson.
+/// @param: asset Asset to receive status and timings.
+void BatchRunner::assetFromJson(const QJsonObject &json, BatchAsset &asset)
+{
+    asset.status = json["status"].toString().toStdString();
+    asset.error = json["error"].toString().toStdString();
+    asset.content_hash = json["content_hash"].toString().toULongLong(nullptr, 16);
+    asset.num_meshes = json["num_meshes"].toInteger();
+    asset.num_hulls = json["num_hulls"].toInteger();
+    asset.num_degraded = json["num_degraded"].toInteger();
+    asset.load_duration = json["load_duration"].toDouble();
+    asset.generate_duration = json["generate_duration"].toDouble();
+    asset.export_duration = json["export_duration"].toDouble();
+    asset.total_duration = json["total_duration"].toDouble();
+    asset.metrics = json["metrics"].toArray();
+}
+
+/// Compute hash of file contents on disk.
+/// Only the file itself is hashed, changes to layers it references are not detected.
+/// @param: filepath Location of the file on disk.
+/// Returns hash of the file contents or zero if the file could not be read.
+uint64_t BatchRunner::hashFile(const std::string &filepath)
+{
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file)
+    {
+        return 0;
+    }
+
+    uint64_t hash = Hashing::OFFSET_BASIS;
+    std::vector<char> chunk(HASH_CHUNK_SIZE);
+    while (file)
+    {
+        file.read(chunk.data(), chunk.size());
+        hash = Hashing::hashBytes(hash, chunk.data(), file.gcount());
+    }
+
+    return hash;
+}
+
+/// Settings used for batch assets unless overridden by the manifest.
+/// Matches defaults of the application property panel.
+CollisionGenSettings BatchRunner::getDefaultSettings()
+{
+    CollisionGenSettings settings;
+    settings.technique = CollisionTechnique::ApproximateDecomposition;
+    settings.hull_per_mesh = true;
+    settings.hull_padding = 0.0;
+    settings.scale = 1.0;
+    settings.primitive_tolerance = 0.25;
+    settings.voxel_resolution = 32;
+    settings.max_boxes = 32;
+    settings.oriented_boxes = false;
+    settings.exact_time_budget = 30.0;
+    settings.exact_max_pieces = 64;
+    settings.mode = 0;
+    settings.resolution = 100000;
+    settings.depth_planes = 20;
+    settings.concavity = 0.0025;
+    settings.max_hulls = 16;
+    settings.max_hull_vertices = 64;
+    settings.min_hull_volume = 0.0001;
+    settings.downsample = 1;
+    settings.worker_threads = 0;
+    settings.cleanup_mode = MeshCleanupMode::ExactCleanup;
+    settings.wrap_alpha = 2.0;
+    settings.wrap_offset = 0.5;
+    settings.decimate = false;
+    settings.merge_threshold = 0.0;
+    settings.strict_vertex_limit = false;
+    settings.compute_metrics = false;
+    settings.lod_levels = 1;
+    settings.lod_ratio = 0.5;
+    settings.dedupe_instances = false;
+    settings.mesh_time_budget = 0.0;
+    settings.mesh_memory_budget = 0.0;
+    settings.worker_processes = false;
+    return settings;
+}
+
+/// Override collision generation settings from JSON object keyed by setting names, the same
+/// names used by collision metrics reports. Technique and cleanup mode accept either their
+/// numeric value or name. Numeric settings are limited to the ranges the property panel allows.
+/// @param: json Object holding settings to override.
+/// @param: settings Settings to update.
+/// Returns false if the object holds unknown settings, values of wrong type or out of range.
+bool BatchRunner::readSettings(const QJsonObject &json, CollisionGenSettings &settings)
+{
+    struct DoubleSetting
+    {
+        double CollisionGenSettings::*member;
+        double min;
+        double max;
+    };
+
+    struct IntSetting
+    {
+        int CollisionGenSettings::*member;
+        int min;
+        int max;
+    };
+
+    static const std::unordered_map<std::string, DoubleSetting> double_settings = {
+        {"scale", {&CollisionGenSettings::scale, 0.01, 2.0}},
+        {"resolution", {&CollisionGenSettings::resolution, 10000.0, 64000000.0}},
+        {"min_hull_volume", {&CollisionGenSettings::min_hull_volume, 0.0, 0.01}},
+        {"concavity", {&CollisionGenSettings::concavity, 0.0, 1.0}},
+        {"hull_padding", {&CollisionGenSettings::hull_padding, 0.0, 0.5}},
+        {"exact_time_budget", {&CollisionGenSettings::exact_time_budget, 0.1, 3600.0}},
+        {"merge_threshold", {&CollisionGenSettings::merge_threshold, 0.0, 1.0}},
+        {"primitive_tolerance", {&CollisionGenSettings::primitive_tolerance, 0.0, 1.0}},
+        {"lod_ratio", {&CollisionGenSettings::lod_ratio, 0.05, 0.95}},
+        {"wrap_alpha", {&CollisionGenSettings::wrap_alpha, 0.1, 100.0}},
+        {"wrap_offset", {&CollisionGenSettings::wrap_offset, 0.01, 10.0}},
+        {"mesh_time_budget", {&CollisionGenSettings::mesh_time_budget, 0.0, 86400.0}},
+        {"mesh_memory_budget", {&CollisionGenSettings::mesh_memory_budget, 0.0, 1048576.0}}
+    };
+
+    static const std::unordered_map<std::string, IntSetting> int_settings = {
+        {"max_hulls", {&CollisionGenSettings::max_hulls, 1, 255}},
+        {"max_hull_vertices", {&CollisionGenSettings::max_hull_vertices, 4, 1024}},
+        {"downsample", {&CollisionGenSettings::downsample, 1, 16}},
+        {"depth_planes", {&CollisionGenSettings::depth_planes, 1, 32}},
+        {"mode", {&CollisionGenSettings::mode, 0, 1}},
+        {"worker_threads", {&CollisionGenSettings::worker_threads, 0, 256}},
+        {"exact_max_pieces", {&CollisionGenSettings::exact_max_pieces, 1, 1024}},
+        {"voxel_resolution", {&CollisionGenSettings::voxel_resolution, 2, 256}},
+        {"max_boxes", {&CollisionGenSettings::max_boxes, 1, 1024}},
+        {"lod_levels", {&CollisionGenSettings::lod_levels, 1, 8}}
+    };
+
+    static const std::unordered_map<std::string, bool CollisionGenSettings::*> bool_settings = {
+        {"hull_per_mesh", &CollisionGenSettings::hull_per_mesh},
+        {"decimate", &CollisionGenSettings::decimate},
+        {"strict_vertex_limit", &CollisionGenSettings::strict_vertex_limit},
+        {"compute_metrics", &CollisionGenSettings::compute_metrics},
+        {"oriented_boxes", &CollisionGenSettings::oriented_boxes},
+        {"dedupe_instances", &CollisionGenSettings::dedupe_instances},
+        {"worker_processes", &CollisionGenSettings::worker_processes}
+    };
+
+    static const std::unordered_map<std::string, std::unordered_map<std::string, int>> named_settings = {
+        {"technique", {
+            {"simple_hull", CollisionTechnique::SimpleHull},
+            {"exact_decomposition", CollisionTechnique::ExactDecomposition},
+            {"approximate_decomposition", CollisionTechnique::ApproximateDecomposition},
+            {"primitive_fit", CollisionTechnique::PrimitiveFit},
+            {"voxel_boxes", CollisionTechnique::VoxelBoxes}
+        }},
+        {"cleanup_mode", {
+            {"exact", MeshCleanupMode::ExactCleanup},
+            {"fast", MeshCleanupMode::FastCleanup},
+            {"alpha_wrap", MeshCleanupMode::AlphaWrapCleanup}
+        }}
+    };
+
+    for (auto it = json.begin(); it != json.end(); it++)
+    {
+        const std::string key = it.key().toStdString();
+        const QJsonValue value = it.value();
+
+        auto double_it = double_settings.find(key);
+        auto int_it = int_settings.find(key);
+        auto bool_it = bool_settings.find(key);
+        auto named_it = named_settings.find(key);
+        if (double_it != double_settings.end() && value.isDouble())
+        {
+            const DoubleSetting &setting = double_it->second;
+            const double number = value.toDouble();
+            if (!(number >= setting.min && number <= setting.max))
+            {
+                logError("Batch setting {} = {} is outside of range {} to {}", key, number, setting.min, setting.max);
+                return false;
+            }
+
+            settings.*(setting.member) = number;
+        }
+        else if (int_it != int_settings.end() && value.isDouble())
+        {
+            const IntSetting &setting = int_it->second;
+            const double number = value.toDouble();
+            if (number != std::floor(number) || number < setting.min || number > setting.max)
+            {
+                logError("Batch setting {} = {} is not an integer in range {} to {}", key, number, setting.min, setting.max);
+                return false;
+            }
+
+            settings.*(setting.member) = static_cast<int>(number);
+        }
+        else if (bool_it != bool_settings.end() && value.isBool())
+        {
+            settings.*(bool_it->second) = value.toBool();
+        }
+        else if (named_it != named_settings.end() && value.isDouble())
+        {
+            const double number = value.toDouble();
+            const bool known = std::any_of(named_it->second.begin(), named_it->second.end(), [number](const auto &named)
+            {
+                return named.second == number;
+            });
+
+            if (!known)
+            {
+                logError("Batch setting {} = {} is not a known value", key, number);
+                return false;
+            }
+
+            (key == "technique" ? settings.technique : settings.cleanup_mode) = static_cast<int>(number);
+        }
+        else if (named_it != named_settings.end() && named_it->second.contains(value.toString().toStdString()))
+        {
+            const int named_value = named_it->second.at(value.toString().toStdString());
+            (key == "technique" ? settings.technique : settings.cleanup_mode) = named_value;
+        }
+        else
+        {
+            logError("Invalid batch setting -> {}", key);
+            return false;
+        }
+    }
+
+    return true;
+}
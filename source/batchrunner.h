@@ -0,0 +1,88 @@
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include "collisioncache.h"
+#include "collisiongen.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <QJsonArray>
+#include <QJsonObject>
+
+
+/// Single model file of a batch manifest along with outcome of its processing.
+struct BatchAsset
+{
+    std::string input;
+    std::string output;
+
+    /// One of "pending", "done" or "failed".
+    std::string status = "pending";
+    std::string error;
+
+    /// Hash of the input file contents the asset was processed from.
+    uint64_t content_hash = 0;
+
+    size_t  num_meshes = 0;
+    size_t  num_hulls = 0;
+    size_t  num_degraded = 0;
+
+    /// Time spent in each processing stage in seconds.
+    double  load_duration = 0.0;
+    double  generate_duration = 0.0;
+    double  export_duration = 0.0;
+    double  total_duration = 0.0;
+
+    /// Collision metrics of each mesh, only measured when enabled by settings.
+    QJsonArray metrics;
+};
+
+
+/// Headless collision generation for list of model files described by JSON manifest.
+/// Assets are processed in parallel without any UI or graphics context. Each finished asset is
+/// appended to a checkpoint file, so an interrupted run resumes where it stopped.
+class BatchRunner
+{
+public:
+    BatchRunner(std::shared_ptr<CollisionCache> cache);
+    virtual ~BatchRunner() = default;
+
+    bool loadManifest(const std::string &filepath);
+    int run();
+
+    static CollisionGenSettings getDefaultSettings();
+    static bool readSettings(const QJsonObject &json, CollisionGenSettings &settings);
+    static uint64_t hashFile(const std::string &filepath);
+
+protected:
+    virtual void processAssets(const std::vector<size_t> &pending);
+    void processAsset(BatchAsset &asset) const;
+    void finishAsset(size_t asset_idx, const BatchAsset &result);
+    bool openCheckpoint();
+    bool writeSummary(double duration) const;
+
+    static QJsonObject assetToJson(const BatchAsset &asset);
+    static void assetFromJson(const QJsonObject &json, BatchAsset &asset);
+
+    std::shared_ptr<CollisionCache> cache;
+    CollisionGenSettings settings;
+    QJsonObject manifest;
+    std::vector<BatchAsset> assets;
+
+private:
+    std::string checkpoint_path;
+    std::string summary_path;
+    int parallel_assets;
+    size_t num_pending;
+    std::atomic<size_t> num_finished;
+    std::ofstream checkpoint_file;
+    std::mutex checkpoint_mutex;
+};
+
+#endif
@@ -0,0 +1,319 @@
+#include "collisioncache.h"
+#include "logging.h"
+#include "mesh.h"
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <span>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+/// Cache entry file layout version, bump when the layout changes.
+static const uint32_t CACHE_MAGIC = 0x48434343; // "CCCH"
+static const uint32_t CACHE_VERSION = 3;
+
+
+/// Get identifier of this process.
+static int getProcessId()
+{
+#if defined(_WIN32)
+    return _getpid();
+#else
+    return int(getpid());
+#endif
+}
+
+
+/// Create collision cache stored in given directory.
+/// @param: directory Location on disk to store cache entries in.
+/// @param: max_size Maximum size of all cache entries in bytes.
+CollisionCache::CollisionCache(const std::string &directory, uint64_t max_size) :
+    directory(directory),
+    max_size(max_size)
+{
+    std::error_code err;
+    std::filesystem::create_directories(this->directory, err);
+    if (err)
+    {
+        logWarning("Failed to create collision cache directory -> {}", this->directory);
+    }
+}
+
+/// Get location of the cache on disk.
+const std::string& CollisionCache::getDirectory() const
+{
+    return this->directory;
+}
+
+/// Get maximum size of the cache in bytes.
+uint64_t CollisionCache::getMaxSize() const
+{
+    return this->max_size;
+}
+
+/// Get location of cache entry file for given key.
+std::filesystem::path CollisionCache::getEntryPath(uint64_t key) const
+{
+    return std::filesystem::path(this->directory) / std::format("{:016x}.bin", key);
+}
+
+/// Load cached meshes stored under given key.
+/// Successful load marks the entry as most recently used, malformed entries are removed.
+/// @param: key Cache entry key.
+/// @param: out_meshes List to add loaded meshes to.
+bool CollisionCache::load(uint64_t key, std::vector<std::unique_ptr<Mesh>> &out_meshes)
+{
+    const std::filesystem::path path = this->getEntryPath(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint64_t entry_key = 0;
+    uint32_t num_meshes = 0;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&entry_key), sizeof(entry_key));
+    file.read(reinterpret_cast<char*>(&num_meshes), sizeof(num_meshes));
+    if (!file || magic != CACHE_MAGIC || version != CACHE_VERSION)
+    {
+        logWarning("Ignoring incompatible collision cache entry -> {}", path.string());
+        return false;
+    }
+
+    /// Malformed entries are removed, so they are regenerated instead of failing every load.
+    auto evict_entry = [&file, &path](const char *reason)
+    {
+        logWarning("Evicting {} collision cache entry -> {}", reason, path.string());
+        file.close();
+
+        std::error_code err;
+        std::filesystem::remove(path, err);
+        return false;
+    };
+
+    /// Stored key guards against entries renamed or copied under the wrong name.
+    if (entry_key != key)
+    {
+        return evict_entry("mismatched");
+    }
+
+    /// Sizes read from disk are checked against the remaining file size before anything is
+    /// allocated and indices against the vertex count, like results of worker processes.
+    std::error_code size_err;
+    const uint64_t file_size = std::filesystem::file_size(path, size_err);
+    const uint64_t header_size = sizeof(magic) + sizeof(version) + sizeof(entry_key) + sizeof(num_meshes);
+    const uint64_t mesh_header_size = 2 * sizeof(uint32_t) + sizeof(MeshPrimitive);
+    if (size_err || file_size < header_size || num_meshes > (file_size - header_size) / mesh_header_size)
+    {
+        return evict_entry("truncated");
+    }
+
+    uint64_t remaining = file_size - header_size;
+    std::vector<std::unique_ptr<Mesh>> meshes;
+    meshes.reserve(num_meshes);
+    for (uint32_t i=0; i < num_meshes; i++)
+    {
+        uint32_t num_vertices = 0;
+        uint32_t num_indices = 0;
+        file.read(reinterpret_cast<char*>(&num_vertices), sizeof(num_vertices));
+        file.read(reinterpret_cast<char*>(&num_indices), sizeof(num_indices));
+        const uint64_t mesh_size = mesh_header_size +
+            uint64_t(num_vertices) * sizeof(QVector3D) +
+            uint64_t(num_indices) * sizeof(int);
+        if (!file || mesh_size > remaining)
+        {
+            return evict_entry("truncated");
+        }
+
+        if (num_indices % 3 != 0)
+        {
+            return evict_entry("malformed");
+        }
+
+        remaining -= mesh_size;
+
+        /// Positions are stored as interleaved xyz floats matching QVector3D layout.
+        std::vector<QVector3D> vertices(num_vertices);
+        std::vector<int> indices(num_indices);
+        MeshPrimitive primitive;
+        file.read(reinterpret_cast<char*>(vertices.data()), vertices.size() * sizeof(QVector3D));
+        file.read(reinterpret_cast<char*>(indices.data()), indices.size() * sizeof(int));
+        file.read(reinterpret_cast<char*>(&primitive), sizeof(MeshPrimitive));
+        if (!file)
+        {
+            return evict_entry("truncated");
+        }
+
+        const bool valid_indices = std::all_of(indices.begin(), indices.end(), [num_vertices](int index)
+        {
+            return index >= 0 && uint32_t(index) < num_vertices;
+        });
+
+        if (!valid_indices)
+        {
+            return evict_entry("malformed");
+        }
+
+        meshes.push_back(std::make_unique<Mesh>(vertices, indices));
+        meshes.back()->generateNormals();
+        meshes.back()->computeBounds();
+        meshes.back()->setPrimitive(primitive);
+    }
+
+    /// Entry modification time doubles as its last access time for LRU eviction.
+    std::error_code err;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), err);
+
+    for (std::unique_ptr<Mesh> &mesh : meshes)
+    {
+        out_meshes.push_back(std::move(mesh));
+    }
+
+    return true;
+}
+
+/// Store meshes in the cache under given key, replacing any existing entry.
+/// @param: key Cache entry key.
+/// @param: meshes Meshes to store.
+void CollisionCache::store(uint64_t key, const std::vector<std::unique_ptr<Mesh>> &meshes)
+{
+    const std::filesystem::path path = this->getEntryPath(key);
+
+    /// Write to unique temporary file first so readers never see partially written entry.
+    /// Process identifier keeps names unique between batch nodes sharing the cache directory.
+    const size_t thread_id = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    std::filesystem::path tmp_path = path;
+    tmp_path += std::format(".{}.{:x}.tmp", getProcessId(), thread_id);
+
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            logWarning("Failed to write collision cache entry -> {}", tmp_path.string());
+            return;
+        }
+
+        const uint32_t num_meshes = meshes.size();
+        file.write(reinterpret_cast<const char*>(&CACHE_MAGIC), sizeof(CACHE_MAGIC));
+        file.write(reinterpret_cast<const char*>(&CACHE_VERSION), sizeof(CACHE_VERSION));
+        file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+        file.write(reinterpret_cast<const char*>(&num_meshes), sizeof(num_meshes));
+
+        for (const std::unique_ptr<Mesh> &mesh : meshes)
+        {
+            const uint32_t num_vertices = mesh->numVertices();
+            const uint32_t num_indices = mesh->numIndices();
+            file.write(reinterpret_cast<const char*>(&num_vertices), sizeof(num_vertices));
+            file.write(reinterpret_cast<const char*>(&num_indices), sizeof(num_indices));
+
+            const std::span<const float> positions = mesh->getPositionData();
+            file.write(reinterpret_cast<const char*>(positions.data()), positions.size_bytes());
+            file.write(reinterpret_cast<const char*>(mesh->getIndices().data()), mesh->getIndices().size_bytes());
+            file.write(reinterpret_cast<const char*>(&mesh->getPrimitive()), sizeof(MeshPrimitive));
+        }
+
+        if (!file)
+        {
+            logWarning("Failed to write collision cache entry -> {}", tmp_path.string());
+            file.close();
+            std::error_code err;
+            std::filesystem::remove(tmp_path, err);
+            return;
+        }
+    }
+
+    std::error_code err;
+    std::filesystem::rename(tmp_path, path, err);
+    if (err)
+    {
+        logWarning("Failed to commit collision cache entry -> {}", path.string());
+        std::filesystem::remove(tmp_path, err);
+    }
+}
+
+/// Remove least recently used entries until the cache fits its size limit.
+void CollisionCache::evict()
+{
+    std::lock_guard<std::mutex> lock(this->evict_mutex);
+
+    struct Entry
+    {
+        std::filesystem::path path;
+        std::filesystem::file_time_type time;
+        uint64_t size;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t total_size = 0;
+
+    std::error_code err;
+    for (const auto &item : std::filesystem::directory_iterator(this->directory, err))
+    {
+        if (!item.is_regular_file() || item.path().extension() != ".bin")
+        {
+            continue;
+        }
+
+        Entry entry;
+        entry.path = item.path();
+        entry.time = item.last_write_time(err);
+        entry.size = item.file_size(err);
+        total_size += entry.size;
+        entries.push_back(entry);
+    }
+
+    if (total_size <= this->max_size)
+    {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b)
+    {
+        return a.time < b.time;
+    });
+
+    size_t num_removed = 0;
+    for (const Entry &entry : entries)
+    {
+        if (total_size <= this->max_size)
+        {
+            break;
+        }
+
+        if (std::filesystem::remove(entry.path, err))
+        {
+            total_size -= entry.size;
+            num_removed++;
+        }
+    }
+
+    logDebug("Evicted {} collision cache entries, cache size is now {} bytes", num_removed, total_size);
+}
+
+/// Remove all entries from the cache.
+void CollisionCache::clear()
+{
+    std::lock_guard<std::mutex> lock(this->evict_mutex);
+
+    std::error_code err;
+    for (const auto &item : std::filesystem::directory_iterator(this->directory, err))
+    {
+        if (item.is_regular_file() && item.path().extension() == ".bin")
+        {
+            std::filesystem::remove(item.path(), err);
+        }
+    }
+}
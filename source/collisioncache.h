@@ -0,0 +1,35 @@
+#ifndef COLLISION_CACHE_H
+#define COLLISION_CACHE_H
+
+#include "mesh.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+class CollisionCache
+{
+public:
+    CollisionCache(const std::string &directory, uint64_t max_size);
+
+    bool load(uint64_t key, std::vector<std::unique_ptr<Mesh>> &out_meshes);
+    void store(uint64_t key, const std::vector<std::unique_ptr<Mesh>> &meshes);
+    void evict();
+    void clear();
+
+    const std::string& getDirectory() const;
+    uint64_t getMaxSize() const;
+
+private:
+    std::filesystem::path getEntryPath(uint64_t key) const;
+
+    std::string directory;
+    uint64_t max_size;
+    std::mutex evict_mutex;
+};
+
+#endif
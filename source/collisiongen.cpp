@@ -1,162 +1,3145 @@
 #include "collisiongen.h"
+#include "collisioncache.h"
+#include "collisioninstances.h"
+#include "collisionprimitives.h"
+#include "collisionvoxelizer.h"
+#include "collisionworker.h"
+#include "hashing.h"
 #include "VHACD.h"
 #include "logging.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <numbers>
+#include <numeric>
+#include <queue>
+#include <span>
 #include <unordered_map>
 #include <vector>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/parallel_sort.h>
+#include <tbb/task_arena.h>
+
+#include <CGAL/alpha_wrap_3.h>
 #include <CGAL/Polygon_mesh_processing/triangulate_faces.h>
 #include <CGAL/Polygon_mesh_processing/triangulate_hole.h>
 #include <CGAL/Polygon_mesh_processing/stitch_borders.h>
 #include <CGAL/Polygon_mesh_processing/orient_polygon_soup.h>
 #include <CGAL/Polygon_mesh_processing/polygon_soup_to_polygon_mesh.h>
+#include <CGAL/Polygon_mesh_processing/repair_polygon_soup.h>
+#include <CGAL/Polygon_mesh_processing/repair_degeneracies.h>
+#include <CGAL/Polygon_mesh_processing/manifoldness.h>
+#include <CGAL/Polygon_mesh_processing/orientation.h>
+#include <CGAL/Polygon_mesh_processing/border.h>
+#include <CGAL/Polygon_mesh_processing/connected_components.h>
+#include <CGAL/Polygon_mesh_processing/self_intersections.h>
+#include <CGAL/Surface_mesh_simplification/edge_collapse.h>
+#include <CGAL/Surface_mesh_simplification/Policies/Edge_collapse/GarlandHeckbert_plane_policies.h>
 #include <CGAL/convex_hull_3.h>
+#include <CGAL/Convex_hull_3/dual/halfspace_intersection_3.h>
 #include <CGAL/convex_decomposition_3.h>
 
+#if defined(__APPLE__)
+#include <libproc.h>
+#include <mach/mach.h>
+#elif defined(__linux__)
+#include <fstream>
+#include <unistd.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+/// Version of the generated collision, bump when output of any technique changes
+/// so stale collision cache entries are not reused.
+static const uint32_t COLLISION_GEN_VERSION = 3;
+
+/// Vertex weld distance relative to mesh bounding box diagonal.
+static const float WELD_TOLERANCE = 1e-6f;
+
+/// Minimum triangle area relative to squared mesh bounding box diagonal, area of a triangle
+/// with legs of the weld tolerance. Matches threshold used by Mesh::isValid.
+static const float DEGENERATE_AREA = 1e-12f;
+
+/// Maximum angle in degrees between normals of hull faces merged into single plane.
+static const double COPLANAR_ANGLE = 1.0;
+
+/// Maximum distance between hull faces merged into single plane relative to hull radius.
+static const double COPLANAR_DISTANCE = 1e-3;
+
+/// Maximum decimation error relative to the decomposition voxel size.
+static const double DECIMATION_VOXEL_ERROR = 0.5;
+
+/// Lowest voxel resolution voxel boxes are coarsened to when meeting the box limit.
+static const int MIN_VOXEL_RESOLUTION = 2;
+
+/// Factor voxel resolution is scaled by while the box limit is exceeded.
+static const double VOXEL_COARSEN_FACTOR = 0.75;
+
+/// Maximum vertex distance between instances of the same mesh relative to mesh radius.
+static const double INSTANCE_TOLERANCE = 1e-4;
+
+/// Number of times decomposition exceeding its budget is retried at lower resolution.
+static const int MAX_BUDGET_RETRIES = 2;
+
+/// Factor decomposition resolution is scaled by on each retry after exceeding the budget.
+static const double BUDGET_RESOLUTION_FACTOR = 0.25;
+
+/// Maximum number of exact decomposition pieces relative to the piece limit which are extracted
+/// and merged down to the limit, more fragmented decompositions fall back to component hulls.
+static const size_t EXACT_PIECE_FACTOR = 16;
+
+/// Bounds of hulls considered for merging are expanded by this fraction of their diagonal.
+static const float MERGE_BOUNDS_MARGIN = 0.05f;
+
+/// Number of nearest hulls with disjoint bounds each hull is also considered for merging with.
+static const size_t MERGE_NEAREST_HULLS = 4;
+
+/// Smallest volume merge costs are relative to, as fraction of the cubed merged hull diameter,
+/// so flat hulls without volume of their own can still be merged.
+static const double MIN_MERGE_VOLUME = 1e-3;
+
+/// Lowest resolution decomposition is retried at, lower resolutions fall back to convex hulls.
+static const double MIN_BUDGET_RESOLUTION = 10000.0;
+
+/// Budget limit which was exceeded, see CollisionBudget.
+static const int BUDGET_TIME_EXCEEDED = 1;
+static const int BUDGET_MEMORY_EXCEEDED = 2;
+
+
+/// Start budget of generating collision for single mesh.
+/// @param: time_budget Maximum wall-clock time in seconds, zero for no limit.
+/// @param: memory_budget Maximum growth of resident memory in megabytes, zero for no limit.
+CollisionBudget::CollisionBudget(double time_budget, double memory_budget) :
+    start_time(std::chrono::steady_clock::now()),
+    time_budget(time_budget),
+    memory_budget(size_t(std::max(memory_budget, 0.0) * 1024.0 * 1024.0)),
+    memory_baseline(memory_budget > 0.0 ? CollisionBudget::getResidentMemory() : 0),
+    peak_memory(0),
+    exceeded(0)
+{
+}
+
+/// Check elapsed time and memory growth against the budget, safe to call from multiple threads.
+/// @param: external_memory Resident memory in bytes of helper processes working for this budget,
+/// counted on top of growth of this process.
+/// Returns true once the budget was exceeded, later calls keep returning true.
+bool CollisionBudget::check(size_t external_memory)
+{
+    if (this->exceeded != 0)
+    {
+        return true;
+    }
+
+    if (this->time_budget > 0.0 && this->getElapsed() > this->time_budget)
+    {
+        this->exceeded = BUDGET_TIME_EXCEEDED;
+        return true;
+    }
+
+    if (this->memory_budget > 0)
+    {
+        const size_t resident = CollisionBudget::getResidentMemory();
+        const size_t growth = (resident > this->memory_baseline ? resident - this->memory_baseline : 0) + external_memory;
+
+        size_t peak = this->peak_memory;
+        while (growth > peak && !this->peak_memory.compare_exchange_weak(peak, growth))
+        {
+        }
+
+        if (growth > this->memory_budget)
+        {
+            this->exceeded = BUDGET_MEMORY_EXCEEDED;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// Get value indicating if any limit of the budget was exceeded.
+bool CollisionBudget::isExceeded() const
+{
+    return this->exceeded != 0;
+}
+
+/// Get name of the exceeded limit or empty string if the budget was not exceeded.
+std::string CollisionBudget::getReason() const
+{
+    switch (this->exceeded)
+    {
+        case BUDGET_TIME_EXCEEDED:
+            return "time";
+        case BUDGET_MEMORY_EXCEEDED:
+            return "memory";
+        default:
+            return "";
+    }
+}
+
+/// Get seconds elapsed since the budget started.
+double CollisionBudget::getElapsed() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - this->start_time).count();
+}
+
+/// Get largest resident memory growth in bytes observed by memory checks.
+size_t CollisionBudget::getPeakMemory() const
+{
+    return this->peak_memory;
+}
+
+/// Get resident memory of given process in bytes, zero if it cannot be determined.
+/// @param: process_id Identifier of the process to measure, zero for this process.
+size_t CollisionBudget::getResidentMemory(int process_id)
+{
+#if defined(__APPLE__)
+    if (process_id != 0)
+    {
+        proc_taskinfo info;
+        if (proc_pidinfo(process_id, PROC_PIDTASKINFO, 0, &info, sizeof(info)) == int(sizeof(info)))
+        {
+            return info.pti_resident_size;
+        }
+
+        return 0;
+    }
+
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS)
+    {
+        return info.resident_size;
+    }
+
+#elif defined(__linux__)
+    std::ifstream statm(process_id != 0 ? "/proc/" + std::to_string(process_id) + "/statm" : std::string("/proc/self/statm"));
+    size_t total_pages = 0;
+    size_t resident_pages = 0;
+    if (statm >> total_pages >> resident_pages)
+    {
+        return resident_pages * size_t(sysconf(_SC_PAGESIZE));
+    }
+
+#elif defined(_WIN32)
+    HANDLE process = process_id != 0
+        ? OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, DWORD(process_id))
+        : GetCurrentProcess();
+
+    PROCESS_MEMORY_COUNTERS counters;
+    const bool measured = process && GetProcessMemoryInfo(process, &counters, sizeof(counters));
+    if (process && process_id != 0)
+    {
+        CloseHandle(process);
+    }
+
+    if (measured)
+    {
+        return counters.WorkingSetSize;
+    }
+#endif
+
+    return 0;
+}
+
+
+CollisionGen::CollisionGen() :
+    cancelled(false),
+    vhacd_pool(nullptr)
+{
+}
+
+CollisionGen::~CollisionGen()
+{
+    for (VHACD::IVHACD *vhacd : this->vhacd_pool)
+    {
+        if (vhacd)
+        {
+            vhacd->Release();
+        }
+    }
+}
+
+/// Adds new mesh to use as input for collision generation process.
+void CollisionGen::addInputMesh(const Mesh *mesh)
+{
+    this->input_meshes.push_back(mesh);
+}
+
+/// Remove all input meshes.
+void CollisionGen::clearInputMeshes()
+{
+    this->input_meshes.clear();
+}
+
+/// Set function to receive progress updates during collision generation.
+/// Note that callback is invoked from whichever thread runs the generation.
+void CollisionGen::setProgressCallback(const CollisionProgressCallback &callback)
+{
+    this->progress_callback = callback;
+}
+
+/// Request any running collision generation to stop as soon as possible.
+/// Safe to call from any thread, meshes not yet processed are skipped.
+void CollisionGen::cancel()
+{
+    this->cancelled = true;
+
+    std::lock_guard<std::mutex> lock(this->vhacd_mutex);
+    for (VHACD::IVHACD *vhacd : this->active_vhacd)
+    {
+        vhacd->Cancel();
+    }
+}
+
+/// Get value indicating if collision generation has been cancelled.
+bool CollisionGen::isCancelled() const
+{
+    return this->cancelled;
+}
+
+/// Get budget degradations of each input mesh recorded during the last generation.
+std::vector<std::vector<CollisionDegradation>> CollisionGen::getMeshDegradations() const
+{
+    std::lock_guard<std::mutex> lock(this->degradation_mutex);
+    return this->mesh_degradations;
+}
+
+/// Record generation of given input mesh was degraded after exceeding its budget.
+void CollisionGen::recordDegradation(size_t mesh_idx, const CollisionDegradation &degradation)
+{
+    std::lock_guard<std::mutex> lock(this->degradation_mutex);
+    if (mesh_idx < this->mesh_degradations.size())
+    {
+        this->mesh_degradations.at(mesh_idx).push_back(degradation);
+    }
+}
+
+/// Get value indicating if generation of given input mesh was degraded during the last generation.
+bool CollisionGen::isMeshDegraded(size_t mesh_idx) const
+{
+    std::lock_guard<std::mutex> lock(this->degradation_mutex);
+    return mesh_idx < this->mesh_degradations.size() && !this->mesh_degradations.at(mesh_idx).empty();
+}
+
+/// Bind cache used to store and fetch generated collision for each input mesh.
+/// @param: cache Cache to use or nullptr to disable caching.
+void CollisionGen::setCache(std::shared_ptr<CollisionCache> cache)
+{
+    this->cache = cache;
+}
+
+/// Compute cache key identifying collision generated for given mesh and settings.
+uint64_t CollisionGen::computeCacheKey(const Mesh &mesh, const CollisionGenSettings &settings)
+{
+    return CollisionGen::computeCacheKey(mesh.computeHash(), settings);
+}
+
+/// Compute cache key identifying collision generated for mesh of given hash and settings.
+/// Only settings which affect the generated collision contribute to the key.
+/// @param: mesh_hash Mesh content hash as returned by Mesh::computeHash().
+uint64_t CollisionGen::computeCacheKey(uint64_t mesh_hash, const CollisionGenSettings &settings)
+{
+    uint64_t key = mesh_hash;
+    key = Hashing::hashValue(key, COLLISION_GEN_VERSION);
+    key = Hashing::hashValue(key, settings.technique);
+    key = Hashing::hashValue(key, settings.cleanup_mode);
+    if (settings.cleanup_mode == MeshCleanupMode::AlphaWrapCleanup)
+    {
+        key = Hashing::hashValue(key, settings.resolution);
+        key = Hashing::hashValue(key, settings.wrap_alpha);
+        key = Hashing::hashValue(key, settings.wrap_offset);
+    }
+    key = Hashing::hashValue(key, settings.strict_vertex_limit);
+    if (settings.strict_vertex_limit)
+    {
+        key = Hashing::hashValue(key, settings.max_hull_vertices);
+    }
+
+    switch (settings.technique)
+    {
+        case CollisionTechnique::SimpleHull:
+            key = Hashing::hashValue(key, settings.hull_padding);
+            break;
+
+        case CollisionTechnique::ExactDecomposition:
+            key = Hashing::hashValue(key, settings.exact_time_budget);
+            key = Hashing::hashValue(key, settings.exact_max_pieces);
+            break;
+
+        case CollisionTechnique::ApproximateDecomposition:
+            key = Hashing::hashValue(key, settings.resolution);
+            key = Hashing::hashValue(key, settings.mode);
+            key = Hashing::hashValue(key, settings.concavity);
+            key = Hashing::hashValue(key, settings.max_hulls);
+            key = Hashing::hashValue(key, settings.max_hull_vertices);
+            key = Hashing::hashValue(key, settings.min_hull_volume);
+            key = Hashing::hashValue(key, settings.downsample);
+            key = Hashing::hashValue(key, settings.decimate);
+            key = Hashing::hashValue(key, settings.merge_threshold);
+            break;
+
+        case CollisionTechnique::PrimitiveFit:
+            key = Hashing::hashValue(key, settings.primitive_tolerance);
+            break;
+
+        case CollisionTechnique::VoxelBoxes:
+            key = Hashing::hashValue(key, settings.voxel_resolution);
+            key = Hashing::hashValue(key, settings.max_boxes);
+            key = Hashing::hashValue(key, settings.oriented_boxes);
+            break;
+    }
+
+    return key;
+}
+
+/// Forward progress update to the bound progress callback, if any.
+void CollisionGen::reportProgress(double progress, const std::string &stage)
+{
+    if (this->progress_callback)
+    {
+        std::lock_guard<std::mutex> lock(this->progress_mutex);
+        this->progress_callback(progress, stage);
+    }
+}
+
+/// Update progress of single input mesh and report combined progress of all input meshes.
+/// @param: mesh_idx Index of input mesh progress refers to.
+/// @param: progress Normalized progress value of given mesh.
+void CollisionGen::updateMeshProgress(size_t mesh_idx, double progress, const std::string &stage)
+{
+    if (!this->progress_callback)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(this->progress_mutex);
+    if (mesh_idx >= this->mesh_progress.size())
+    {
+        return;
+    }
+
+    this->mesh_progress.at(mesh_idx) = progress;
+
+    double total = 0.0;
+    for (double value : this->mesh_progress)
+    {
+        total += value;
+    }
+
+    this->progress_callback(total / this->mesh_progress.size(), stage);
+}
+
+/// Generate collision hulls for all active input meshes using technique selected in settings.
+/// Output order always follows input mesh order.
+/// @param: out_meshes List to add newly generated collision hulls to.
+void CollisionGen::generate(
+    const CollisionGenSettings &settings,
+    std::vector<std::unique_ptr<Mesh>> &out_meshes
+)
+{
+    std::vector<std::vector<std::unique_ptr<Mesh>>> mesh_hulls;
+    this->generate(settings, mesh_hulls);
+
+    for (std::vector<std::unique_ptr<Mesh>> &hulls : mesh_hulls)
+    {
+        for (std::unique_ptr<Mesh> &hull : hulls)
+        {
+            out_meshes.push_back(std::move(hull));
+        }
+    }
+}
+
+/// Generate collision hulls for all active input meshes using technique selected in settings.
+/// Hulls are grouped by input mesh, output contains one group for each input mesh in input order.
+/// Single hull enveloping the whole scene is returned as the only group.
+/// @param: out_mesh_hulls List to receive groups of newly generated collision hulls.
+void CollisionGen::generate(
+    const CollisionGenSettings &settings,
+    std::vector<std::vector<std::unique_ptr<Mesh>>> &out_mesh_hulls
+)
+{
+    CollisionLODChain levels;
+    this->generate(settings, 1, levels);
+
+    out_mesh_hulls.clear();
+    if (!levels.empty())
+    {
+        out_mesh_hulls = std::move(levels.front());
+    }
+}
+
+/// Generate collision hulls and their coarser LOD levels for all active input meshes.
+/// Finest level is generated using technique selected in settings. Each coarser level is derived
+/// from the level above by merging its hulls down to a fraction of their count, so cleanup and
+/// voxelization run only once. Levels are cached independently.
+/// Single hull enveloping the whole scene has no coarser levels.
+/// @param: num_levels Number of levels to generate including the finest one.
+/// @param: out_levels List to receive hulls of each level grouped by input mesh.
+void CollisionGen::generate(
+    const CollisionGenSettings &settings,
+    size_t num_levels,
+    CollisionLODChain &out_levels
+)
+{
+    out_levels.clear();
+    if (CollisionGen::isSceneHull(settings))
+    {
+        out_levels.resize(1);
+        out_levels.front().resize(1);
+        this->generateSceneHull(settings, out_levels.front().front());
+        return;
+    }
+
+    /// Each mesh writes into its own slot so results can be gathered in deterministic order.
+    out_levels.resize(std::max<size_t>(num_levels, 1));
+    for (std::vector<std::vector<std::unique_ptr<Mesh>>> &level : out_levels)
+    {
+        level.resize(this->input_meshes.size());
+    }
+
+    this->findInputInstances(settings);
+    this->forEachInputMesh(settings, [&](size_t mesh_idx)
+    {
+        if (this->mesh_instances.at(mesh_idx).prototype != mesh_idx)
+        {
+            this->updateMeshProgress(mesh_idx, 1.0, "Mesh instanced");
+            return;
+        }
+
+        this->processMesh(mesh_idx, settings, out_levels.front().at(mesh_idx));
+        this->processMeshLODs(mesh_idx, settings, out_levels);
+    });
+
+    for (std::vector<std::vector<std::unique_ptr<Mesh>>> &level : out_levels)
+    {
+        this->placeInstanceHulls(level);
+    }
+
+    if (this->cache)
+    {
+        this->cache->evict();
+    }
+
+    if (this->isCancelled())
+    {
+        logInfo("Collision generation cancelled");
+        out_levels.clear();
+        return;
+    }
+
+    this->reportProgress(1.0, "Done");
+}
+
+/// Get value indicating if given settings generate single hull enveloping the whole scene
+/// instead of hulls for each input mesh.
+bool CollisionGen::isSceneHull(const CollisionGenSettings &settings)
+{
+    return settings.technique == CollisionTechnique::SimpleHull && !settings.hull_per_mesh;
+}
+
+/// Get input meshes each group of hulls returned by CollisionGen::generate is generated from.
+/// @param: num_meshes Number of input meshes collision is generated for.
+/// @param: out_sources List to receive indices of source input meshes of each group.
+void CollisionGen::getResultSources(
+    const CollisionGenSettings &settings,
+    size_t num_meshes,
+    std::vector<std::vector<size_t>> &out_sources
+)
+{
+    out_sources.clear();
+    if (CollisionGen::isSceneHull(settings))
+    {
+        out_sources.emplace_back(num_meshes);
+        std::iota(out_sources.front().begin(), out_sources.front().end(), 0);
+        return;
+    }
+
+    for (size_t mesh_idx=0; mesh_idx < num_meshes; mesh_idx++)
+    {
+        out_sources.push_back({mesh_idx});
+    }
+}
+
+/// Generate chain of collision LOD levels for all active input meshes in single pass.
+/// Number of levels is given by settings, see CollisionGen::generate.
+/// @param: out_levels List to receive hulls of each level grouped by input mesh.
+void CollisionGen::generateLODChain(const CollisionGenSettings &settings, CollisionLODChain &out_levels)
+{
+    this->generate(settings, std::max(settings.lod_levels, 1), out_levels);
+}
+
+/// Derive coarser LOD levels of single input mesh from its finest level.
+/// Hull count of each level is the finest hull count scaled by LOD ratio once per level.
+/// @param: mesh_idx Index of the input mesh to process.
+/// @param: levels LOD levels with the finest level of the mesh already generated.
+void CollisionGen::processMeshLODs(
+    size_t mesh_idx,
+    const CollisionGenSettings &settings,
+    CollisionLODChain &levels
+)
+{
+    const size_t num_hulls = levels.front().at(mesh_idx).size();
+    if (levels.size() < 2 || num_hulls == 0)
+    {
+        return;
+    }
+
+    /// Levels derived from degraded finest level are never cached, nor mixed with cached
+    /// levels derived from a complete one.
+    const bool use_cache = this->cache && !this->isMeshDegraded(mesh_idx);
+    const uint64_t cache_key = use_cache
+        ? CollisionGen::computeCacheKey(*this->input_meshes.at(mesh_idx), settings)
+        : 0;
+
+    for (size_t level=1; level < levels.size() && !this->isCancelled(); level++)
+    {
+        this->updateMeshProgress(mesh_idx, 1.0, "Generating LOD " + std::to_string(level));
+
+        std::vector<std::unique_ptr<Mesh>> &hulls = levels.at(level).at(mesh_idx);
+        /// Finest level key holds no LOD settings, so only coarser levels depend on the ratio.
+        const uint64_t level_key = Hashing::hashValue(
+            Hashing::hashValue(cache_key, level),
+            settings.lod_ratio
+        );
+        if (use_cache && this->cache->load(level_key, hulls))
+        {
+            continue;
+        }
+
+        for (const std::unique_ptr<Mesh> &hull : levels.at(level - 1).at(mesh_idx))
+        {
+            hulls.push_back(std::make_unique<Mesh>(*hull));
+        }
+
+        const size_t max_hulls = std::max<size_t>(1, std::lround(num_hulls * std::pow(settings.lod_ratio, level)));
+        if (hulls.size() > max_hulls)
+        {
+            CollisionGen::mergeHulls(hulls, std::numeric_limits<double>::infinity(), max_hulls);
+            this->simplifyMeshHulls(settings, hulls);
+        }
+
+        logDebug("Generated LOD {} with {} of {} hulls", level, hulls.size(), num_hulls);
+        if (use_cache && !this->isCancelled() && !hulls.empty())
+        {
+            this->cache->store(level_key, hulls);
+        }
+    }
+}
+
+/// Generate single convex hull enveloping all input meshes.
+/// @param: out_meshes List to add newly generated collision hull to.
+void CollisionGen::generateSceneHull(
+    const CollisionGenSettings &settings,
+    std::vector<std::unique_ptr<Mesh>> &out_meshes
+)
+{
+    this->reportProgress(0.0, "Convex hull");
+    std::vector<CGAL_FastPoint> points = this->getInputPoints(settings.hull_padding);
+
+    auto start_time = std::chrono::steady_clock::now();
+    Mesh hull({}, {});
+    if (CollisionGen::computeConvexHull(points, hull))
+    {
+        auto end_time = std::chrono::steady_clock::now();
+        double duration = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+        logDebug("Computed scene convex hull of {} points in {:.2f}ms", points.size(), duration);
+        out_meshes.push_back(std::make_unique<Mesh>(hull));
+    }
+    else
+    {
+        logError("Failed to compute convex hull of {} input points", points.size());
+    }
+
+    this->simplifyMeshHulls(settings, out_meshes);
+    this->reportProgress(1.0, "Done");
+}
+
+/// Generate collision hulls for single input mesh using technique selected in settings.
+/// Results are fetched from and written to the collision cache when one is bound.
+/// @param: mesh_idx Index of the input mesh to process.
+/// @param: out_meshes List to add newly generated collision hulls to.
+void CollisionGen::processMesh(
+    size_t mesh_idx,
+    const CollisionGenSettings &settings,
+    std::vector<std::unique_ptr<Mesh>> &out_meshes
+)
+{
+    uint64_t cache_key = 0;
+    if (this->cache)
+    {
+        cache_key = CollisionGen::computeCacheKey(*this->input_meshes.at(mesh_idx), settings);
+        if (this->cache->load(cache_key, out_meshes))
+        {
+            logDebug("Loaded {} collision hulls from cache entry {:016x}", out_meshes.size(), cache_key);
+            this->updateMeshProgress(mesh_idx, 1.0, "Mesh loaded from cache");
+            return;
+        }
+    }
+
+    switch (settings.technique)
+    {
+        case CollisionTechnique::SimpleHull:
+            this->processMeshSimpleHull(mesh_idx, settings, out_meshes);
+            break;
+        case CollisionTechnique::ExactDecomposition:
+            this->processMeshExact(mesh_idx, settings, out_meshes);
+            break;
+        case CollisionTechnique::ApproximateDecomposition:
+            this->processMeshVHACD(mesh_idx, settings, out_meshes);
+            break;
+        case CollisionTechnique::PrimitiveFit:
+            this->processMeshPrimitives(mesh_idx, settings, out_meshes);
+            break;
+        case CollisionTechnique::VoxelBoxes:
+            this->processMeshVoxelBoxes(mesh_idx, settings, out_meshes);
+            break;
+        default:
+            logError("Unsupported collision technique -> {}", int(settings.technique));
+            return;
+    }
+
+    this->simplifyMeshHulls(settings, out_meshes);
+
+    /// Never cache results of interrupted, failed or degraded generation.
+    if (this->cache && !this->isCancelled() && !out_meshes.empty() && !this->isMeshDegraded(mesh_idx))
+    {
+        this->cache->store(cache_key, out_meshes);
+    }
+}
+
+/// Generate single convex hull for single input mesh.
+/// @param: mesh_idx Index of the input mesh to process.
+/// @param: out_meshes List to add newly generated collision hull to.
+void CollisionGen::processMeshSimpleHull(
+    size_t mesh_idx,
+    const CollisionGenSettings &settings,
+    std::vector<std::unique_ptr<Mesh>> &out_meshes
+)
+{
+    this->updateMeshProgress(mesh_idx, 0.0, "Convex hull");
+
+    std::vector<CGAL_FastPoint> points;
+    CollisionGen::getMeshPoints(*this->input_meshes.at(mesh_idx), settings.hull_padding, points);
+
+    Mesh hull({}, {});
+    if (CollisionGen::computeConvexHull(points, hull))
+    {
+        out_meshes.push_back(std::make_unique<Mesh>(hull));
+    }
+    else
+    {
+        logError("Failed to compute convex hull of {} mesh points, skipping mesh", points.size());
+    }
+
+    this->updateMeshProgress(mesh_idx, 1.0, "Mesh done");
+}
+
+/// Group input meshes which are copies of each other so each unique shape is processed once.
+/// Every mesh is its own prototype when deduplication is disabled.
+void CollisionGen::findInputInstances(const CollisionGenSettings &settings)
+{
+    if (!settings.dedupe_instances)
+    {
+        this->mesh_instances.assign(this->input_meshes.size(), MeshInstance());
+        for (size_t mesh_idx=0; mesh_idx < this->input_meshes.size(); mesh_idx++)
+        {
+            this->mesh_instances.at(mesh_idx).prototype = mesh_idx;
+        }
+        return;
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    const size_t num_unique = CollisionInstances::findInstances(
+        this->input_meshes,
+        INSTANCE_TOLERANCE,
+        this->mesh_instances
+    );
+
+    auto end_time = std::chrono::steady_clock::now();
+    double duration = std::chrono::duration<double>(end_time - start_time).count();
+    logInfo(
+        "Found {} unique shapes among {} input meshes in {:.3f}s",
+        num_unique,
+        this->input_meshes.size(),
+        duration
+    );
+}
+
+/// Fill collision of each instanced input mesh with hulls of its prototype moved onto the instance.
+/// @param: mesh_hulls Hulls grouped by input mesh with hulls of prototypes already generated.
+void CollisionGen::placeInstanceHulls(std::vector<std::vector<std::unique_ptr<Mesh>>> &mesh_hulls) const
+{
+    for (size_t mesh_idx=0; mesh_idx < mesh_hulls.size() && mesh_idx < this->mesh_instances.size(); mesh_idx++)
+    {
+        const MeshInstance &instance = this->mesh_instances.at(mesh_idx);
+        if (instance.prototype == mesh_idx)
+        {
+            continue;
+        }
+
+        for (const std::unique_ptr<Mesh> &hull : mesh_hulls.at(instance.prototype))
+        {
+            Mesh instance_hull({}, {});
+            CollisionInstances::transformMesh(*hull, instance, instance_hull);
+            mesh_hulls.at(mesh_idx).push_back(std::make_unique<Mesh>(instance_hull));
+        }
+    }
+}
+
+/// Invoke given function for each active input mesh on the worker pool.
+/// Function is skipped for remaining meshes once generation is cancelled.
+/// @param: func Function to invoke with index of the input mesh to process.
+void CollisionGen::forEachInputMesh(
+    const CollisionGenSettings &settings,
+    const std::function<void(size_t mesh_idx)> &func
+)
+{
+    const size_t num_meshes = this->input_meshes.size();
+    {
+        std::lock_guard<std::mutex> lock(this->progress_mutex);
+        this->mesh_progress.assign(num_meshes, 0.0);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->degradation_mutex);
+        this->mesh_degradations.assign(num_meshes, {});
+    }
+
+    const int num_workers = settings.worker_threads > 0 
+        ? settings.worker_threads 
+        : tbb::task_arena::automatic;
+
+    tbb::task_arena arena(num_workers);
+    logDebug("Processing {} meshes using {} worker threads", num_meshes, arena.max_concurrency());
+    arena.execute([&]()
+    {
+        tbb::parallel_for(size_t(0), num_meshes, [&](size_t mesh_idx)
+        {
+            if (this->isCancelled())
+            {
+                return;
+            }
+
+            func(mesh_idx);
+        });
+    });
+}
+
+/// Run approximate convex decomposition for single input mesh.
+/// Disconnected components of the mesh are decomposed independently and in parallel, so each
+/// gets its own voxel grid. Hull budget is shared out in proportion to component volume.
+/// Safe to call concurrently for different input meshes.
+/// @param: mesh_idx Index of the input mesh to process.
+/// @param: out_meshes List to add newly generated collision hulls to.
+void CollisionGen::processMeshVHACD(
+    size_t mesh_idx,
+    const CollisionGenSettings &settings,
+    std::vector<std::unique_ptr<Mesh>> &out_meshes
+)
+{
+    const Mesh *in_mesh = this->input_meshes.at(mesh_idx);
+    logDebug("Processing approximate collision for mesh of {} vertices", in_mesh->numVertices());
+    this->updateMeshProgress(mesh_idx, 0.0, "Mesh cleanup");
+
+    /// Dense meshes are welded once before decimation, cleanup does not weld them again.
+    Mesh mesh(*in_mesh);
+    if (settings.decimate)
+    {
+        this->updateMeshProgress(mesh_idx, 0.0, "Mesh decimation");
+        const double max_error = CollisionGen::getVoxelSize(mesh, settings.resolution) * DECIMATION_VOXEL_ERROR;
+        CollisionGen::weldMesh(mesh);
+        CollisionGen::decimateMesh(mesh, max_error);
+    }
+
+    this->updateMeshProgress(mesh_idx, 0.0, "Mesh cleanup");
+    CollisionGen::cleanupMesh(mesh, settings, nullptr, settings.decimate);
+    if (!Mesh::isValid(mesh))
+    {
+        logError("Encountered degenerate input mesh data, skipping mesh");
+        this->updateMeshProgress(mesh_idx, 1.0, "Mesh skipped");
+        return;
+    }
+
+    std::vector<Mesh> components;
+    CollisionGen::splitConnectedComponents(mesh, components);
+
+    /// Decomposition exceeding its budget is retried at lower resolution a few times and
+    /// finally replaced by convex hulls of the mesh components.
+    CollisionGenSettings attempt_settings = settings;
+    for (int attempt=0; !this->isCancelled(); attempt++)
+    {
+        CollisionBudget budget(settings.mesh_time_budget, settings.mesh_memory_budget);
+        std::vector<std::unique_ptr<Mesh>> hulls;
+        this->decomposeComponentsVHACD(mesh_idx, mesh, components, attempt_settings, budget, hulls);
+        if (!budget.isExceeded())
+        {
+            std::move(hulls.begin(), hulls.end(), std::back_inserter(out_meshes));
+            break;
+        }
+
+        CollisionDegradation degradation;
+        degradation.reason = budget.getReason();
+        degradation.resolution = attempt_settings.resolution;
+        degradation.elapsed = budget.getElapsed();
+        degradation.peak_memory = budget.getPeakMemory();
+
+        const double resolution = attempt_settings.resolution * BUDGET_RESOLUTION_FACTOR;
+        if (attempt < MAX_BUDGET_RETRIES && resolution >= MIN_BUDGET_RESOLUTION)
+        {
+            logWarning(
+                "Decomposition exceeded {} budget after {:.2f}s at resolution {:.0f}, retrying at resolution {:.0f}",
+                degradation.reason,
+                degradation.elapsed,
+                attempt_settings.resolution,
+                resolution
+            );
+
+            degradation.fallback = "lower_resolution";
+            degradation.fallback_resolution = resolution;
+            this->recordDegradation(mesh_idx, degradation);
+            attempt_settings.resolution = resolution;
+            continue;
+        }
+
+        /// Components are grouped like for decomposition, so the fallback stays within the hull budget.
+        std::vector<Mesh> groups;
+        CollisionGen::groupComponents(components, settings.max_hulls, groups);
+
+        logWarning(
+            "Decomposition exceeded {} budget after {:.2f}s at resolution {:.0f}, using convex hull of {} mesh components",
+            degradation.reason,
+            degradation.elapsed,
+            attempt_settings.resolution,
+            std::max<size_t>(groups.size(), 1)
+        );
+
+        degradation.fallback = "component_hulls";
+        this->recordDegradation(mesh_idx, degradation);
+
+        std::vector<const Mesh*> hull_sources;
+        for (const Mesh &group : groups)
+        {
+            hull_sources.push_back(&group);
+        }
+
+        if (hull_sources.empty())
+        {
+            hull_sources.push_back(&mesh);
+        }
+
+        for (const Mesh *source : hull_sources)
+        {
+            std::vector<CGAL_FastPoint> points;
+            CollisionGen::getMeshPoints(*source, 0.0f, points);
+
+            Mesh hull({}, {});
+            if (CollisionGen::computeConvexHull(points, hull))
+            {
+                out_meshes.push_back(std::make_unique<Mesh>(hull));
+            }
+        }
+        break;
+    }
+
+    this->mergeMeshHulls(mesh_idx, settings, out_meshes);
+    this->updateMeshProgress(mesh_idx, 1.0, "Mesh done");
+}
+
+/// Run approximate convex decomposition of cleaned up mesh split into disconnected components.
+/// Components are decomposed in parallel, decomposition stops early once the budget is exceeded.
+/// @param: mesh_idx Index of the input mesh to process.
+/// @param: mesh Cleaned up mesh to decompose.
+/// @param: components Disconnected components of the mesh.
+/// @param: budget Budget all components of the mesh share.
+/// @param: out_meshes List to add newly generated collision hulls to.
+void CollisionGen::decomposeComponentsVHACD(
+    size_t mesh_idx,
+    const Mesh &mesh,
+    const std::vector<Mesh> &components,
+    const CollisionGenSettings &settings,
+    CollisionBudget &budget,
+    std::vector<std::unique_ptr<Mesh>> &out_meshes
+)
+{
+    /// Failed worker process is replaced by convex hull of its mesh, as running the same
+    /// decomposition in this process would risk the crash the worker isolated.
+    auto replace_failed_worker = [&](bool success, const Mesh &source, std::vector<std::unique_ptr<Mesh>> &hulls)
+    {
+        if (success || !settings.worker_processes || this->isCancelled() || budget.isExceeded())
+        {
+            return;
+        }
+
+        CollisionDegradation degradation;
+        degradation.reason = "worker_failure";
+        degradation.resolution = settings.resolution;
+        degradation.elapsed = budget.getElapsed();
+        degradation.fallback = "component_hulls";
+        this->recordDegradation(mesh_idx, degradation);
+        logWarning("Decomposition worker failed, using convex hull of {} triangles instead", source.numIndices() / 3);
+
+        std::vector<CGAL_FastPoint> points;
+        CollisionGen::getMeshPoints(source, 0.0f, points);
+
+        Mesh hull({}, {});
+        if (CollisionGen::computeConvexHull(points, hull))
+        {
+            hulls.push_back(std::make_unique<Mesh>(hull));
+        }
+    };
+
+    auto start_time = std::chrono::steady_clock::now();
+    if (components.size() <= 1)
+    {
+        const bool success = this->decomposeVHACD(mesh, settings, settings.max_hulls, budget, [&](double progress, const char *stage)
+        {
+            this->updateMeshProgress(mesh_idx, progress, stage);
+        }, out_meshes);
+        replace_failed_worker(success, mesh, out_meshes);
+
+        auto end_time = std::chrono::steady_clock::now();
+        double duration = std::chrono::duration<double>(end_time - start_time).count();
+        logDebug("Decomposed mesh of {} triangles in {:.3f}s", mesh.numIndices() / 3, duration);
+        return;
+    }
+
+    /// Components exceeding the hull budget are grouped, so their hulls stay within the budget.
+    std::vector<Mesh> groups;
+    CollisionGen::groupComponents(components, settings.max_hulls, groups);
+    if (groups.size() < components.size())
+    {
+        logDebug("Grouped {} disconnected mesh components into {} to meet hull budget", components.size(), groups.size());
+    }
+
+    std::vector<int> component_hulls;
+    CollisionGen::distributeHullBudget(groups, settings.max_hulls, component_hulls);
+    logDebug("Decomposing {} disconnected mesh components", groups.size());
+
+    std::mutex component_mutex;
+    std::vector<double> component_progress(groups.size(), 0.0);
+    std::vector<std::vector<std::unique_ptr<Mesh>>> component_meshes(groups.size());
+
+    tbb::parallel_for(size_t(0), groups.size(), [&](size_t component_idx)
+    {
+        if (this->isCancelled() || budget.isExceeded())
+        {
+            return;
+        }
+
+        const bool success = this->decomposeVHACD(
+            groups.at(component_idx),
+            settings,
+            component_hulls.at(component_idx),
+            budget,
+            [&](double progress, const char *stage)
+            {
+                double mesh_progress = 0.0;
+                {
+                    std::lock_guard<std::mutex> lock(component_mutex);
+                    component_progress.at(component_idx) = progress;
+                    for (const double &value : component_progress)
+                    {
+                        mesh_progress += value;
+                    }
+                }
+
+                this->updateMeshProgress(mesh_idx, mesh_progress / groups.size(), stage);
+            },
+            component_meshes.at(component_idx)
+        );
+        replace_failed_worker(success, groups.at(component_idx), component_meshes.at(component_idx));
+    });
+
+    for (std::vector<std::unique_ptr<Mesh>> &hulls : component_meshes)
+    {
+        for (std::unique_ptr<Mesh> &hull : hulls)
+        {
+            out_meshes.push_back(std::move(hull));
+        }
+    }
+
+    auto end_time = std::chrono::steady_clock::now();
+    double duration = std::chrono::duration<double>(end_time - start_time).count();
+    logDebug("Decomposed mesh of {} triangles in {:.3f}s", mesh.numIndices() / 3, duration);
+}
+
+/// Run hull merging post-pass over hulls generated for single input mesh if enabled in settings.
+/// @param: mesh_idx Index of the input mesh the hulls belong to.
+/// @param: hulls Generated collision hulls to merge in place.
+void CollisionGen::mergeMeshHulls(
+    size_t mesh_idx,
+    const CollisionGenSettings &settings,
+    std::vector<std::unique_ptr<Mesh>> &hulls
+)
+{
+    if (settings.merge_threshold <= 0.0 || hulls.size() < 2 || this->isCancelled())
+    {
+        return;
+    }
+
+    this->updateMeshProgress(mesh_idx, 1.0, "Merging hulls");
+    auto start_time = std::chrono::steady_clock::now();
+    const size_t num_hulls = hulls.size();
+    const size_t num_merged = CollisionGen::mergeHulls(hulls, settings.merge_threshold);
+    auto end_time = std::chrono::steady_clock::now();
+    double duration = std::chrono::duration<double>(end_time - start_time).count();
+
+    logDebug(
+        "Merged {} of {} hulls leaving {} hulls in {:.3f}s",
+        num_merged,
+        num_hulls,
+        hulls.size(),
+        duration
+    );
+}
+
+/// Enforce vertex limit on given hulls if enabled in settings and report volume it added.
+/// @param: hulls Convex hulls to simplify in place.
+void CollisionGen::simplifyMeshHulls(
+    const CollisionGenSettings &settings,
+    std::vector<std::unique_ptr<Mesh>> &hulls
+)
+{
+    if (!settings.strict_vertex_limit || hulls.empty() || this->isCancelled())
+    {
+        return;
+    }
+
+    std::vector<double> volumes(hulls.size(), 0.0);
+    std::vector<double> added_volumes(hulls.size(), 0.0);
+    tbb::parallel_for(size_t(0), hulls.size(), [&](size_t i)
+    {
+        /// Primitives are exported as analytic shapes, their tessellation is only for display.
+        if (hulls[i]->isPrimitive())
+        {
+            return;
+        }
+
+        volumes[i] = hulls[i]->computeVolume();
+        if (!CollisionGen::simplifyHull(*hulls[i], settings.max_hull_vertices, added_volumes[i]))
+        {
+            logWarning("Failed to simplify hull of {} vertices, keeping original hull", hulls[i]->numVertices());
+        }
+    });
+
+    const double volume = std::accumulate(volumes.begin(), volumes.end(), 0.0);
+    const double added_volume = std::accumulate(added_volumes.begin(), added_volumes.end(), 0.0);
+    logDebug(
+        "Simplified {} hulls to at most {} vertices adding {:.6f} volume ({:.2f}%)",
+        hulls.size(),
+        settings.max_hull_vertices,
+        added_volume,
+        volume > 0.0 ? added_volume / volume * 100.0 : 0.0
+    );
+}
+
+/// Simplify convex hull by merging its coplanar faces and removing planes until it has
+/// at most given number of vertices. Hull is rebuilt as intersection of half-spaces of its
+/// face planes, removing a plane only grows the hull so the result always contains the input.
+/// Plane whose removal adds the least volume is removed first, candidates are evaluated in parallel.
+/// @param: hull Convex hull to simplify in place.
+/// @param: max_vertices Maximum number of vertices of the simplified hull.
+/// @param: out_added_volume Receives volume added by the simplification.
+/// Returns false if the hull could not be rebuilt, hull is left unchanged in such case.
+bool CollisionGen::simplifyHull(Mesh &hull, int max_vertices, double &out_added_volume)
+{
+    using Plane = CGAL_FastKernel::Plane_3;
+    using Vector = CGAL_FastKernel::Vector_3;
+
+    out_added_volume = 0.0;
+    std::span<const QVector3D> vertices = hull.getVertices();
+    std::span<const int> indices = hull.getIndices();
+    if (vertices.size() < 4 || indices.size() < 12)
+    {
+        return false;
+    }
+
+    QVector3D center(0.0, 0.0, 0.0);
+    QVector3D min_bound = vertices.front();
+    QVector3D max_bound = vertices.front();
+    for (const QVector3D &vertex : vertices)
+    {
+        center += vertex;
+        for (int axis=0; axis < 3; axis++)
+        {
+            min_bound[axis] = std::min(min_bound[axis], vertex[axis]);
+            max_bound[axis] = std::max(max_bound[axis], vertex[axis]);
+        }
+    }
+    center /= float(vertices.size());
+    const double radius = (max_bound - min_bound).length() * 0.5;
+
+    /// Group faces into planes, largest faces first so they define the plane orientation.
+    struct HullFace
+    {
+        QVector3D normal;
+        double area;
+        size_t index;
+    };
+
+    std::vector<HullFace> faces;
+    for (size_t i=0; i+2 < indices.size(); i+=3)
+    {
+        const QVector3D &a = vertices[indices[i]];
+        QVector3D normal = QVector3D::crossProduct(vertices[indices[i+1]] - a, vertices[indices[i+2]] - a);
+        const double area = normal.length() * 0.5;
+        if (area <= 0.0)
+        {
+            continue;
+        }
+
+        normal.normalize();
+        if (QVector3D::dotProduct(normal, center - a) > 0.0)
+        {
+            normal = -normal;
+        }
+
+        faces.push_back({normal, area, i});
+    }
+
+    std::sort(faces.begin(), faces.end(), [](const HullFace &a, const HullFace &b)
+    {
+        return a.area > b.area;
+    });
+
+    /// Plane offsets are pushed out to the furthest vertex of merged faces to keep the input enclosed.
+    const double min_dot = std::cos(COPLANAR_ANGLE * std::numbers::pi / 180.0);
+    std::vector<QVector3D> plane_normals;
+    std::vector<double> plane_offsets;
+    for (const HullFace &face : faces)
+    {
+        double face_offset = -std::numeric_limits<double>::infinity();
+        for (size_t i=face.index; i < face.index+3; i++)
+        {
+            face_offset = std::max(face_offset, double(QVector3D::dotProduct(face.normal, vertices[indices[i]])));
+        }
+
+        bool merged = false;
+        for (size_t p=0; p < plane_normals.size() && !merged; p++)
+        {
+            const QVector3D &normal = plane_normals[p];
+            if (QVector3D::dotProduct(normal, face.normal) < min_dot)
+            {
+                continue;
+            }
+
+            double offset = plane_offsets[p];
+            for (size_t i=face.index; i < face.index+3; i++)
+            {
+                offset = std::max(offset, double(QVector3D::dotProduct(normal, vertices[indices[i]])));
+            }
+
+            if (std::abs(offset - face_offset) <= COPLANAR_DISTANCE * radius)
+            {
+                plane_offsets[p] = offset;
+                merged = true;
+            }
+        }
+
+        if (!merged)
+        {
+            plane_normals.push_back(face.normal);
+            plane_offsets.push_back(face_offset);
+        }
+    }
+
+    /// Guard box keeps intersection bounded when removed plane was needed to close the hull.
+    /// Results touching the guard box are rejected.
+    const QVector3D guard_min = min_bound - (max_bound - min_bound) * 0.5;
+    const QVector3D guard_max = max_bound + (max_bound - min_bound) * 0.5;
+    std::vector<Plane> guard_planes;
+    for (int axis=0; axis < 3; axis++)
+    {
+        double normal[3] = {0.0, 0.0, 0.0};
+        normal[axis] = 1.0;
+        guard_planes.emplace_back(normal[0], normal[1], normal[2], -guard_max[axis]);
+        guard_planes.emplace_back(-normal[0], -normal[1], -normal[2], guard_min[axis]);
+    }
+
+    const CGAL_FastPoint interior(center.x(), center.y(), center.z());
+    const double guard_epsilon = 1e-6 * radius;
+
+    /// Build hull from given subset of planes, returns false if it is unbounded or fails.
+    auto build_hull = [&](const std::vector<size_t> &planes, CGAL_FastSurface &out_surface)
+    {
+        std::vector<Plane> halfspaces = guard_planes;
+        for (size_t p : planes)
+        {
+            const QVector3D &normal = plane_normals[p];
+            halfspaces.emplace_back(normal.x(), normal.y(), normal.z(), -plane_offsets[p]);
+        }
+
+        out_surface.clear();
+        CGAL::halfspace_intersection_3(halfspaces.begin(), halfspaces.end(), out_surface, interior);
+        if (out_surface.number_of_vertices() < 4)
+        {
+            return false;
+        }
+
+        for (const CGAL_FastSurface::Vertex_index &vertex : out_surface.vertices())
+        {
+            const CGAL_FastPoint &point = out_surface.point(vertex);
+            for (int axis=0; axis < 3; axis++)
+            {
+                if (point[axis] >= guard_max[axis] - guard_epsilon ||
+                    point[axis] <= guard_min[axis] + guard_epsilon)
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    };
+
+    std::vector<size_t> active_planes(plane_normals.size());
+    std::iota(active_planes.begin(), active_planes.end(), 0);
+
+    CGAL_FastSurface surface;
+    if (!build_hull(active_planes, surface))
+    {
+        return false;
+    }
+
+    Mesh simplified({}, {});
+    CollisionGen::meshFromSurface(surface, simplified);
+
+    while (simplified.numVertices() > size_t(max_vertices) && active_planes.size() > 4)
+    {
+        /// Volume and vertex count of the hull with each active plane removed.
+        std::vector<double> volumes(active_planes.size(), std::numeric_limits<double>::infinity());
+        std::vector<size_t> vertex_counts(active_planes.size(), 0);
+        tbb::parallel_for(size_t(0), active_planes.size(), [&](size_t i)
+        {
+            std::vector<size_t> planes = active_planes;
+            planes.erase(planes.begin() + i);
+
+            CGAL_FastSurface candidate_surface;
+            if (!build_hull(planes, candidate_surface))
+            {
+                return;
+            }
+
+            Mesh candidate({}, {});
+            CollisionGen::meshFromSurface(candidate_surface, candidate);
+            volumes[i] = candidate.computeVolume();
+            vertex_counts[i] = candidate.numVertices();
+        });
+
+        /// Prefer removals which reduce vertex count, removing a plane may also add vertices.
+        size_t best = active_planes.size();
+        for (size_t i=0; i < active_planes.size(); i++)
+        {
+            if (std::isinf(volumes[i]))
+            {
+                continue;
+            }
+
+            const bool reduces = vertex_counts[i] < simplified.numVertices();
+            const bool best_reduces = best < active_planes.size() && vertex_counts[best] < simplified.numVertices();
+            if (best == active_planes.size() ||
+                (reduces && !best_reduces) ||
+                (reduces == best_reduces && volumes[i] < volumes[best]))
+            {
+                best = i;
+            }
+        }
+
+        if (best == active_planes.size())
+        {
+            logWarning(
+                "Unable to reduce hull below {} vertices, limit is {}",
+                simplified.numVertices(),
+                max_vertices
+            );
+            break;
+        }
+
+        active_planes.erase(active_planes.begin() + best);
+        build_hull(active_planes, surface);
+        CollisionGen::meshFromSurface(surface, simplified);
+    }
+
+    out_added_volume = simplified.computeVolume() - hull.computeVolume();
+    hull = simplified;
+    return true;
+}
+
+/// Greedily merge pairs of hulls whose merged convex hull adds little volume.
+/// Candidate pairs are kept in a priority queue ordered by relative volume increase, the
+/// cheapest pair is merged first and costs against the merged hull are re-evaluated.
+/// Merge costs are evaluated in parallel and only for hulls with overlapping or close bounds
+/// and the nearest few hulls of each, remaining hulls are re-paired once no candidate is left.
+/// Pairs with disjoint bounding spheres are never merged unless the volume increase is unbounded.
+/// @param: hulls Convex hulls to merge in place, order of remaining hulls is preserved.
+/// @param: max_volume_increase Maximum volume the merged hull may add relative to the
+/// combined volume of both hulls, or to a fraction of the merged extent for flat hulls.
+/// @param: min_hulls Merging stops once only this many hulls remain.
+/// Returns number of merges performed.
+size_t CollisionGen::mergeHulls(
+    std::vector<std::unique_ptr<Mesh>> &hulls,
+    double max_volume_increase,
+    size_t min_hulls
+)
+{
+    struct MergeCandidate
+    {
+        double cost;
+        size_t hull_a;
+        size_t hull_b;
+        uint32_t version_a;
+        uint32_t version_b;
+    };
+
+    auto compare = [](const MergeCandidate &a, const MergeCandidate &b)
+    {
+        return a.cost > b.cost;
+    };
+
+    std::priority_queue<MergeCandidate, std::vector<MergeCandidate>, decltype(compare)> queue(compare);
+    std::vector<double> volumes(hulls.size());
+    std::vector<uint32_t> versions(hulls.size(), 0);
+    std::vector<char> merged_away(hulls.size(), 0);
+
+    for (size_t i=0; i < hulls.size(); i++)
+    {
+        volumes[i] = hulls[i]->computeVolume();
+    }
+
+    auto merge_hulls = [&hulls](size_t a, size_t b, Mesh &out_hull)
+    {
+        std::vector<CGAL_FastPoint> points;
+        points.reserve(hulls[a]->numVertices() + hulls[b]->numVertices());
+        CollisionGen::getMeshPoints(*hulls[a], 0.0, points);
+        CollisionGen::getMeshPoints(*hulls[b], 0.0, points);
+        return CollisionGen::computeConvexHull(points, out_hull);
+    };
+
+    auto merge_cost = [&](size_t a, size_t b)
+    {
+        const double no_merge = std::numeric_limits<double>::infinity();
+        const Mesh &hull_a = *hulls[a];
+        const Mesh &hull_b = *hulls[b];
+        const float distance = (hull_a.getBoundingSphereCenter() - hull_b.getBoundingSphereCenter()).length();
+        if (std::isfinite(max_volume_increase) &&
+            distance > hull_a.getBoundingSphereRadius() + hull_b.getBoundingSphereRadius())
+        {
+            return no_merge;
+        }
+
+        const double volume = volumes[a] + volumes[b];
+        Mesh merged({}, {});
+        if (!merge_hulls(a, b, merged))
+        {
+            return no_merge;
+        }
+
+        const double diameter = 2.0 * merged.getBoundingSphereRadius();
+        const double reference = std::max(volume, diameter * diameter * diameter * MIN_MERGE_VOLUME);
+        if (reference <= 0.0)
+        {
+            return no_merge;
+        }
+
+        return std::max(merged.computeVolume() - volume, 0.0) / reference;
+    };
+
+    auto push_candidates = [&](const std::vector<std::pair<size_t, size_t>> &pairs)
+    {
+        std::vector<double> costs(pairs.size());
+        tbb::parallel_for(size_t(0), pairs.size(), [&](size_t i)
+        {
+            costs[i] = merge_cost(pairs[i].first, pairs[i].second);
+        });
+
+        for (size_t i=0; i < pairs.size(); i++)
+        {
+            /// Costs of unchanged pairs never drop, so pairs above threshold can be dropped.
+            if (costs[i] <= max_volume_increase)
+            {
+                const auto [a, b] = pairs[i];
+                queue.push({costs[i], a, b, versions[a], versions[b]});
+            }
+        }
+    };
+
+    std::vector<QVector3D> bounds_min(hulls.size());
+    std::vector<QVector3D> bounds_max(hulls.size());
+    auto update_bounds = [&](size_t i)
+    {
+        const std::span<const QVector3D> vertices = hulls[i]->getVertices();
+        QVector3D min_point(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+        QVector3D max_point = -min_point;
+        for (const QVector3D &vertex : vertices)
+        {
+            min_point = QVector3D(std::min(min_point.x(), vertex.x()), std::min(min_point.y(), vertex.y()), std::min(min_point.z(), vertex.z()));
+            max_point = QVector3D(std::max(max_point.x(), vertex.x()), std::max(max_point.y(), vertex.y()), std::max(max_point.z(), vertex.z()));
+        }
+
+        if (vertices.empty())
+        {
+            min_point = max_point = QVector3D();
+        }
+
+        const QVector3D margin = QVector3D(1.0f, 1.0f, 1.0f) * (max_point - min_point).length() * MERGE_BOUNDS_MARGIN;
+        bounds_min[i] = min_point - margin;
+        bounds_max[i] = max_point + margin;
+    };
+
+    /// Squared distance between expanded bounds, zero when they overlap.
+    auto bounds_distance = [&](size_t a, size_t b)
+    {
+        float distance = 0.0f;
+        for (int axis=0; axis < 3; axis++)
+        {
+            const float gap = std::max({bounds_min[a][axis] - bounds_max[b][axis], bounds_min[b][axis] - bounds_max[a][axis], 0.0f});
+            distance += gap * gap;
+        }
+        return distance;
+    };
+
+    auto find_pairs = [&](size_t a, std::vector<std::pair<size_t, size_t>> &out_pairs)
+    {
+        std::vector<std::pair<float, size_t>> nearest;
+        for (size_t b=0; b < hulls.size(); b++)
+        {
+            if (b == a || merged_away[b])
+            {
+                continue;
+            }
+
+            const float distance = bounds_distance(a, b);
+            if (distance <= 0.0f)
+            {
+                out_pairs.emplace_back(std::min(a, b), std::max(a, b));
+            }
+            else
+            {
+                nearest.emplace_back(distance, b);
+            }
+        }
+
+        const size_t num_nearest = std::min(nearest.size(), MERGE_NEAREST_HULLS);
+        std::partial_sort(nearest.begin(), nearest.begin() + num_nearest, nearest.end());
+        for (size_t i=0; i < num_nearest; i++)
+        {
+            out_pairs.emplace_back(std::min(a, nearest[i].second), std::max(a, nearest[i].second));
+        }
+    };
+
+    std::vector<std::pair<size_t, size_t>> pairs;
+    auto pair_remaining = [&]()
+    {
+        pairs.clear();
+        for (size_t a=0; a < hulls.size(); a++)
+        {
+            if (!merged_away[a])
+            {
+                find_pairs(a, pairs);
+            }
+        }
+
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+        push_candidates(pairs);
+    };
+
+    for (size_t i=0; i < hulls.size(); i++)
+    {
+        update_bounds(i);
+    }
+    pair_remaining();
+
+    size_t num_merged = 0;
+    bool repaired = true;
+    while (hulls.size() - num_merged > min_hulls)
+    {
+        /// Hulls whose candidates went stale are paired again once before giving up.
+        if (queue.empty())
+        {
+            if (repaired)
+            {
+                break;
+            }
+
+            repaired = true;
+            pair_remaining();
+            continue;
+        }
+
+        const MergeCandidate candidate = queue.top();
+        queue.pop();
+
+        const size_t a = candidate.hull_a;
+        const size_t b = candidate.hull_b;
+        if (merged_away[a] || merged_away[b] ||
+            versions[a] != candidate.version_a ||
+            versions[b] != candidate.version_b)
+        {
+            continue;
+        }
+
+        Mesh merged({}, {});
+        if (!merge_hulls(a, b, merged))
+        {
+            continue;
+        }
+
+        *hulls[a] = merged;
+        volumes[a] = merged.computeVolume();
+        versions[a]++;
+        merged_away[b] = 1;
+        num_merged++;
+        repaired = false;
+        update_bounds(a);
+
+        pairs.clear();
+        find_pairs(a, pairs);
+        push_candidates(pairs);
+    }
+
+    size_t write_idx = 0;
+    for (size_t i=0; i < hulls.size(); i++)
+    {
+        if (!merged_away[i])
+        {
+            hulls[write_idx++] = std::move(hulls[i]);
+        }
+    }
+    hulls.resize(write_idx);
+
+    return num_merged;
+}
+
+/// Run approximate convex decomposition of given mesh.
+/// Safe to call concurrently for different meshes.
+/// @param: max_hulls Maximum number of hulls to generate.
+/// @param: on_progress Function invoked with decomposition progress in range 0-1 and stage name.
+/// @param: out_meshes List to add newly generated collision hulls to.
+bool CollisionGen::decomposeVHACD(
+    const Mesh &mesh,
+    const CollisionGenSettings &settings,
+    int max_hulls,
+    CollisionBudget &budget,
+    const std::function<void(double progress, const char *stage)> &on_progress,
+    std::vector<std::unique_ptr<Mesh>> &out_meshes
+)
+{
+    /// Worker process keeps crashes of the decomposition library away from this process.
+    if (settings.worker_processes && CollisionWorker::isSupported())
+    {
+        const CollisionWorkerStatus status = CollisionWorker::decompose(
+            mesh,
+            settings,
+            max_hulls,
+            [this, &budget](size_t worker_memory)
+            {
+                return this->isCancelled() || budget.check(worker_memory);
+            },
+            [&on_progress](double progress)
+            {
+                on_progress(progress, "Worker decomposition");
+            },
+            out_meshes
+        );
+
+        return status == CollisionWorkerStatus::WorkerSucceeded;
+    }
+
+    VHACDProgressCallback vhacd_callback;
+
+    VHACD::IVHACD::Parameters params;
+    CollisionGen::getVHACDParameters(settings, max_hulls, params);
+    params.m_logger = &this->vhacd_logger;
+    params.m_callback = &vhacd_callback;
+
+    auto vhacd = this->acquireVHACD();
+    {
+        std::lock_guard<std::mutex> lock(this->vhacd_mutex);
+        this->active_vhacd.insert(vhacd);
+    }
+
+    /// VHACD resets its cancel state when computation starts, so any cancel request
+    /// that arrived before that point is re-issued from the progress callback.
+    /// Budget is checked on each progress update as well.
+    vhacd_callback.on_update = [this, vhacd, &budget, &on_progress](double progress, const char *stage)
+    {
+        if (this->isCancelled() || budget.check())
+        {
+            vhacd->Cancel();
+        }
+
+        on_progress(progress, stage ? stage : "");
+    };
+
+    /// Mesh buffers are passed as they are, no conversion copy is needed.
+    bool success = vhacd->Compute(
+        mesh.getPositionData().data(),
+        mesh.numVertices(),
+        mesh.getIndexData().data(),
+        mesh.numIndices() / 3,
+        params
+    );
+
+    success = success && !this->isCancelled() && !budget.isExceeded();
+    if (success)
+    {
+        unsigned int num_hulls = vhacd->GetNConvexHulls();
+        logDebug("VHACD Convex Decomposition succeeded generating {} hulls", num_hulls);
+
+        VHACD::IVHACD::ConvexHull hull;
+        for (unsigned int i=0; i < num_hulls; i++)
+        {
+            vhacd->GetConvexHull(i, hull);
+            std::vector<QVector3D> vertices;
+            std::vector<int> indices;
+
+            for (int i=0; i+2<hull.m_nPoints*3; i+=3)
+            {
+                float x = hull.m_points[i];
+                float y = hull.m_points[i+1];
+                float z = hull.m_points[i+2];
+                vertices.emplace_back(x, y, z);
+            }
+
+            for (int i=0; i<hull.m_nTriangles*3; i++)
+            {
+                indices.push_back(hull.m_triangles[i]);
+            }
+
+            out_meshes.push_back(std::make_unique<Mesh>(vertices, indices));
+            out_meshes.back()->generateNormals();
+            out_meshes.back()->computeBounds();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->vhacd_mutex);
+        this->active_vhacd.erase(vhacd);
+    }
+
+    /// Instance stays in the pool of this thread, its results and buffers are released.
+    vhacd->Clean();
+    return success;
+}
+
+/// Fill VHACD decomposition parameters from given settings.
+/// @param: max_hulls Maximum number of hulls to generate.
+/// @param: out_params Parameters to fill, logger and callback are left untouched.
+void CollisionGen::getVHACDParameters(
+    const CollisionGenSettings &settings,
+    int max_hulls,
+    VHACD::IVHACD::Parameters &out_params
+)
+{
+    out_params.m_resolution = settings.resolution;
+    out_params.m_mode = settings.mode;
+    out_params.m_concavity = settings.concavity;
+    out_params.m_maxConvexHulls = max_hulls;
+    out_params.m_maxNumVerticesPerCH = settings.max_hull_vertices;
+    out_params.m_minVolumePerCH = settings.min_hull_volume;
+    out_params.m_convexhullDownsampling = settings.downsample;
+
+    /// New version of MacOS have poor support of OpenCL a best so we disable acceleration
+    /// to avoid crashes during decomposition process.
+#if defined(__APPLE__)
+    out_params.m_oclAcceleration = false;
+#endif
+}
+
+/// Get VHACD instance owned by the calling worker thread, creating it on first use.
+/// Reuse only saves creating the instance, its decomposition buffers are released by
+/// IVHACD::Clean after each mesh and allocated again by the next decomposition.
+/// Instance must not be shared with code which may run on the same thread before it
+/// is done with it, decomposition itself never yields to other worker tasks.
+VHACD::IVHACD* CollisionGen::acquireVHACD()
+{
+    VHACD::IVHACD *&vhacd = this->vhacd_pool.local();
+    if (!vhacd)
+    {
+        vhacd = VHACD::CreateVHACD();
+    }
+
+    return vhacd;
+}
+
+/// Split mesh into its connected components, triangles sharing a vertex end up in the same
+/// component. Components are ordered by their first triangle in the source mesh.
+/// Expects a valid mesh with welded vertices, see CollisionGen::cleanupMesh.
+/// @param: out_components List to receive component meshes.
+void CollisionGen::splitConnectedComponents(const Mesh &mesh, std::vector<Mesh> &out_components)
+{
+    std::span<const QVector3D> vertices = mesh.getVertices();
+    std::span<const int> indices = mesh.getIndices();
+
+    /// Union-find over vertices using path halving and union by size.
+    std::vector<int> parent(vertices.size());
+    std::vector<int> size(vertices.size(), 1);
+    std::iota(parent.begin(), parent.end(), 0);
+
+    auto find_root = [&parent](int idx)
+    {
+        while (parent[idx] != idx)
+        {
+            parent[idx] = parent[parent[idx]];
+            idx = parent[idx];
+        }
+
+        return idx;
+    };
+
+    auto unite = [&](int a, int b)
+    {
+        a = find_root(a);
+        b = find_root(b);
+        if (a == b)
+        {
+            return;
+        }
+
+        if (size[a] < size[b])
+        {
+            std::swap(a, b);
+        }
+
+        parent[b] = a;
+        size[a] += size[b];
+    };
+
+    for (size_t i=0; i+2 < indices.size(); i+=3)
+    {
+        unite(indices[i], indices[i+1]);
+        unite(indices[i], indices[i+2]);
+    }
+
+    /// Each vertex belongs to exactly one component, so single remap table serves all components.
+    std::vector<int> root_component(vertices.size(), -1);
+    std::vector<int> vertex_remap(vertices.size(), -1);
+    std::vector<std::vector<QVector3D>> component_vertices;
+    std::vector<std::vector<int>> component_indices;
+
+    for (size_t i=0; i+2 < indices.size(); i+=3)
+    {
+        const int root = find_root(indices[i]);
+        if (root_component[root] < 0)
+        {
+            root_component[root] = component_vertices.size();
+            component_vertices.emplace_back();
+            component_indices.emplace_back();
+        }
+
+        const int component = root_component[root];
+        for (size_t j=i; j < i+3; j++)
+        {
+            const int idx = indices[j];
+            if (vertex_remap[idx] < 0)
+            {
+                vertex_remap[idx] = component_vertices[component].size();
+                component_vertices[component].push_back(vertices[idx]);
+            }
+
+            component_indices[component].push_back(vertex_remap[idx]);
+        }
+    }
+
+    out_components.clear();
+    out_components.reserve(component_vertices.size());
+    for (size_t i=0; i < component_vertices.size(); i++)
+    {
+        out_components.emplace_back(component_vertices[i], component_indices[i]);
+    }
+}
+
+/// Share hull budget between mesh components in proportion to their volume.
+/// Every component receives at least one hull, components exceeding the budget are expected
+/// to be grouped first, see CollisionGen::groupComponents.
+/// @param: max_hulls Total hull budget to share out.
+/// @param: out_hulls List to receive hull budget of each component.
+void CollisionGen::distributeHullBudget(
+    const std::vector<Mesh> &components,
+    int max_hulls,
+    std::vector<int> &out_hulls
+)
+{
+    std::vector<double> volumes;
+    volumes.reserve(components.size());
+    for (const Mesh &component : components)
+    {
+        volumes.push_back(component.computeVolume());
+    }
+
+    const double total_volume = std::accumulate(volumes.begin(), volumes.end(), 0.0);
+    const int spare_hulls = std::max(max_hulls - int(components.size()), 0);
+
+    /// Largest remainder method, one guaranteed hull plus proportional share of the rest.
+    out_hulls.assign(components.size(), 1);
+    std::vector<std::pair<double, size_t>> remainders;
+    remainders.reserve(components.size());
+
+    int assigned = 0;
+    for (size_t i=0; i < components.size(); i++)
+    {
+        const double share = total_volume > 0.0
+            ? spare_hulls * volumes[i] / total_volume
+            : double(spare_hulls) / components.size();
+
+        const int hulls = int(std::floor(share));
+        out_hulls[i] += hulls;
+        assigned += hulls;
+        remainders.emplace_back(share - hulls, i);
+    }
+
+    std::sort(remainders.begin(), remainders.end(), [](const auto &a, const auto &b)
+    {
+        return a.first > b.first;
+    });
+
+    for (size_t i=0; i < remainders.size() && assigned < spare_hulls; i++, assigned++)
+    {
+        out_hulls[remainders[i].second]++;
+    }
+}
+
+/// Group mesh components into at most given number of meshes, so each group can receive its
+/// own hull. Largest components by volume each start a group, every remaining component joins
+/// the group whose bounding box is closest to its center.
+/// @param: components Disconnected components of a mesh.
+/// @param: max_groups Maximum number of groups to create.
+/// @param: out_groups List to receive grouped meshes, equals the components if they fit.
+void CollisionGen::groupComponents(
+    const std::vector<Mesh> &components,
+    int max_groups,
+    std::vector<Mesh> &out_groups
+)
+{
+    const size_t num_groups = size_t(std::max(max_groups, 1));
+    if (components.size() <= num_groups)
+    {
+        out_groups = components;
+        return;
+    }
+
+    std::vector<double> volumes;
+    std::vector<QVector3D> bounds_min;
+    std::vector<QVector3D> bounds_max;
+    for (const Mesh &component : components)
+    {
+        QVector3D min_point(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+        QVector3D max_point = -min_point;
+        for (const QVector3D &vertex : component.getVertices())
+        {
+            min_point = QVector3D(std::min(min_point.x(), vertex.x()), std::min(min_point.y(), vertex.y()), std::min(min_point.z(), vertex.z()));
+            max_point = QVector3D(std::max(max_point.x(), vertex.x()), std::max(max_point.y(), vertex.y()), std::max(max_point.z(), vertex.z()));
+        }
+
+        volumes.push_back(component.computeVolume());
+        bounds_min.push_back(min_point);
+        bounds_max.push_back(max_point);
+    }
+
+    std::vector<size_t> order(components.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&volumes](size_t a, size_t b)
+    {
+        return volumes[a] > volumes[b];
+    });
+
+    std::vector<std::vector<size_t>> members(num_groups);
+    for (size_t i=0; i < order.size(); i++)
+    {
+        const size_t component_idx = order[i];
+        if (i < num_groups)
+        {
+            members[i].push_back(component_idx);
+            continue;
+        }
+
+        const QVector3D center = (bounds_min[component_idx] + bounds_max[component_idx]) * 0.5f;
+        size_t closest_group = 0;
+        float closest_distance = std::numeric_limits<float>::max();
+        for (size_t group_idx=0; group_idx < num_groups; group_idx++)
+        {
+            const size_t leader_idx = order[group_idx];
+            const QVector3D offset(
+                std::max({bounds_min[leader_idx].x() - center.x(), 0.0f, center.x() - bounds_max[leader_idx].x()}),
+                std::max({bounds_min[leader_idx].y() - center.y(), 0.0f, center.y() - bounds_max[leader_idx].y()}),
+                std::max({bounds_min[leader_idx].z() - center.z(), 0.0f, center.z() - bounds_max[leader_idx].z()})
+            );
+
+            const float distance = offset.lengthSquared();
+            if (distance < closest_distance)
+            {
+                closest_distance = distance;
+                closest_group = group_idx;
+            }
+        }
+
+        members[closest_group].push_back(component_idx);
+    }
+
+    out_groups.clear();
+    out_groups.reserve(num_groups);
+    for (const std::vector<size_t> &group : members)
+    {
+        std::vector<QVector3D> vertices;
+        std::vector<int> indices;
+        for (size_t component_idx : group)
+        {
+            const Mesh &component = components.at(component_idx);
+            const int base_index = int(vertices.size());
+            vertices.insert(vertices.end(), component.getVertices().begin(), component.getVertices().end());
+            for (int idx : component.getIndices())
+            {
+                indices.push_back(base_index + idx);
+            }
+        }
+
+        out_groups.emplace_back(vertices, indices);
+    }
+}
+
+/// Run exact convex decomposition for single input mesh.
+/// Disconnected volumes of the mesh are decomposed in parallel under the time budget and piece
+/// limit they share. Decomposition of a volume cannot be interrupted, so it runs in a worker
+/// process killed once the budget runs out where worker processes are available. Volumes not
+/// decomposed within the budget fall back to their hull, pieces over the limit are merged with
+/// their neighbours and the result is recorded as degraded, so it is never cached.
+/// @param: mesh_idx Index of the input mesh to process.
+/// @param: out_meshes List to add newly generated collision hulls to.
+void CollisionGen::processMeshExact(
+    size_t mesh_idx,
+    const CollisionGenSettings &settings,
+    std::vector<std::unique_ptr<Mesh>> &out_meshes
+)
+{
+    using Clock = std::chrono::steady_clock;
+
+    const Clock::time_point start_time = Clock::now();
+    const Clock::time_point deadline = start_time + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(settings.exact_time_budget)
+    );
+    const size_t max_pieces = std::max(1, settings.exact_max_pieces);
+    const size_t max_extracted = max_pieces * EXACT_PIECE_FACTOR;
+
+    const Mesh *in_mesh = this->input_meshes.at(mesh_idx);
+    logDebug("Processing exact collision for mesh of {} vertices", in_mesh->numVertices());
+    this->updateMeshProgress(mesh_idx, 0.0, "Mesh cleanup");
+
+    /// Exact cleanup already builds the volume, it is reused when the mesh is a single volume
+    /// decomposed in this process.
+    Mesh mesh(*in_mesh);
+    CGAL_NefPolyhedron volume_poly;
+    if (!this->cleanupMesh(mesh, settings, &volume_poly))
+    {
+        logError("Failed to build closed volume for exact decomposition, skipping mesh");
+        this->updateMeshProgress(mesh_idx, 1.0, "Mesh skipped");
+        return;
+    }
+
+    std::vector<Mesh> volumes;
+    CollisionGen::splitConnectedComponents(mesh, volumes);
+    logDebug("Exact decomposition split mesh into {} disconnected volumes", volumes.size());
+    this->updateMeshProgress(mesh_idx, 0.1, "Exact decomposition");
+
+    const bool use_workers = CollisionWorker::isSupported();
+    std::vector<std::vector<std::unique_ptr<Mesh>>> volume_pieces(volumes.size());
+    std::atomic<size_t> num_pieces(0);
+    std::atomic<size_t> num_done(0);
+    std::atomic<bool> out_of_time(false);
+    std::atomic<bool> failed(false);
+
+    auto should_stop = [&]()
+    {
+        if (Clock::now() > deadline)
+        {
+            out_of_time = true;
+        }
+
+        return out_of_time || num_pieces > max_extracted || this->isCancelled();
+    };
+
+    /// More volumes than pieces could ever be extracted go straight to the grouped hull fallback.
+    const bool too_many_volumes = volumes.size() > max_extracted;
+    if (!too_many_volumes)
+    {
+        tbb::parallel_for(size_t(0), volumes.size(), [&](size_t volume_idx)
+        {
+            const Mesh &volume = volumes.at(volume_idx);
+            std::vector<std::unique_ptr<Mesh>> &pieces = volume_pieces.at(volume_idx);
+
+            bool decomposed = false;
+            if (!should_stop())
+            {
+                const size_t max_volume_pieces = max_extracted - std::min<size_t>(num_pieces, max_extracted);
+                if (use_workers)
+                {
+                    const CollisionWorkerStatus status = CollisionWorker::decomposeExact(
+                        volume,
+                        int(max_volume_pieces),
+                        [&should_stop](size_t)
+                        {
+                            return should_stop();
+                        },
+                        pieces
+                    );
+                    decomposed = status == CollisionWorkerStatus::WorkerSucceeded;
+                }
+                else if (volumes.size() == 1 && !volume_poly.is_empty())
+                {
+                    decomposed = CollisionGen::decomposeVolume(volume_poly, deadline, max_volume_pieces, pieces);
+                }
+                else
+                {
+                    decomposed = CollisionGen::decomposeMeshExact(volume, deadline, max_volume_pieces, pieces);
+                }
+
+                if (!decomposed && !should_stop())
+                {
+                    failed = true;
+                }
+            }
+
+            /// Volumes not decomposed within the budget fall back to their hull.
+            if (!decomposed)
+            {
+                pieces.clear();
+
+                std::vector<CGAL_FastPoint> points;
+                CollisionGen::getMeshPoints(volume, 0.0f, points);
+
+                Mesh hull({}, {});
+                if (CollisionGen::computeConvexHull(points, hull))
+                {
+                    pieces.push_back(std::make_unique<Mesh>(hull));
+                }
+            }
+
+            num_pieces += pieces.size();
+            const double progress = 0.1 + 0.8 * double(++num_done) / volumes.size();
+            this->updateMeshProgress(mesh_idx, progress, "Exact decomposition");
+        });
+    }
+
+    if (this->isCancelled())
+    {
+        this->updateMeshProgress(mesh_idx, 1.0, "Mesh cancelled");
+        return;
+    }
+
+    CollisionDegradation degradation;
+    std::vector<std::unique_ptr<Mesh>> pieces;
+    if (too_many_volumes)
+    {
+        /// Volumes are grouped first, so the fallback never pays for merging thousands of shells.
+        std::vector<Mesh> groups;
+        CollisionGen::groupComponents(volumes, int(max_pieces), groups);
+        for (const Mesh &group : groups)
+        {
+            std::vector<CGAL_FastPoint> points;
+            CollisionGen::getMeshPoints(group, 0.0f, points);
+
+            Mesh hull({}, {});
+            if (CollisionGen::computeConvexHull(points, hull))
+            {
+                pieces.push_back(std::make_unique<Mesh>(hull));
+            }
+        }
+
+        degradation.reason = "piece_limit";
+        degradation.fallback = "component_hulls";
+    }
+    else
+    {
+        for (std::vector<std::unique_ptr<Mesh>> &volume : volume_pieces)
+        {
+            std::move(volume.begin(), volume.end(), std::back_inserter(pieces));
+        }
+
+        if (out_of_time || failed || num_pieces > max_extracted)
+        {
+            degradation.reason = out_of_time ? "time" : (failed ? "decomposition_failure" : "piece_limit");
+            degradation.fallback = "volume_hulls";
+        }
+    }
+
+    /// Enforce piece limit by merging neighbouring pieces whose merged hull adds least volume.
+    if (pieces.size() > max_pieces)
+    {
+        this->updateMeshProgress(mesh_idx, 0.9, "Merging pieces");
+        CollisionGen::mergeHulls(pieces, std::numeric_limits<double>::infinity(), max_pieces);
+        if (degradation.reason.empty())
+        {
+            degradation.reason = "piece_limit";
+            degradation.fallback = "merged_pieces";
+        }
+    }
+
+    const double duration = std::chrono::duration<double>(Clock::now() - start_time).count();
+    if (!degradation.reason.empty())
+    {
+        degradation.elapsed = duration;
+        this->recordDegradation(mesh_idx, degradation);
+        logWarning(
+            "Exact decomposition degraded by {} after {:.2f}s, using {} limited to {} pieces",
+            degradation.reason,
+            duration,
+            degradation.fallback,
+            pieces.size()
+        );
+    }
+    else
+    {
+        logDebug("Exact decomposition generated {} pieces in {:.2f}s", pieces.size(), duration);
+    }
+
+    std::move(pieces.begin(), pieces.end(), std::back_inserter(out_meshes));
+    this->updateMeshProgress(mesh_idx, 1.0, "Mesh done");
+}
+
+/// Fit analytic primitives to single input mesh.
+/// Whole mesh is covered by single primitive when one meets the tolerance, otherwise each
+/// connected component gets the cheapest primitive meeting the tolerance or its convex hull.
+/// Error of each primitive is measured against volume of the convex hull it replaces.
+/// @param: mesh_idx Index of the input mesh to process.
+/// @param: out_meshes List to add newly generated collision primitives and hulls to.
+void CollisionGen::processMeshPrimitives(
+    size_t mesh_idx,
+    const CollisionGenSettings &settings,
+    std::vector<std::unique_ptr<Mesh>> &out_meshes
+)
+{
+    const Mesh *in_mesh = this->input_meshes.at(mesh_idx);
+    logDebug("Fitting collision primitives for mesh of {} vertices", in_mesh->numVertices());
+    this->updateMeshProgress(mesh_idx, 0.0, "Fitting primitives");
+
+    /// Components are only needed for connectivity, broken meshes are fitted as a whole.
+    Mesh mesh(*in_mesh);
+    CollisionGen::weldMesh(mesh);
+
+    std::vector<Mesh> components;
+    if (Mesh::isValid(mesh))
+    {
+        CollisionGen::splitConnectedComponents(mesh, components);
+    }
+
+    if (components.empty())
+    {
+        components.push_back(*in_mesh);
+    }
+
+    /// Convex hull of each component serves as fallback and as reference volume of the error.
+    std::vector<Mesh> hulls(components.size(), Mesh({}, {}));
+    std::vector<bool> has_hull(components.size(), false);
+    std::vector<std::vector<CGAL_FastPoint>> hull_points(components.size());
+    tbb::parallel_for(size_t(0), components.size(), [&](size_t i)
+    {
+        std::vector<CGAL_FastPoint> points;
+        CollisionGen::getMeshPoints(components[i], 0.0f, points);
+        has_hull[i] = CollisionGen::computeConvexHull(points, hulls[i]);
+        if (has_hull[i])
+        {
+            CollisionGen::getMeshPoints(hulls[i], 0.0f, hull_points[i]);
+        }
+        else
+        {
+            hull_points[i] = std::move(points);
+        }
+    });
+
+    if (this->isCancelled())
+    {
+        return;
+    }
+
+    std::vector<double> hull_volumes(components.size(), 0.0);
+    for (size_t i=0; i < components.size(); i++)
+    {
+        hull_volumes[i] = has_hull[i] ? hulls[i].computeVolume() : 0.0;
+    }
+
+    if (components.size() > 1)
+    {
+        std::vector<CGAL_FastPoint> points;
+        for (const std::vector<CGAL_FastPoint> &component_points : hull_points)
+        {
+            points.insert(points.end(), component_points.begin(), component_points.end());
+        }
+
+        const double volume = std::accumulate(hull_volumes.begin(), hull_volumes.end(), 0.0);
+        MeshPrimitive primitive;
+        double error = 0.0;
+        if (volume > 0.0 &&
+            CollisionPrimitives::fitCheapest(points, volume, settings.primitive_tolerance, primitive, error))
+        {
+            logDebug(
+                "Fitted single {} to {} components with {:.2f}% error",
+                CollisionPrimitives::getTypeName(primitive.type),
+                components.size(),
+                error * 100.0
+            );
+
+            out_meshes.push_back(std::make_unique<Mesh>(Mesh({}, {})));
+            CollisionPrimitives::tessellate(primitive, *out_meshes.back());
+            this->updateMeshProgress(mesh_idx, 1.0, "Mesh done");
+            return;
+        }
+    }
+
+    std::vector<std::unique_ptr<Mesh>> pieces(components.size());
+    std::vector<int> piece_types(components.size(), MeshPrimitiveType::NoPrimitive);
+    tbb::parallel_for(size_t(0), components.size(), [&](size_t i)
+    {
+        MeshPrimitive primitive;
+        double error = 0.0;
+        if (CollisionPrimitives::fitCheapest(hull_points[i], hull_volumes[i], settings.primitive_tolerance, primitive, error))
+        {
+            pieces[i] = std::make_unique<Mesh>(Mesh({}, {}));
+            CollisionPrimitives::tessellate(primitive, *pieces[i]);
+            piece_types[i] = primitive.type;
+        }
+        else if (has_hull[i])
+        {
+            pieces[i] = std::make_unique<Mesh>(hulls[i]);
+        }
+    });
+
+    std::array<size_t, 4> type_counts = {0, 0, 0, 0};
+    for (size_t i=0; i < pieces.size(); i++)
+    {
+        if (pieces[i])
+        {
+            type_counts.at(piece_types[i])++;
+            out_meshes.push_back(std::move(pieces[i]));
+        }
+    }
+
+    logDebug(
+        "Fitted {} boxes, {} spheres, {} capsules and {} hulls to {} components",
+        type_counts[MeshPrimitiveType::BoxPrimitive],
+        type_counts[MeshPrimitiveType::SpherePrimitive],
+        type_counts[MeshPrimitiveType::CapsulePrimitive],
+        type_counts[MeshPrimitiveType::NoPrimitive],
+        components.size()
+    );
+
+    this->updateMeshProgress(mesh_idx, 1.0, "Mesh done");
+}
+
+/// Approximate single input mesh by compound of boxes.
+/// Cleaned mesh is voxelized, interior is filled and solid voxels are greedily merged into boxes.
+/// Voxel resolution is lowered until the boxes fit the box limit. Boxes follow the world axes or
+/// the oriented bounding box of the mesh.
+/// @param: mesh_idx Index of the input mesh to process.
+/// @param: out_meshes List to add newly generated collision boxes to.
+void CollisionGen::processMeshVoxelBoxes(
+    size_t mesh_idx,
+    const CollisionGenSettings &settings,
+    std::vector<std::unique_ptr<Mesh>> &out_meshes
+)
+{
+    const Mesh *in_mesh = this->input_meshes.at(mesh_idx);
+    logDebug("Processing voxel boxes for mesh of {} vertices", in_mesh->numVertices());
+    this->updateMeshProgress(mesh_idx, 0.0, "Mesh cleanup");
+
+    /// Voxelization tolerates small holes, so mesh which fails to close is still usable.
+    Mesh mesh(*in_mesh);
+    if (!CollisionGen::cleanupMesh(mesh, settings))
+    {
+        logWarning("Failed to build closed volume, voxelizing mesh as is");
+        mesh = *in_mesh;
+    }
+
+    MeshPrimitive frame;
+    if (settings.oriented_boxes)
+    {
+        std::vector<CGAL_FastPoint> points;
+        CollisionGen::getMeshPoints(mesh, 0.0f, points);
+        if (!CollisionPrimitives::fitBox(points, frame))
+        {
+            frame = MeshPrimitive();
+        }
+    }
+
+    const QQuaternion to_local = frame.rotation.conjugated();
+    std::vector<QVector3D> local_vertices;
+    local_vertices.reserve(mesh.numVertices());
+    for (const QVector3D &vertex : mesh.getVertices())
+    {
+        local_vertices.push_back(to_local.rotatedVector(vertex - frame.center));
+    }
+
+    VoxelGrid grid;
+    std::vector<VoxelBox> boxes;
+    int resolution = std::max(settings.voxel_resolution, MIN_VOXEL_RESOLUTION);
+    const size_t max_boxes = std::max(settings.max_boxes, 1);
+    while (!this->isCancelled())
+    {
+        this->updateMeshProgress(mesh_idx, 0.5, "Voxelizing");
+        CollisionVoxelizer::initGrid(local_vertices, resolution, grid);
+        CollisionVoxelizer::voxelizeSurface(local_vertices, mesh.getIndices(), grid);
+        const size_t num_filled = CollisionVoxelizer::fillInterior(grid);
+        CollisionVoxelizer::mergeBoxes(grid, boxes);
+
+        logDebug(
+            "Voxelized mesh into {}x{}x{} grid, filled {} interior voxels, merged into {} boxes",
+            grid.size[0],
+            grid.size[1],
+            grid.size[2],
+            num_filled,
+            boxes.size()
+        );
+
+        if (boxes.size() <= max_boxes || resolution <= MIN_VOXEL_RESOLUTION)
+        {
+            break;
+        }
+
+        resolution = std::max(int(resolution * VOXEL_COARSEN_FACTOR), MIN_VOXEL_RESOLUTION);
+    }
+
+    if (this->isCancelled())
+    {
+        return;
+    }
+
+    if (boxes.size() > max_boxes)
+    {
+        const size_t num_boxes = boxes.size();
+        const size_t added_volume = CollisionVoxelizer::limitBoxes(boxes, max_boxes);
+        logDebug(
+            "Merged {} voxel boxes into {} at the lowest resolution, adding {} empty voxels",
+            num_boxes,
+            boxes.size(),
+            added_volume
+        );
+    }
+
+    for (const VoxelBox &box : boxes)
+    {
+        QVector3D local_min;
+        QVector3D local_max;
+        for (int axis=0; axis < 3; axis++)
+        {
+            local_min[axis] = grid.origin[axis] + box.min[axis] * grid.voxel_size;
+            local_max[axis] = grid.origin[axis] + (box.max[axis] + 1) * grid.voxel_size;
+        }
+
+        MeshPrimitive primitive;
+        primitive.type = MeshPrimitiveType::BoxPrimitive;
+        primitive.center = frame.center + frame.rotation.rotatedVector((local_min + local_max) * 0.5f);
+        primitive.rotation = frame.rotation;
+        primitive.half_extents = (local_max - local_min) * 0.5f;
+
+        out_meshes.push_back(std::make_unique<Mesh>(Mesh({}, {})));
+        CollisionPrimitives::tessellate(primitive, *out_meshes.back());
+    }
+
+    this->updateMeshProgress(mesh_idx, 1.0, "Mesh done");
+}
+
+/// Generate list of all vertex position across all input meshes.
+/// @param: padding Normalized padding value relative to bounding sphere diameter of each input mesh.
+std::vector<CGAL_FastPoint> CollisionGen::getInputPoints(float padding) const
+{
+    size_t num_points = 0;
+    for (const Mesh *mesh : this->input_meshes)
+    {
+        num_points += mesh->numVertices();
+    }
+
+    std::vector<CGAL_FastPoint> points;
+    points.reserve(num_points);
+    for (const Mesh *mesh : this->input_meshes)
+    {
+        CollisionGen::getMeshPoints(*mesh, padding, points);
+    }
+
+    return points;
+}
+
+/// Append vertex positions of given mesh to list of points.
+/// @param: mesh Mesh to fetch vertex positions from.
+/// @param: padding Normalized padding value relative to bounding sphere diameter of the mesh.
+/// @param: out_points List to append points to.
+void CollisionGen::getMeshPoints(const Mesh &mesh, float padding, std::vector<CGAL_FastPoint> &out_points)
+{
+    const QVector3D center = mesh.getBoundingSphereCenter();
+    const double diameter = mesh.getBoundingSphereRadius() * 2;
+    const float offset = padding * diameter;
+
+    const size_t first = out_points.size();
+    out_points.resize(first + mesh.numVertices());
+
+    std::span<const QVector3D> vertices = mesh.getVertices();
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, vertices.size()), [&](const tbb::blocked_range<size_t> &range)
+    {
+        for (size_t i = range.begin(); i < range.end(); i++)
+        {
+            QVector3D point = vertices[i];
+            if (qAbs(padding) > 0.0)
+            {
+                QVector3D padding_dir = (point - center).normalized();
+                point += padding_dir * offset;
+            }
+
+            out_points[first + i] = CGAL_FastPoint(point.x(), point.y(), point.z());
+        }
+    });
+}
+
+/// Compute convex hull of given points.
+/// Points are first culled against the hull of their extreme points along fixed set of
+/// directions, which discards most interior points in parallel before running quickhull.
+/// @param: points Points to compute hull for.
+/// @param: out_mesh Reference to mesh to store the hull in.
+bool CollisionGen::computeConvexHull(const std::vector<CGAL_FastPoint> &points, Mesh &out_mesh)
+{
+    if (points.size() < 4)
+    {
+        return false;
+    }
+
+    /// Extreme points along face, edge and corner directions of a cube (26-DOP).
+    static const std::array<std::array<double, 3>, 13> directions = {{
+        {1, 0, 0}, {0, 1, 0}, {0, 0, 1},
+        {1, 1, 0}, {1, -1, 0}, {1, 0, 1}, {1, 0, -1}, {0, 1, 1}, {0, 1, -1},
+        {1, 1, 1}, {1, 1, -1}, {1, -1, 1}, {1, -1, -1}
+    }};
+
+    struct Extremes
+    {
+        std::array<size_t, 13> min_idx;
+        std::array<size_t, 13> max_idx;
+        std::array<double, 13> min_val;
+        std::array<double, 13> max_val;
+
+        Extremes()
+        {
+            min_idx.fill(0);
+            max_idx.fill(0);
+            min_val.fill(std::numeric_limits<double>::max());
+            max_val.fill(std::numeric_limits<double>::lowest());
+        }
+    };
+
+    Extremes extremes = tbb::parallel_reduce(
+        tbb::blocked_range<size_t>(0, points.size()),
+        Extremes(),
+        [&](const tbb::blocked_range<size_t> &range, Extremes local)
+        {
+            for (size_t i = range.begin(); i < range.end(); i++)
+            {
+                const CGAL_FastPoint &p = points[i];
+                for (size_t d = 0; d < directions.size(); d++)
+                {
+                    const double value = p.x() * directions[d][0] + p.y() * directions[d][1] + p.z() * directions[d][2];
+                    if (value < local.min_val[d])
+                    {
+                        local.min_val[d] = value;
+                        local.min_idx[d] = i;
+                    }
+                    if (value > local.max_val[d])
+                    {
+                        local.max_val[d] = value;
+                        local.max_idx[d] = i;
+                    }
+                }
+            }
+            return local;
+        },
+        [&](Extremes a, const Extremes &b)
+        {
+            for (size_t d = 0; d < directions.size(); d++)
+            {
+                if (b.min_val[d] < a.min_val[d])
+                {
+                    a.min_val[d] = b.min_val[d];
+                    a.min_idx[d] = b.min_idx[d];
+                }
+                if (b.max_val[d] > a.max_val[d])
+                {
+                    a.max_val[d] = b.max_val[d];
+                    a.max_idx[d] = b.max_idx[d];
+                }
+            }
+            return a;
+        }
+    );
+
+    std::vector<CGAL_FastPoint> extreme_points;
+    for (size_t d = 0; d < directions.size(); d++)
+    {
+        extreme_points.push_back(points[extremes.min_idx[d]]);
+        extreme_points.push_back(points[extremes.max_idx[d]]);
+    }
+
+    /// Build culling planes from the hull of the extreme points.
+    /// Plane normals point outwards so interior points are on the negative side of all planes.
+    CGAL_FastSurface extreme_hull;
+    CGAL::convex_hull_3(extreme_points.begin(), extreme_points.end(), extreme_hull);
+
+    std::vector<std::array<double, 4>> planes;
+    for (const CGAL_FastSurface::Face_index &face : extreme_hull.faces())
+    {
+        std::array<CGAL_FastPoint, 3> tri;
+        CGAL_FastSurface::Halfedge_index edge = extreme_hull.halfedge(face);
+        for (int i=0; i<3; i++)
+        {
+            tri[i] = extreme_hull.point(extreme_hull.target(edge));
+            edge = extreme_hull.next(edge);
+        }
+
+        CGAL_FastKernel::Vector_3 normal = CGAL::cross_product(tri[1] - tri[0], tri[2] - tri[0]);
+        const double length = std::sqrt(normal.squared_length());
+        if (length <= 0.0)
+        {
+            continue;
+        }
+
+        normal = normal / length;
+        const double offset = -(normal * (tri[0] - CGAL::ORIGIN));
+        planes.push_back({normal.x(), normal.y(), normal.z(), offset});
+    }
+
+    /// Keep points which are on or outside of any culling plane, small tolerance
+    /// keeps points lying on the extreme hull itself.
+    const double epsilon = 1e-9 * (extremes.max_val[0] - extremes.min_val[0] + 1.0);
+    std::vector<char> keep(points.size(), 1);
+    if (planes.size() >= 4)
+    {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, points.size()), [&](const tbb::blocked_range<size_t> &range)
+        {
+            for (size_t i = range.begin(); i < range.end(); i++)
+            {
+                const CGAL_FastPoint &p = points[i];
+                bool inside = true;
+                for (const std::array<double, 4> &plane : planes)
+                {
+                    if (plane[0] * p.x() + plane[1] * p.y() + plane[2] * p.z() + plane[3] > -epsilon)
+                    {
+                        inside = false;
+                        break;
+                    }
+                }
+                keep[i] = !inside;
+            }
+        });
+    }
+
+    std::vector<CGAL_FastPoint> hull_points;
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        if (keep[i])
+        {
+            hull_points.push_back(points[i]);
+        }
+    }
+
+    CGAL_FastSurface hull;
+    CGAL::convex_hull_3(hull_points.begin(), hull_points.end(), hull);
+    if (hull.number_of_faces() == 0)
+    {
+        return false;
+    }
+
+    CollisionGen::meshFromSurface(hull, out_mesh);
+
+    return true;
+}
+
+/// Clean up given mesh to ensure consistent winding order and water tightness.
+/// Fast and alpha wrap cleanup modes fall back to exact cleanup if they cannot produce closed
+/// valid volume. Alpha wrap size is given in approximate decomposition voxels.
+/// @param: mesh Mesh to clean up in place.
+/// @param: settings Settings selecting cleanup technique to use.
+/// @param: out_volume Receives cleaned up volume if exact cleanup built one, left untouched otherwise.
+/// @param: welded Mesh was already welded by the caller, so welding is skipped.
+bool CollisionGen::cleanupMesh(
+    Mesh &mesh,
+    const CollisionGenSettings &settings,
+    CGAL_NefPolyhedron *out_volume,
+    bool welded
+)
+{
+    const MeshCleanupMode mode = static_cast<MeshCleanupMode>(settings.cleanup_mode);
+
+    /// Welded mesh is kept even if the repair below fails, so the mesh is still usable.
+    if (!welded)
+    {
+        CollisionGen::weldMesh(mesh);
+    }
+
+    if (mode == MeshCleanupMode::AlphaWrapCleanup)
+    {
+        const double voxel_size = CollisionGen::getVoxelSize(mesh, settings.resolution);
+        if (CollisionGen::wrapMesh(mesh, settings.wrap_alpha * voxel_size, settings.wrap_offset * voxel_size))
+        {
+            return true;
+        }
+
+        logWarning("Alpha wrap failed, falling back to exact cleanup");
+    }
+
+    if (mode == MeshCleanupMode::FastCleanup)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        bool success = CollisionGen::cleanupMeshFast(mesh);
+        auto end_time = std::chrono::steady_clock::now();
+        double duration = std::chrono::duration<double>(end_time - start_time).count();
+
+        if (success)
+        {
+            logDebug("Fast mesh cleanup finished in {:.3f}s", duration);
+            return true;
+        }
+
+        logWarning("Fast mesh cleanup failed after {:.3f}s, falling back to exact cleanup", duration);
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    bool success = CollisionGen::cleanupMeshExact(mesh, out_volume);
+    auto end_time = std::chrono::steady_clock::now();
+    double duration = std::chrono::duration<double>(end_time - start_time).count();
+    if (!success)
+    {
+        logWarning("Exact mesh cleanup failed after {:.3f}s", duration);
+        return false;
+    }
+
+    logDebug("Exact mesh cleanup finished in {:.3f}s", duration);
+    return true;
+}
+
+/// Weld vertices closer than weld tolerance and remove degenerate triangles.
+/// Vertices are bucketed in a grid and merged into the first earlier vertex within tolerance
+/// found in their own or neighbouring cells. Triangles which collapse or have near zero area
+/// are dropped along with vertices no longer referenced. Order of remaining vertices
+/// and triangles is preserved.
+/// @param: mesh Mesh to weld in place.
+void CollisionGen::weldMesh(Mesh &mesh)
+{
+    std::span<const QVector3D> vertices = mesh.getVertices();
+    std::span<const int> indices = mesh.getIndices();
+    const size_t num_vertices = vertices.size();
+    const size_t num_triangles = indices.size() / 3;
+    if (num_vertices == 0 || num_triangles == 0)
+    {
+        return;
+    }
+
+    QVector3D min_bound = vertices.front();
+    QVector3D max_bound = vertices.front();
+    for (const QVector3D &vertex : vertices)
+    {
+        for (int axis=0; axis < 3; axis++)
+        {
+            min_bound[axis] = std::min(min_bound[axis], vertex[axis]);
+            max_bound[axis] = std::max(max_bound[axis], vertex[axis]);
+        }
+    }
+
+    const float diagonal = (max_bound - min_bound).length();
+    const float tolerance = std::max(diagonal * WELD_TOLERANCE, std::numeric_limits<float>::min());
+    const float min_area = std::max(diagonal * diagonal * DEGENERATE_AREA, std::numeric_limits<float>::min());
 
-CollisionGen::CollisionGen()
-{
-}
+    /// Cells are twice the tolerance, so vertices within tolerance of each other are always
+    /// found in the cell of the vertex or its neighbour on the side of the closer cell boundary.
+    const float cell_size = tolerance * 2.0f;
+    std::vector<std::array<int64_t, 3>> cells(num_vertices);
+    std::vector<std::array<int, 3>> neighbour_sides(num_vertices);
+    tbb::parallel_for(size_t(0), num_vertices, [&](size_t idx)
+    {
+        const QVector3D offset = (vertices[idx] - min_bound) / cell_size;
+        for (int axis=0; axis < 3; axis++)
+        {
+            const float cell = std::floor(offset[axis]);
+            cells[idx][axis] = int64_t(cell);
+            neighbour_sides[idx][axis] = offset[axis] - cell < 0.5f ? -1 : 1;
+        }
+    });
 
-/// Adds new mesh to use as input for collision generation process.
-void CollisionGen::addInputMesh(const Mesh *mesh)
-{
-    this->input_meshes.push_back(mesh);
-}
+    /// Group vertices by sorting them by cell, vertices of each cell stay in index order.
+    std::vector<int> order(num_vertices);
+    std::iota(order.begin(), order.end(), 0);
+    tbb::parallel_sort(order.begin(), order.end(), [&cells](int a, int b)
+    {
+        return cells[a] < cells[b] || (cells[a] == cells[b] && a < b);
+    });
 
-/// Remove all input meshes.
-void CollisionGen::clearInputMeshes()
-{
-    this->input_meshes.clear();
-}
+    /// Find first earlier vertex within tolerance of each vertex in the 2x2x2 block of cells.
+    const float tolerance_sq = tolerance * tolerance;
+    std::vector<int> closest_earlier(num_vertices, -1);
+    tbb::parallel_for(size_t(0), num_vertices, [&](size_t idx)
+    {
+        int found = -1;
+        for (int block=0; block < 8; block++)
+        {
+            std::array<int64_t, 3> cell = cells[idx];
+            for (int axis=0; axis < 3; axis++)
+            {
+                cell[axis] += (block >> axis) & 1 ? neighbour_sides[idx][axis] : 0;
+            }
 
-/// Generate collection of hull meshes which envelop all active input meshes using 
-/// approximate convex decomposition technique via VHACD.
-/// @param: out_meshes List to add newly generated collision hulls to.
-void CollisionGen::generateVHACD(
-    const CollisionGenSettings &settings,
-    std::vector<std::unique_ptr<Mesh>> &out_meshes
-)
-{
-    for (const Mesh *in_mesh : this->input_meshes)
+            auto it = std::lower_bound(order.begin(), order.end(), cell, [&cells](int vertex, const std::array<int64_t, 3> &value)
+            {
+                return cells[vertex] < value;
+            });
+
+            const int limit = found < 0 ? int(idx) : found;
+            for (; it != order.end() && cells[*it] == cell && *it < limit; ++it)
+            {
+                if ((vertices[*it] - vertices[idx]).lengthSquared() <= tolerance_sq)
+                {
+                    found = *it;
+                    break;
+                }
+            }
+        }
+
+        closest_earlier[idx] = found;
+    });
+
+    /// Vertices merge into representative of the earlier vertex if it is within tolerance as well,
+    /// so welding never chains vertices further apart than the tolerance.
+    std::vector<int> representative(num_vertices);
+    for (size_t idx=0; idx < num_vertices; idx++)
     {
-        logDebug("Processing approximate collision for mesh of {} vertices", in_mesh->numVertices());
+        const int earlier = closest_earlier[idx];
+        representative[idx] = idx;
+        if (earlier >= 0)
+        {
+            const int candidate = representative[earlier];
+            if ((vertices[candidate] - vertices[idx]).lengthSquared() <= tolerance_sq)
+            {
+                representative[idx] = candidate;
+            }
+        }
+    }
 
-        Mesh mesh(*in_mesh);
-        CollisionGen::cleanupMesh(mesh);
-        if (!Mesh::isValid(mesh))
+    /// Remap triangles to representatives and flag the ones which remain valid.
+    std::vector<int> welded_indices(num_triangles * 3);
+    std::vector<char> keep_triangle(num_triangles, 0);
+    tbb::parallel_for(size_t(0), num_triangles, [&](size_t tri)
+    {
+        std::array<int, 3> tri_indices;
+        for (int i=0; i < 3; i++)
         {
-            logError("Encountered degenerate input mesh data, skipping mesh");
-            continue;
+            const int idx = indices[tri*3 + i];
+            if (idx < 0 || idx >= int(num_vertices))
+            {
+                return;
+            }
+
+            tri_indices[i] = representative[idx];
+            welded_indices[tri*3 + i] = tri_indices[i];
         }
 
-        std::vector<float> points;
-        points.reserve(mesh.numVertices() * 3);
-        for (const QVector3D &vertex : mesh.getVertices())
+        if (tri_indices[0] == tri_indices[1] ||
+            tri_indices[1] == tri_indices[2] ||
+            tri_indices[0] == tri_indices[2])
         {
-            points.push_back(vertex.x());
-            points.push_back(vertex.y());
-            points.push_back(vertex.z());
+            return;
         }
 
-        std::vector<unsigned int> indices;
-        indices.reserve(mesh.numIndices());
-        for (const int &idx : mesh.getIndices())
+        const QVector3D ab = vertices[tri_indices[1]] - vertices[tri_indices[0]];
+        const QVector3D ac = vertices[tri_indices[2]] - vertices[tri_indices[0]];
+        if (QVector3D::crossProduct(ab, ac).length() * 0.5 < min_area)
         {
-            indices.push_back(idx);
+            return;
         }
 
-        VHACD::IVHACD::Parameters params;
-        params.m_resolution = settings.resolution;
-        params.m_mode = settings.mode;
-        params.m_concavity = settings.concavity;
-        params.m_maxConvexHulls = settings.max_hulls;
-        params.m_maxNumVerticesPerCH = settings.max_hull_vertices;
-        params.m_minVolumePerCH = settings.min_hull_volume;
-        params.m_convexhullDownsampling = settings.downsample;
-        params.m_logger = &this->vhacd_logger;
-        
-        /// New version of MacOS have poor support of OpenCL a best so we disable acceleration
-        /// to avoid crashes during decomposition process.
-#if defined(__APPLE__)
-        params.m_oclAcceleration = false;
-#endif
+        keep_triangle[tri] = 1;
+    });
 
-        auto vhacd = VHACD::CreateVHACD();
-        bool success = vhacd->Compute(
-            points.data(),
-            mesh.numVertices(),
-            indices.data(),
-            mesh.numIndices() / 3,
-            params
-        );
+    /// Compact remaining triangles and vertices they reference.
+    std::vector<int> vertex_remap(num_vertices, -1);
+    std::vector<QVector3D> out_vertices;
+    std::vector<int> out_indices;
+    out_indices.reserve(welded_indices.size());
 
-        if (success)
+    for (size_t tri=0; tri < num_triangles; tri++)
+    {
+        if (!keep_triangle[tri])
         {
-            unsigned int num_hulls = vhacd->GetNConvexHulls();
-            logDebug("VHACD Convex Decomposition succeeded generating {} hulls", num_hulls);
+            continue;
+        }
 
-            VHACD::IVHACD::ConvexHull hull;
-            for (unsigned int i=0; i < num_hulls; i++)
+        for (int i=0; i < 3; i++)
+        {
+            const int idx = welded_indices[tri*3 + i];
+            if (vertex_remap[idx] < 0)
             {
-                vhacd->GetConvexHull(i, hull);
-                std::vector<QVector3D> vertices;
-                std::vector<int> indices;
+                vertex_remap[idx] = out_vertices.size();
+                out_vertices.push_back(vertices[idx]);
+            }
 
-                for (int i=0; i+2<hull.m_nPoints*3; i+=3)
-                {
-                    float x = hull.m_points[i];
-                    float y = hull.m_points[i+1];
-                    float z = hull.m_points[i+2];
-                    vertices.emplace_back(x, y, z);
-                }
+            out_indices.push_back(vertex_remap[idx]);
+        }
+    }
 
-                for (int i=0; i<hull.m_nTriangles*3; i++)
-                {
-                    indices.push_back(hull.m_triangles[i]);
-                }
+    logDebug(
+        "Welded mesh from {} to {} vertices and {} to {} triangles",
+        num_vertices,
+        out_vertices.size(),
+        num_triangles,
+        out_indices.size() / 3
+    );
 
-                out_meshes.push_back(std::make_unique<Mesh>(vertices, indices));
-                out_meshes.back()->generateNormals();
-                out_meshes.back()->computeBounds();
-            }
+    mesh = Mesh(out_vertices, out_indices);
+    mesh.generateNormals();
+    mesh.computeBounds();
+}
+
+/// Get edge length of voxels approximate decomposition splits mesh bounding box into.
+/// @param: resolution Total number of voxels as used by VHACD.
+double CollisionGen::getVoxelSize(const Mesh &mesh, double resolution)
+{
+    std::span<const QVector3D> vertices = mesh.getVertices();
+    if (vertices.empty() || resolution <= 0.0)
+    {
+        return 0.0;
+    }
+
+    QVector3D min_bound = vertices.front();
+    QVector3D max_bound = vertices.front();
+    for (const QVector3D &vertex : vertices)
+    {
+        for (int axis=0; axis < 3; axis++)
+        {
+            min_bound[axis] = std::min(min_bound[axis], vertex[axis]);
+            max_bound[axis] = std::max(max_bound[axis], vertex[axis]);
         }
+    }
 
-        vhacd->Clean();
-        vhacd->Release();
+    const QVector3D extent = max_bound - min_bound;
+    const double volume = double(extent.x()) * extent.y() * extent.z();
+    if (volume <= 0.0)
+    {
+        return extent.length() / std::cbrt(resolution);
     }
+
+    return std::cbrt(volume / resolution);
 }
 
-/// Generate list of all vertex position across all input meshes.
-/// @param: padding Normalized padding value relative to bounding sphere diameter of each input mesh.
-std::vector<CGAL_Point> CollisionGen::getInputPoints(float padding) const
+/// Simplify mesh using quadric error edge collapse until the next collapse would
+/// exceed given error. Mesh is left unchanged if it cannot be simplified.
+/// @param: mesh Mesh to simplify in place, expected to have welded vertices.
+/// @param: max_error Maximum quadric error expressed as distance in mesh units.
+/// Returns true if the mesh was simplified.
+bool CollisionGen::decimateMesh(Mesh &mesh, double max_error)
 {
-    std::vector<CGAL_Point> points;
-    for (const Mesh *mesh : this->input_meshes)
+    namespace PMP = CGAL::Polygon_mesh_processing;
+    namespace SMS = CGAL::Surface_mesh_simplification;
+
+    if (max_error <= 0.0 || mesh.numIndices() < 3)
+    {
+        return false;
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    std::vector<CGAL_FastPoint> points;
+    std::vector<std::array<std::size_t, 3>> faces;
+    points.reserve(mesh.numVertices());
+    faces.reserve(mesh.numIndices() / 3);
+
+    for (const QVector3D &vertex : mesh.getVertices())
     {
-        const QVector3D center = mesh->getBoundingSphereCenter();
-        const double diameter = mesh->getBoundingSphereRadius() * 2;
+        points.emplace_back(vertex.x(), vertex.y(), vertex.z());
+    }
+
+    std::span<const int> indices = mesh.getIndices();
+    for (size_t i=0; i+2 < indices.size(); i+=3)
+    {
+        faces.push_back({
+            std::size_t(indices[i]),
+            std::size_t(indices[i+1]),
+            std::size_t(indices[i+2])
+        });
+    }
+
+    PMP::orient_polygon_soup(points, faces);
+    CGAL_FastSurface surface;
+    PMP::polygon_soup_to_polygon_mesh(points, faces, surface);
+    if (!CGAL::is_valid_polygon_mesh(surface) || !CGAL::is_triangle_mesh(surface))
+    {
+        logDebug("Skipping decimation of mesh which is not a valid triangle mesh");
+        return false;
+    }
 
-        for (const QVector3D &vertex : mesh->getVertices())
+    /// Quadric cost is a squared distance, collapses stop once it exceeds the error bound.
+    /// Stop predicate is copied by edge collapse, so the largest accepted cost lives outside.
+    const double max_cost = max_error * max_error;
+    double accepted_cost = 0.0;
+    auto stop_predicate = [max_cost, &accepted_cost](
+        const double &cost,
+        const auto &profile,
+        std::size_t initial_count,
+        std::size_t current_count
+    )
+    {
+        if (cost > max_cost)
         {
-            if (qAbs(padding) > 0.0)
-            {
-                QVector3D padding_dir = (vertex - center).normalized();
-                QVector3D point = vertex + padding_dir * padding * diameter;
-                points.emplace_back(point.x(), point.y(), point.z());
-            }
-            else
-            {
-                points.emplace_back(vertex.x(), vertex.y(), vertex.z());
-            }
+            return true;
         }
+
+        accepted_cost = std::max(accepted_cost, cost);
+        return false;
+    };
+
+    const size_t initial_triangles = surface.number_of_faces();
+    SMS::GarlandHeckbert_plane_policies<CGAL_FastSurface, CGAL_FastKernel> policies(surface);
+    SMS::edge_collapse(
+        surface,
+        stop_predicate,
+        CGAL::parameters::get_cost(policies.get_cost()).get_placement(policies.get_placement())
+    );
+    surface.collect_garbage();
+
+    if (surface.number_of_faces() == 0)
+    {
+        logWarning("Decimation collapsed whole mesh, keeping original mesh");
+        return false;
     }
 
-    return points;
+    CollisionGen::meshFromSurface(surface, mesh);
+
+    auto end_time = std::chrono::steady_clock::now();
+    double duration = std::chrono::duration<double>(end_time - start_time).count();
+    const size_t final_triangles = mesh.numIndices() / 3;
+    logInfo(
+        "Decimated mesh from {} to {} triangles ({:.1f}x triangle reduction) in {:.3f}s, max error {:.6f} of {:.6f} bound",
+        initial_triangles,
+        final_triangles,
+        double(initial_triangles) / std::max<size_t>(final_triangles, 1),
+        duration,
+        std::sqrt(accepted_cost),
+        max_error
+    );
+
+    return true;
 }
 
-/// Clean up given mesh to ensure consistent winding order and water tightness.
-bool CollisionGen::cleanupMesh(Mesh &mesh)
+/// Replace mesh with watertight manifold wrap enclosing it at given offset.
+/// Wrap tolerates open, intersecting and non-manifold input, so it never needs nef polyhedra.
+/// Disconnected components are wrapped independently and in parallel, mesh is left unchanged
+/// if any of them fails to wrap.
+/// @param: mesh Mesh to wrap in place, expected to have welded vertices.
+/// @param: alpha Size of the carving ball, smaller values follow concavities more closely.
+/// @param: offset Distance of the wrap from the input surface.
+/// Returns true if the mesh was replaced by its wrap.
+bool CollisionGen::wrapMesh(Mesh &mesh, double alpha, double offset)
+{
+    if (alpha <= 0.0 || offset <= 0.0 || mesh.numIndices() < 3)
+    {
+        return false;
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<Mesh> components;
+    CollisionGen::splitConnectedComponents(mesh, components);
+
+    std::vector<Mesh> wraps(components.size(), Mesh({}, {}));
+    std::atomic<size_t> num_failed(0);
+    tbb::parallel_for(size_t(0), components.size(), [&](size_t component_idx)
+    {
+        const Mesh &component = components.at(component_idx);
+
+        std::vector<CGAL_FastPoint> points;
+        std::vector<std::array<std::size_t, 3>> faces;
+        points.reserve(component.numVertices());
+        faces.reserve(component.numIndices() / 3);
+
+        for (const QVector3D &vertex : component.getVertices())
+        {
+            points.emplace_back(vertex.x(), vertex.y(), vertex.z());
+        }
+
+        std::span<const int> indices = component.getIndices();
+        for (size_t i=0; i+2 < indices.size(); i+=3)
+        {
+            faces.push_back({
+                std::size_t(indices[i]),
+                std::size_t(indices[i+1]),
+                std::size_t(indices[i+2])
+            });
+        }
+
+        CGAL_FastSurface wrap;
+        CGAL::alpha_wrap_3(points, faces, alpha, offset, wrap);
+        if (!CGAL::is_closed(wrap) || wrap.number_of_faces() == 0)
+        {
+            num_failed++;
+            return;
+        }
+
+        CollisionGen::meshFromSurface(wrap, wraps.at(component_idx));
+    });
+
+    /// Dropping a component would lose its collision and keeping it unwrapped would leave the
+    /// mesh open, so the mesh is left unchanged for another cleanup technique instead.
+    if (num_failed > 0)
+    {
+        logWarning(
+            "Alpha wrap failed for {} of {} mesh components, mesh left unwrapped",
+            size_t(num_failed),
+            components.size()
+        );
+        return false;
+    }
+
+    std::vector<QVector3D> vertices;
+    std::vector<int> indices;
+    for (const Mesh &wrap : wraps)
+    {
+        const int base_index = vertices.size();
+        vertices.insert(vertices.end(), wrap.getVertices().begin(), wrap.getVertices().end());
+        for (int idx : wrap.getIndices())
+        {
+            indices.push_back(base_index + idx);
+        }
+    }
+
+    if (indices.empty())
+    {
+        logWarning("Alpha wrap of {} mesh components produced no closed surface", components.size());
+        return false;
+    }
+
+    const size_t initial_triangles = mesh.numIndices() / 3;
+    mesh = Mesh(vertices, indices);
+    mesh.generateNormals();
+    mesh.computeBounds();
+
+    auto end_time = std::chrono::steady_clock::now();
+    double duration = std::chrono::duration<double>(end_time - start_time).count();
+    logDebug(
+        "Wrapped {} mesh components of {} triangles into {} triangles in {:.3f}s, alpha {:.6f}, offset {:.6f}",
+        components.size(),
+        initial_triangles,
+        indices.size() / 3,
+        duration,
+        alpha,
+        offset
+    );
+
+    return true;
+}
+
+/// Clean up given mesh via exact nef polyhedron round trip.
+/// @param: out_volume Receives the nef polyhedron of cleaned up mesh if not null.
+bool CollisionGen::cleanupMeshExact(Mesh &mesh, CGAL_NefPolyhedron *out_volume)
 {
     CGAL_Surface surface;
     CollisionGen::surfaceFromMesh(mesh, surface);
@@ -188,15 +3171,100 @@ bool CollisionGen::cleanupMesh(Mesh &mesh)
     CGAL::copy_face_graph(polyhedron, surface);
     CollisionGen::meshFromSurface(surface, mesh);
 
+    if (out_volume)
+    {
+        *out_volume = volume_poly;
+    }
+
     return true;
 }
 
-/// Build triangulated mesh data from CGAL polyhedron.
-/// @param: polyhedron Polyhedron to build mesh from.
-/// @param: out_mesh Reference to newly built mesh object.
-void CollisionGen::meshFromSurface(const CGAL_Surface &surface, Mesh &out_mesh)
+/// Clean up given mesh using polygon mesh processing repair steps on inexact kernel.
+/// Removes degenerate geometry, stitches borders and orients faces to bound a volume.
+/// Mesh is left unchanged if the result is not a closed valid volume.
+bool CollisionGen::cleanupMeshFast(Mesh &mesh)
+{
+    namespace PMP = CGAL::Polygon_mesh_processing;
+
+    std::vector<CGAL_FastPoint> points;
+    std::vector<std::array<std::size_t, 3>> faces;
+    points.reserve(mesh.numVertices());
+    faces.reserve(mesh.numIndices() / 3);
+
+    for (const QVector3D &vertex : mesh.getVertices())
+    {
+        points.emplace_back(vertex.x(), vertex.y(), vertex.z());
+    }
+
+    std::span<const int> indices = mesh.getIndices();
+    for (int i=0; i+2 < mesh.numIndices(); i+=3)
+    {
+        faces.push_back({
+            std::size_t(indices[i]),
+            std::size_t(indices[i+1]),
+            std::size_t(indices[i+2])
+        });
+    }
+
+    /// Merges duplicate points and drops degenerate or duplicate polygons.
+    PMP::repair_polygon_soup(points, faces);
+    if (!PMP::orient_polygon_soup(points, faces))
+    {
+        logDebug("Fast cleanup had to duplicate non-manifold points while orienting polygon soup");
+    }
+
+    CGAL_FastSurface surface;
+    PMP::polygon_soup_to_polygon_mesh(points, faces, surface);
+    if (!CGAL::is_valid_polygon_mesh(surface))
+    {
+        logDebug("Fast cleanup produced invalid polygon mesh");
+        return false;
+    }
+
+    PMP::remove_degenerate_faces(surface);
+    PMP::duplicate_non_manifold_vertices(surface);
+    PMP::stitch_borders(surface);
+
+    std::vector<CGAL_FastSurface::Halfedge_index> border_cycles;
+    PMP::extract_boundary_cycles(surface, std::back_inserter(border_cycles));
+    for (CGAL_FastSurface::Halfedge_index edge : border_cycles)
+    {
+        PMP::triangulate_hole(surface, edge);
+    }
+
+    if (surface.has_garbage())
+    {
+        surface.collect_garbage();
+    }
+
+    if (!CGAL::is_closed(surface))
+    {
+        logDebug("Fast cleanup surface is not closed");
+        return false;
+    }
+
+    if (PMP::does_self_intersect(surface))
+    {
+        logDebug("Fast cleanup surface is self intersecting");
+        return false;
+    }
+
+    PMP::orient_to_bound_a_volume(surface);
+    if (!PMP::does_bound_a_volume(surface))
+    {
+        logDebug("Fast cleanup surface does not bound a volume");
+        return false;
+    }
+
+    CollisionGen::meshFromSurface(surface, mesh);
+    return true;
+}
+
+/// Build triangulated mesh data from CGAL surface of any kernel.
+template <typename SurfaceT>
+static void buildMeshFromSurface(const SurfaceT &surface, Mesh &out_mesh)
 {
-    CGAL_Surface tri_surface = surface;
+    SurfaceT tri_surface = surface;
     CGAL::Polygon_mesh_processing::triangulate_faces(tri_surface);
 
     std::vector<QVector3D> vertices;
@@ -204,13 +3272,13 @@ void CollisionGen::meshFromSurface(const CGAL_Surface &surface, Mesh &out_mesh)
     vertices.reserve(tri_surface.vertices().size());
     indices.reserve(tri_surface.faces().size() * 3);
 
-    std::unordered_map<CGAL_Surface::Vertex_index, int> vertex_map;
+    std::unordered_map<typename SurfaceT::Vertex_index, int> vertex_map;
     vertex_map.reserve(tri_surface.vertices().size());
 
     int idx = 0;
-    for (const CGAL_Surface::Vertex_index &vertex : tri_surface.vertices())
+    for (const typename SurfaceT::Vertex_index &vertex : tri_surface.vertices())
     {
-        const CGAL_Point &point = tri_surface.point(vertex);
+        const auto &point = tri_surface.point(vertex);
         vertices.emplace_back(
             CGAL::to_double(point.x()),
             CGAL::to_double(point.y()),
@@ -221,12 +3289,12 @@ void CollisionGen::meshFromSurface(const CGAL_Surface &surface, Mesh &out_mesh)
         idx++;
     }
 
-    for (const CGAL_Surface::Face_index &face : tri_surface.faces())
+    for (const typename SurfaceT::Face_index &face : tri_surface.faces())
     {
-        CGAL_Surface::halfedge_index edge = tri_surface.halfedge(face);
+        typename SurfaceT::halfedge_index edge = tri_surface.halfedge(face);
         for ( int i=0; i<3; i++)
         {
-            CGAL_Surface::Vertex_index idx = tri_surface.target(edge);
+            typename SurfaceT::Vertex_index idx = tri_surface.target(edge);
             indices.emplace_back(vertex_map[idx]);
             edge = tri_surface.next(edge);
         }
@@ -239,6 +3307,22 @@ void CollisionGen::meshFromSurface(const CGAL_Surface &surface, Mesh &out_mesh)
     return;
 }
 
+/// Build triangulated mesh data from CGAL polyhedron.
+/// @param: polyhedron Polyhedron to build mesh from.
+/// @param: out_mesh Reference to newly built mesh object.
+void CollisionGen::meshFromSurface(const CGAL_Surface &surface, Mesh &out_mesh)
+{
+    buildMeshFromSurface(surface, out_mesh);
+}
+
+/// Build triangulated mesh data from inexact CGAL surface.
+/// @param: surface Surface to build mesh from.
+/// @param: out_mesh Reference to newly built mesh object.
+void CollisionGen::meshFromSurface(const CGAL_FastSurface &surface, Mesh &out_mesh)
+{
+    buildMeshFromSurface(surface, out_mesh);
+}
+
 /// Builds CGAL surface mesh from standard mesh data.
 /// Resulting mesh will have enforced triangulation and consistent winding order.
 /// @param: mesh Standard mesh to build surface from.
@@ -261,9 +3345,9 @@ bool CollisionGen::surfaceFromMesh(const Mesh &mesh, CGAL_Surface &out_surface)
 
     for (int i=0; i+2 < mesh.numIndices(); i+=3)
     {
-        const int idx0 = mesh.getIndices().at(i);
-        const int idx1 = mesh.getIndices().at(i+1);
-        const int idx2 = mesh.getIndices().at(i+2);
+        const int idx0 = mesh.getIndices()[i];
+        const int idx1 = mesh.getIndices()[i+1];
+        const int idx2 = mesh.getIndices()[i+2];
         
          faces.push_back({
            idx0,
@@ -309,6 +3393,92 @@ bool CollisionGen::polyhedronFromMesh(const Mesh &mesh, CGAL_Polyhedron &out_pol
     return false;
 }
 
+/// Decompose closed nef polyhedron into convex pieces. Convex decomposition itself cannot be
+/// interrupted, piece extraction gives up once the deadline passes or the decomposition yields
+/// too many pieces.
+/// @param: volume_poly Closed volume to decompose, decomposed in place.
+/// @param: deadline Time after which piece extraction gives up.
+/// @param: max_pieces Maximum number of pieces to extract.
+/// @param: out_pieces List to add convex piece meshes to.
+/// Returns true if all pieces were extracted.
+bool CollisionGen::decomposeVolume(
+    CGAL_NefPolyhedron &volume_poly,
+    std::chrono::steady_clock::time_point deadline,
+    size_t max_pieces,
+    std::vector<std::unique_ptr<Mesh>> &out_pieces
+)
+{
+    CGAL::convex_decomposition_3(volume_poly);
+
+    /// First volume is always the outer volume, remaining marked volumes are the convex pieces.
+    /// Pieces are counted before extraction, so too fragmented results are not extracted at all.
+    size_t num_pieces = 0;
+    auto volume = volume_poly.volumes_begin();
+    for (++volume; volume != volume_poly.volumes_end(); ++volume)
+    {
+        num_pieces += volume->mark() ? 1 : 0;
+    }
+
+    if (num_pieces == 0 || num_pieces > max_pieces)
+    {
+        return false;
+    }
+
+    volume = volume_poly.volumes_begin();
+    for (++volume; volume != volume_poly.volumes_end(); ++volume)
+    {
+        if (!volume->mark())
+        {
+            continue;
+        }
+
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            return false;
+        }
+
+        CGAL_Polyhedron piece_poly;
+        volume_poly.convert_inner_shell_to_polyhedron(volume->shells_begin(), piece_poly);
+
+        CGAL_Surface piece_surface;
+        CGAL::copy_face_graph(piece_poly, piece_surface);
+
+        Mesh piece({}, {});
+        CollisionGen::meshFromSurface(piece_surface, piece);
+        out_pieces.push_back(std::make_unique<Mesh>(piece));
+    }
+
+    return true;
+}
+
+/// Decompose closed mesh into convex pieces, see CollisionGen::decomposeVolume.
+/// @param: mesh Closed mesh to decompose.
+/// @param: deadline Time after which piece extraction gives up.
+/// @param: max_pieces Maximum number of pieces to extract.
+/// @param: out_pieces List to add convex piece meshes to.
+/// Returns true if all pieces were extracted.
+bool CollisionGen::decomposeMeshExact(
+    const Mesh &mesh,
+    std::chrono::steady_clock::time_point deadline,
+    size_t max_pieces,
+    std::vector<std::unique_ptr<Mesh>> &out_pieces
+)
+{
+    CGAL_Polyhedron polyhedron;
+    if (!CollisionGen::polyhedronFromMesh(mesh, polyhedron) || !polyhedron.is_closed())
+    {
+        return false;
+    }
+
+    CGAL_NefPolyhedron volume_poly(polyhedron);
+    if (!volume_poly.is_valid())
+    {
+        return false;
+    }
+
+    return CollisionGen::decomposeVolume(volume_poly, deadline, max_pieces, out_pieces);
+}
+
 /// Fill holes inside given CGAL surface mesh using simple fan triangle strips.
 void CollisionGen::capSurface(CGAL_Surface &surface)
 {
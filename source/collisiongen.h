@@ -1,13 +1,25 @@
 #ifndef COLLISION_GEN_H
 #define COLLISION_GEN_H
 
+#include "collisioncache.h"
+#include "collisioninstances.h"
 #include "logging.h"
 #include "mesh.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_set>
 #include <vector>
 #include <memory>
 
+#include <tbb/enumerable_thread_specific.h>
+
 #include <CGAL/Exact_predicates_exact_constructions_kernel.h>
+#include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 #include <CGAL/Surface_mesh.h>
 #include <CGAL/Polyhedron_3.h>
 #include <CGAL/Nef_polyhedron_3.h>
@@ -18,6 +30,10 @@ using CGAL_Surface = CGAL::Surface_mesh<CGAL_Point>;
 using CGAL_Polyhedron = CGAL::Polyhedron_3<CGAL_Kernel>;
 using CGAL_NefPolyhedron = CGAL::Nef_polyhedron_3<CGAL_Kernel>;
 
+using CGAL_FastKernel = CGAL::Exact_predicates_inexact_constructions_kernel;
+using CGAL_FastPoint = CGAL_FastKernel::Point_3;
+using CGAL_FastSurface = CGAL::Surface_mesh<CGAL_FastPoint>;
+
 #define VHACD_USE_OPENCL 0
 #include <VHACD.h>
 
@@ -26,7 +42,17 @@ enum CollisionTechnique
 {
     SimpleHull = 0,
     ExactDecomposition = 1,
-    ApproximateDecomposition = 2
+    ApproximateDecomposition = 2,
+    PrimitiveFit = 3,
+    VoxelBoxes = 4
+};
+
+
+enum MeshCleanupMode
+{
+    ExactCleanup = 0,
+    FastCleanup = 1,
+    AlphaWrapCleanup = 2
 };
 
 
@@ -40,6 +66,71 @@ public:
 };
 
 
+/// Callback signature used to report collision generation progress.
+/// Progress value is normalized to 0-1 range across all input meshes.
+using CollisionProgressCallback = std::function<void(double progress, const std::string &stage)>;
+
+
+class VHACDProgressCallback : public VHACD::IVHACD::IUserCallback
+{
+public:
+    std::function<void(double progress, const char *stage)> on_update;
+
+    void Update(
+        const double overall_progress,
+        const double stage_progress,
+        const double operation_progress,
+        const char *const stage,
+        const char *const operation
+    ) override
+    {
+        if (this->on_update)
+        {
+            this->on_update(overall_progress * 0.01, stage);
+        }
+    }
+};
+
+
+/// Wall-clock and memory budget of generating collision for single input mesh.
+/// Memory is measured as growth of process resident memory since the budget started, so
+/// meshes processed concurrently count against each other's budget. Zero disables a limit.
+class CollisionBudget
+{
+public:
+    CollisionBudget(double time_budget, double memory_budget);
+
+    bool check(size_t external_memory = 0);
+    bool isExceeded() const;
+    std::string getReason() const;
+    double getElapsed() const;
+    size_t getPeakMemory() const;
+
+    static size_t getResidentMemory(int process_id = 0);
+
+private:
+    std::chrono::steady_clock::time_point start_time;
+    double time_budget;
+    size_t memory_budget;
+    size_t memory_baseline;
+
+    std::atomic<size_t> peak_memory;
+    std::atomic<int> exceeded;
+};
+
+
+/// Record of collision generation of single mesh degraded after exceeding its budget.
+struct CollisionDegradation
+{
+    std::string reason;
+    double      resolution = 0.0;
+    double      elapsed = 0.0;
+    size_t      peak_memory = 0;
+    std::string fallback;
+    double      fallback_resolution = 0.0;
+};
+
+
 struct CollisionGenSettings
 {
     double  scale;
@@ -51,33 +142,231 @@ struct CollisionGenSettings
     double  concavity;
     int     depth_planes;
     int     mode;
+    int     worker_threads;
+    int     cleanup_mode;
+    int     technique;
+    bool    hull_per_mesh;
+    double  hull_padding;
+    double  exact_time_budget;
+    int     exact_max_pieces;
+    bool    decimate;
+    double  merge_threshold;
+    bool    strict_vertex_limit;
+    bool    compute_metrics;
+    double  primitive_tolerance;
+    int     voxel_resolution;
+    int     max_boxes;
+    bool    oriented_boxes;
+    int     lod_levels;
+    double  lod_ratio;
+    bool    dedupe_instances;
+    double  wrap_alpha;
+    double  wrap_offset;
+    double  mesh_time_budget;
+    double  mesh_memory_budget;
+    bool    worker_processes;
 };
 
 
+/// Collision hulls of each LOD level grouped by input mesh, finest level first.
+using CollisionLODChain = std::vector<std::vector<std::vector<std::unique_ptr<Mesh>>>>;
+
+
 class CollisionGen
 {
 public:
     CollisionGen();
+    ~CollisionGen();
 
     void addInputMesh(const Mesh *mesh);
     void clearInputMeshes();
-    void generateVHACD(
+    void setProgressCallback(const CollisionProgressCallback &callback);
+    void cancel();
+    bool isCancelled() const;
+    std::vector<std::vector<CollisionDegradation>> getMeshDegradations() const;
+
+    void generate(
         const CollisionGenSettings &settings,
         std::vector<std::unique_ptr<Mesh>> &out_meshes
     );
+    void generate(
+        const CollisionGenSettings &settings,
+        std::vector<std::vector<std::unique_ptr<Mesh>>> &out_mesh_hulls
+    );
+    void generateLODChain(const CollisionGenSettings &settings, CollisionLODChain &out_levels);
 
+    static bool isSceneHull(const CollisionGenSettings &settings);
+    static void getResultSources(
+        const CollisionGenSettings &settings,
+        size_t num_meshes,
+        std::vector<std::vector<size_t>> &out_sources
+    );
+
+    void setCache(std::shared_ptr<CollisionCache> cache);
+    static uint64_t computeCacheKey(const Mesh &mesh, const CollisionGenSettings &settings);
+    static uint64_t computeCacheKey(uint64_t mesh_hash, const CollisionGenSettings &settings);
+
+    static void getVHACDParameters(
+        const CollisionGenSettings &settings,
+        int max_hulls,
+        VHACD::IVHACD::Parameters &out_params
+    );
+    static bool computeConvexHull(const std::vector<CGAL_FastPoint> &points, Mesh &out_mesh);
+    static void getMeshPoints(const Mesh &mesh, float padding, std::vector<CGAL_FastPoint> &out_points);
     static void meshFromSurface(const CGAL_Surface &surface, Mesh &out_mesh);
+    static void meshFromSurface(const CGAL_FastSurface &surface, Mesh &out_mesh);
     static bool surfaceFromMesh(const Mesh &mesh, CGAL_Surface &out_surface);
     static bool polyhedronFromMesh(const Mesh &mesh, CGAL_Polyhedron &out_poly);
     static void capSurface(CGAL_Surface &surface_mesh);
+    static bool decomposeVolume(
+        CGAL_NefPolyhedron &volume_poly,
+        std::chrono::steady_clock::time_point deadline,
+        size_t max_pieces,
+        std::vector<std::unique_ptr<Mesh>> &out_pieces
+    );
+    static bool decomposeMeshExact(
+        const Mesh &mesh,
+        std::chrono::steady_clock::time_point deadline,
+        size_t max_pieces,
+        std::vector<std::unique_ptr<Mesh>> &out_pieces
+    );
+    static void weldMesh(Mesh &mesh);
+    static double getVoxelSize(const Mesh &mesh, double resolution);
+    static bool decimateMesh(Mesh &mesh, double max_error);
+    static bool wrapMesh(Mesh &mesh, double alpha, double offset);
+    static bool simplifyHull(Mesh &hull, int max_vertices, double &out_added_volume);
+    static size_t mergeHulls(
+        std::vector<std::unique_ptr<Mesh>> &hulls,
+        double max_volume_increase,
+        size_t min_hulls = 0
+    );
+    static void splitConnectedComponents(const Mesh &mesh, std::vector<Mesh> &out_components);
+    static void groupComponents(
+        const std::vector<Mesh> &components,
+        int max_groups,
+        std::vector<Mesh> &out_groups
+    );
+    static void distributeHullBudget(
+        const std::vector<Mesh> &components,
+        int max_hulls,
+        std::vector<int> &out_hulls
+    );
 
 protected:
-    std::vector<CGAL_Point> getInputPoints(float padding = 0.0) const;
-    bool cleanupMesh(Mesh &mesh);
+    std::vector<CGAL_FastPoint> getInputPoints(float padding = 0.0) const;
+    bool cleanupMesh(
+        Mesh &mesh,
+        const CollisionGenSettings &settings,
+        CGAL_NefPolyhedron *out_volume = nullptr,
+        bool welded = false
+    );
+    bool cleanupMeshExact(Mesh &mesh, CGAL_NefPolyhedron *out_volume = nullptr);
+    bool cleanupMeshFast(Mesh &mesh);
+    void generate(
+        const CollisionGenSettings &settings,
+        size_t num_levels,
+        CollisionLODChain &out_levels
+    );
+    void generateSceneHull(
+        const CollisionGenSettings &settings,
+        std::vector<std::unique_ptr<Mesh>> &out_meshes
+    );
+    void processMesh(
+        size_t mesh_idx,
+        const CollisionGenSettings &settings,
+        std::vector<std::unique_ptr<Mesh>> &out_meshes
+    );
+    void processMeshSimpleHull(
+        size_t mesh_idx,
+        const CollisionGenSettings &settings,
+        std::vector<std::unique_ptr<Mesh>> &out_meshes
+    );
+    void processMeshVHACD(
+        size_t mesh_idx,
+        const CollisionGenSettings &settings,
+        std::vector<std::unique_ptr<Mesh>> &out_meshes
+    );
+    void decomposeComponentsVHACD(
+        size_t mesh_idx,
+        const Mesh &mesh,
+        const std::vector<Mesh> &components,
+        const CollisionGenSettings &settings,
+        CollisionBudget &budget,
+        std::vector<std::unique_ptr<Mesh>> &out_meshes
+    );
+    void simplifyMeshHulls(
+        const CollisionGenSettings &settings,
+        std::vector<std::unique_ptr<Mesh>> &hulls
+    );
+    void processMeshLODs(
+        size_t mesh_idx,
+        const CollisionGenSettings &settings,
+        CollisionLODChain &levels
+    );
+    void mergeMeshHulls(
+        size_t mesh_idx,
+        const CollisionGenSettings &settings,
+        std::vector<std::unique_ptr<Mesh>> &hulls
+    );
+    VHACD::IVHACD* acquireVHACD();
+    bool decomposeVHACD(
+        const Mesh &mesh,
+        const CollisionGenSettings &settings,
+        int max_hulls,
+        CollisionBudget &budget,
+        const std::function<void(double progress, const char *stage)> &on_progress,
+        std::vector<std::unique_ptr<Mesh>> &out_meshes
+    );
+    void processMeshExact(
+        size_t mesh_idx,
+        const CollisionGenSettings &settings,
+        std::vector<std::unique_ptr<Mesh>> &out_meshes
+    );
+    void processMeshPrimitives(
+        size_t mesh_idx,
+        const CollisionGenSettings &settings,
+        std::vector<std::unique_ptr<Mesh>> &out_meshes
+    );
+    void processMeshVoxelBoxes(
+        size_t mesh_idx,
+        const CollisionGenSettings &settings,
+        std::vector<std::unique_ptr<Mesh>> &out_meshes
+    );
+
+    void findInputInstances(const CollisionGenSettings &settings);
+    void placeInstanceHulls(std::vector<std::vector<std::unique_ptr<Mesh>>> &mesh_hulls) const;
+
+    void forEachInputMesh(
+        const CollisionGenSettings &settings,
+        const std::function<void(size_t mesh_idx)> &func
+    );
+
+    void recordDegradation(size_t mesh_idx, const CollisionDegradation &degradation);
+    bool isMeshDegraded(size_t mesh_idx) const;
+
+    void reportProgress(double progress, const std::string &stage);
+    void updateMeshProgress(size_t mesh_idx, double progress, const std::string &stage);
 
 private:
     std::vector<const Mesh*> input_meshes;
+    /// Prototype and transform of each input mesh, collision is generated for prototypes only.
+    std::vector<MeshInstance> mesh_instances;
     VHACDDebugLogger vhacd_logger;
+    CollisionProgressCallback progress_callback;
+    std::shared_ptr<CollisionCache> cache;
+
+    std::atomic<bool> cancelled;
+    std::mutex vhacd_mutex;
+    std::unordered_set<VHACD::IVHACD*> active_vhacd;
+
+    /// VHACD instances reused between meshes processed by the same worker thread.
+    tbb::enumerable_thread_specific<VHACD::IVHACD*> vhacd_pool;
+
+    std::mutex progress_mutex;
+    std::vector<double> mesh_progress;
+
+    mutable std::mutex degradation_mutex;
+    std::vector<std::vector<CollisionDegradation>> mesh_degradations;
 };
 
 #endif
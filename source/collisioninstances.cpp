@@ -0,0 +1,319 @@
+#include "collisioninstances.h"
+#include "hashing.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <tbb/parallel_for.h>
+
+/// Maximum number of Jacobi sweeps used to diagonalize vertex covariance.
+static const int MAX_JACOBI_SWEEPS = 32;
+
+
+using InstanceMatrix = std::array<std::array<double, 3>, 3>;
+
+/// Diagonalize symmetric 3x3 matrix using cyclic Jacobi rotations.
+/// @param: matrix Symmetric matrix to diagonalize.
+/// @param: out_values Receives eigenvalues.
+/// @param: out_vectors Receives eigenvectors stored in columns matching the eigenvalues.
+static void solveSymmetricEigen(
+    InstanceMatrix matrix,
+    std::array<double, 3> &out_values,
+    InstanceMatrix &out_vectors
+)
+{
+    out_vectors = {{{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0}}};
+
+    const double scale = std::abs(matrix[0][0]) + std::abs(matrix[1][1]) + std::abs(matrix[2][2]);
+    for (int sweep=0; sweep < MAX_JACOBI_SWEEPS; sweep++)
+    {
+        const double off_diagonal = std::abs(matrix[0][1]) + std::abs(matrix[0][2]) + std::abs(matrix[1][2]);
+        if (off_diagonal <= scale * 1e-15)
+        {
+            break;
+        }
+
+        for (int p=0; p < 2; p++)
+        {
+            for (int q=p+1; q < 3; q++)
+            {
+                if (matrix[p][q] == 0.0)
+                {
+                    continue;
+                }
+
+                /// Rotation angle zeroing the off-diagonal element, smaller root for stability.
+                const double theta = (matrix[q][q] - matrix[p][p]) / (2.0 * matrix[p][q]);
+                const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                const double c = 1.0 / std::sqrt(t * t + 1.0);
+                const double s = t * c;
+
+                for (int k=0; k < 3; k++)
+                {
+                    const double kp = matrix[k][p];
+                    const double kq = matrix[k][q];
+                    matrix[k][p] = c * kp - s * kq;
+                    matrix[k][q] = s * kp + c * kq;
+                }
+
+                for (int k=0; k < 3; k++)
+                {
+                    const double pk = matrix[p][k];
+                    const double qk = matrix[q][k];
+                    matrix[p][k] = c * pk - s * qk;
+                    matrix[q][k] = s * pk + c * qk;
+                }
+
+                for (int k=0; k < 3; k++)
+                {
+                    const double kp = out_vectors[k][p];
+                    const double kq = out_vectors[k][q];
+                    out_vectors[k][p] = c * kp - s * kq;
+                    out_vectors[k][q] = s * kp + c * kq;
+                }
+            }
+        }
+    }
+
+    out_values = {matrix[0][0], matrix[1][1], matrix[2][2]};
+}
+
+
+/// Compute canonical frame of mesh vertices from their principal components.
+/// Frame origin is the vertex centroid, axes follow principal axes by decreasing variance.
+/// Axis directions are chosen so vertex distribution is skewed towards positive side and
+/// the frame is always right-handed, so copies of a mesh under any rigid transform map to
+/// the same canonical vertices unless principal axes are ambiguous due to symmetry.
+/// @param: mesh Mesh to compute frame for.
+/// @param: out_center Receives frame origin.
+/// @param: out_rotation Receives rotation from canonical frame to mesh space.
+void CollisionInstances::computeCanonicalFrame(const Mesh &mesh, QVector3D &out_center, QQuaternion &out_rotation)
+{
+    out_center = QVector3D(0.0, 0.0, 0.0);
+    out_rotation = QQuaternion();
+    if (mesh.numVertices() == 0)
+    {
+        return;
+    }
+
+    std::array<double, 3> center = {0.0, 0.0, 0.0};
+    for (const QVector3D &pos : mesh.getVertices())
+    {
+        center[0] += pos.x();
+        center[1] += pos.y();
+        center[2] += pos.z();
+    }
+
+    for (double &value : center)
+    {
+        value /= double(mesh.numVertices());
+    }
+
+    InstanceMatrix covariance = {};
+    for (const QVector3D &pos : mesh.getVertices())
+    {
+        const std::array<double, 3> d = {pos.x() - center[0], pos.y() - center[1], pos.z() - center[2]};
+        for (int i=0; i < 3; i++)
+        {
+            for (int j=0; j < 3; j++)
+            {
+                covariance[i][j] += d[i] * d[j];
+            }
+        }
+    }
+
+    std::array<double, 3> values;
+    InstanceMatrix vectors;
+    solveSymmetricEigen(covariance, values, vectors);
+
+    std::array<int, 3> order = {0, 1, 2};
+    std::sort(order.begin(), order.end(), [&](int a, int b)
+    {
+        return values[a] > values[b];
+    });
+
+    std::array<std::array<double, 3>, 3> axes;
+    for (int i=0; i < 2; i++)
+    {
+        axes[i] = {vectors[0][order[i]], vectors[1][order[i]], vectors[2][order[i]]};
+
+        double skew = 0.0;
+        for (const QVector3D &pos : mesh.getVertices())
+        {
+            const double d = (pos.x() - center[0]) * axes[i][0]
+                + (pos.y() - center[1]) * axes[i][1]
+                + (pos.z() - center[2]) * axes[i][2];
+            skew += d * d * d;
+        }
+
+        if (skew < 0.0)
+        {
+            for (double &value : axes[i])
+            {
+                value = -value;
+            }
+        }
+    }
+
+    axes[2] = {
+        axes[0][1] * axes[1][2] - axes[0][2] * axes[1][1],
+        axes[0][2] * axes[1][0] - axes[0][0] * axes[1][2],
+        axes[0][0] * axes[1][1] - axes[0][1] * axes[1][0]
+    };
+
+    out_center = QVector3D(center[0], center[1], center[2]);
+    out_rotation = QQuaternion::fromAxes(
+        QVector3D(axes[0][0], axes[0][1], axes[0][2]),
+        QVector3D(axes[1][0], axes[1][1], axes[1][2]),
+        QVector3D(axes[2][0], axes[2][1], axes[2][2])
+    ).normalized();
+}
+
+/// Group meshes that are copies of each other.
+/// Meshes with identical content are detected by content hash. Meshes sharing triangle indices
+/// whose vertices match after mapping both into their canonical frame are detected as copies
+/// under a rigid transform. First mesh of each group becomes the prototype of the group.
+/// @param: meshes Meshes to group.
+/// @param: tolerance Maximum vertex distance of matching meshes relative to mesh size.
+/// @param: out_instances Receives prototype and transform of each mesh in input order.
+/// Returns number of unique meshes.
+size_t CollisionInstances::findInstances(
+    const std::vector<const Mesh*> &meshes,
+    double tolerance,
+    std::vector<MeshInstance> &out_instances
+)
+{
+    const size_t num_meshes = meshes.size();
+    out_instances.assign(num_meshes, MeshInstance());
+
+    std::vector<uint64_t> content_hashes(num_meshes);
+    std::vector<uint64_t> topology_hashes(num_meshes);
+    std::vector<QVector3D> centers(num_meshes);
+    std::vector<QQuaternion> rotations(num_meshes);
+    std::vector<float> radii(num_meshes, 0.0f);
+
+    tbb::parallel_for(size_t(0), num_meshes, [&](size_t mesh_idx)
+    {
+        const Mesh &mesh = *meshes.at(mesh_idx);
+        out_instances.at(mesh_idx).prototype = mesh_idx;
+        content_hashes.at(mesh_idx) = mesh.computeHash();
+
+        const std::span<const int> indices = mesh.getIndices();
+        topology_hashes.at(mesh_idx) = Hashing::hashBytes(
+            Hashing::hashValue(0, uint64_t(mesh.numVertices())),
+            indices.data(),
+            indices.size_bytes()
+        );
+
+        CollisionInstances::computeCanonicalFrame(mesh, centers.at(mesh_idx), rotations.at(mesh_idx));
+        for (const QVector3D &pos : mesh.getVertices())
+        {
+            radii.at(mesh_idx) = std::max(radii.at(mesh_idx), (pos - centers.at(mesh_idx)).length());
+        }
+    });
+
+    /// Check if vertices of given mesh match the prototype placed by given instance transform.
+    auto matches = [&](size_t mesh_idx, const MeshInstance &instance)
+    {
+        const Mesh &mesh = *meshes.at(mesh_idx);
+        const Mesh &prototype = *meshes.at(instance.prototype);
+        if (mesh.numVertices() != prototype.numVertices() ||
+            !std::ranges::equal(mesh.getIndices(), prototype.getIndices()))
+        {
+            return false;
+        }
+
+        const float max_distance = tolerance * std::max(radii.at(mesh_idx), radii.at(instance.prototype));
+        for (size_t i=0; i < mesh.numVertices(); i++)
+        {
+            const QVector3D placed = instance.rotation.rotatedVector(prototype.getVertices()[i]) + instance.translation;
+            if ((placed - mesh.getVertices()[i]).lengthSquared() > max_distance * max_distance)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    /// Meshes are grouped in input order so prototypes and results are deterministic.
+    size_t num_unique = 0;
+    std::unordered_map<uint64_t, size_t> exact_prototypes;
+    std::unordered_map<uint64_t, std::vector<size_t>> rigid_prototypes;
+    for (size_t mesh_idx=0; mesh_idx < num_meshes; mesh_idx++)
+    {
+        MeshInstance &instance = out_instances.at(mesh_idx);
+
+        auto exact_it = exact_prototypes.find(content_hashes.at(mesh_idx));
+        if (exact_it != exact_prototypes.end())
+        {
+            MeshInstance candidate;
+            candidate.prototype = exact_it->second;
+            if (matches(mesh_idx, candidate))
+            {
+                instance = candidate;
+                continue;
+            }
+        }
+
+        bool found = false;
+        std::vector<size_t> &candidates = rigid_prototypes[topology_hashes.at(mesh_idx)];
+        for (size_t prototype_idx : candidates)
+        {
+            MeshInstance candidate;
+            candidate.prototype = prototype_idx;
+            candidate.rotation = (rotations.at(mesh_idx) * rotations.at(prototype_idx).conjugated()).normalized();
+            candidate.translation = centers.at(mesh_idx) - candidate.rotation.rotatedVector(centers.at(prototype_idx));
+            if (matches(mesh_idx, candidate))
+            {
+                instance = candidate;
+                found = true;
+                break;
+            }
+        }
+
+        if (!found)
+        {
+            exact_prototypes.emplace(content_hashes.at(mesh_idx), mesh_idx);
+            candidates.push_back(mesh_idx);
+            num_unique++;
+        }
+    }
+
+    return num_unique;
+}
+
+/// Place copy of prototype mesh using given instance transform.
+/// Tessellated primitives keep their shape descriptor, moved along with the mesh.
+/// @param: mesh Prototype mesh to transform.
+/// @param: instance Transform placing the prototype onto the instance.
+/// @param: out_mesh Mesh to receive transformed copy.
+void CollisionInstances::transformMesh(const Mesh &mesh, const MeshInstance &instance, Mesh &out_mesh)
+{
+    std::vector<QVector3D> vertices;
+    vertices.reserve(mesh.numVertices());
+    for (const QVector3D &pos : mesh.getVertices())
+    {
+        vertices.push_back(instance.rotation.rotatedVector(pos) + instance.translation);
+    }
+
+    out_mesh = Mesh(vertices, mesh.getIndices());
+    if (mesh.isPrimitive())
+    {
+        MeshPrimitive primitive = mesh.getPrimitive();
+        primitive.center = instance.rotation.rotatedVector(primitive.center) + instance.translation;
+        primitive.rotation = (instance.rotation * primitive.rotation).normalized();
+        out_mesh.setPrimitive(primitive);
+    }
+
+    if (mesh.numNormals() > 0)
+    {
+        out_mesh.generateNormals();
+    }
+
+    out_mesh.computeBounds();
+}
@@ -0,0 +1,35 @@
+#ifndef COLLISION_INSTANCES_H
+#define COLLISION_INSTANCES_H
+
+#include "mesh.h"
+
+#include <cstddef>
+#include <vector>
+#include <QQuaternion>
+#include <QVector3D>
+
+
+/// Rigid transform placing prototype mesh onto one of its instances.
+/// Prototype of a unique mesh is the mesh itself with identity transform.
+struct MeshInstance
+{
+    size_t      prototype = 0;
+    QQuaternion rotation;
+    QVector3D   translation;
+};
+
+
+/// Detection of meshes that are copies of each other, possibly under a rigid transform.
+class CollisionInstances
+{
+public:
+    static size_t findInstances(
+        const std::vector<const Mesh*> &meshes,
+        double tolerance,
+        std::vector<MeshInstance> &out_instances
+    );
+    static void computeCanonicalFrame(const Mesh &mesh, QVector3D &out_center, QQuaternion &out_rotation);
+    static void transformMesh(const Mesh &mesh, const MeshInstance &instance, Mesh &out_mesh);
+};
+
+#endif
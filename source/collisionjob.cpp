@@ -0,0 +1,270 @@
+#include "collisionjob.h"
+#include "collisiongen.h"
+#include "collisionmetrics.h"
+#include "logging.h"
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <QDateTime>
+#include <tbb/parallel_for.h>
+
+
+/// Create new collision job which runs collision generation on a background thread.
+/// @param: settings Collision generation settings to use for this job.
+CollisionJob::CollisionJob(const CollisionGenSettings &settings, QObject *parent) :
+    QThread(parent),
+    settings(settings)
+{
+    qRegisterMetaType<CollisionJobResult>("CollisionJobResult");
+    qRegisterMetaType<CollisionGenSettings>("CollisionGenSettings");
+    qRegisterMetaType<CollisionJobLODResult>("CollisionJobLODResult");
+
+    this->collision_gen.setProgressCallback([this](double progress, const std::string &stage)
+    {
+        Q_EMIT this->progressChanged(progress, QString::fromStdString(stage));
+    });
+
+    this->collision_sweep.setProgressCallback([this](double progress, const std::string &stage)
+    {
+        Q_EMIT this->progressChanged(progress, QString::fromStdString(stage));
+    });
+}
+
+/// Add mesh to process in this job.
+/// Job keeps its own copy of the mesh so the scene can change while the job is running.
+/// Must be called before the job is started.
+void CollisionJob::addInputMesh(const Mesh &mesh)
+{
+    this->input_meshes.push_back(std::make_unique<Mesh>(mesh));
+}
+
+/// Bind cache used to reuse previously generated collision.
+/// Must be called before the job is started.
+void CollisionJob::setCache(std::shared_ptr<CollisionCache> cache)
+{
+    this->collision_gen.setCache(cache);
+    this->collision_sweep.setCache(cache);
+}
+
+/// Set directory collision metrics reports are written to.
+/// Must be called before the job is started.
+void CollisionJob::setReportDirectory(const std::string &directory)
+{
+    this->report_directory = directory;
+}
+
+/// Turn this job into parameter sweep which generates collision for every settings variant
+/// and emits the cheapest collision meeting the target along with settings it was generated with.
+/// Must be called before the job is started.
+/// @param: variants Settings variants to generate collision with, see CollisionSweep::generateVariants.
+/// @param: target Budget the selected collision has to meet.
+void CollisionJob::setSweep(const std::vector<CollisionGenSettings> &variants, const CollisionSweepTarget &target)
+{
+    this->sweep_variants = variants;
+    this->sweep_target = target;
+}
+
+/// Request this job to stop as soon as possible.
+/// Cancelled job finishes without emitting any results.
+void CollisionJob::cancel()
+{
+    this->collision_gen.cancel();
+    this->collision_sweep.cancel();
+}
+
+/// Get value indicating if this job has been cancelled.
+bool CollisionJob::isCancelled() const
+{
+    return this->collision_gen.isCancelled() || this->collision_sweep.isCancelled();
+}
+
+/// Background thread entry point.
+void CollisionJob::run()
+{
+    if (!this->sweep_variants.empty())
+    {
+        this->runSweep();
+        return;
+    }
+
+    logDebug("Collision job started for {} input meshes", this->input_meshes.size());
+    auto start_time = std::chrono::steady_clock::now();
+
+    this->collision_gen.clearInputMeshes();
+    for (const std::unique_ptr<Mesh> &mesh : this->input_meshes)
+    {
+        this->collision_gen.addInputMesh(mesh.get());
+    }
+
+    /// Finest LOD level is delivered as the regular result, coarser levels follow separately.
+    CollisionJobResult result = std::make_shared<std::vector<std::vector<std::unique_ptr<Mesh>>>>();
+    CollisionJobLODResult lods;
+    if (this->settings.lod_levels > 1)
+    {
+        lods = std::make_shared<CollisionLODChain>();
+        this->collision_gen.generateLODChain(this->settings, *lods);
+        if (!lods->empty())
+        {
+            *result = std::move(lods->front());
+            lods->erase(lods->begin());
+        }
+    }
+    else
+    {
+        this->collision_gen.generate(this->settings, *result);
+    }
+
+    auto end_time = std::chrono::steady_clock::now();
+    double duration = std::chrono::duration<double>(end_time - start_time).count();
+
+    if (this->isCancelled())
+    {
+        logInfo("Collision job cancelled after {:.2f}s", duration);
+        return;
+    }
+
+    logInfo("Collision job finished in {:.2f}s", duration);
+    if (this->settings.compute_metrics)
+    {
+        std::vector<std::vector<size_t>> result_sources;
+        CollisionGen::getResultSources(this->settings, this->input_meshes.size(), result_sources);
+        this->measureCollision(result, result_sources, duration);
+    }
+
+    Q_EMIT this->collisionGenerated(result);
+    if (lods && !lods->empty())
+    {
+        Q_EMIT this->collisionLODsGenerated(lods);
+    }
+}
+
+/// Run parameter sweep over all settings variants and emit the cheapest collision meeting the target.
+void CollisionJob::runSweep()
+{
+    logDebug("Collision sweep started for {} input meshes", this->input_meshes.size());
+    auto start_time = std::chrono::steady_clock::now();
+
+    for (const std::unique_ptr<Mesh> &mesh : this->input_meshes)
+    {
+        this->collision_sweep.addInputMesh(mesh.get());
+    }
+
+    std::vector<CollisionSweepResult> results;
+    this->collision_sweep.run(this->sweep_variants, results);
+
+    auto end_time = std::chrono::steady_clock::now();
+    double duration = std::chrono::duration<double>(end_time - start_time).count();
+
+    if (this->isCancelled())
+    {
+        logInfo("Collision sweep cancelled after {:.2f}s", duration);
+        return;
+    }
+
+    CollisionSweep::markParetoSet(results);
+    CollisionSweep::logResults(results);
+    logInfo("Collision sweep of {} variants finished in {:.2f}s", results.size(), duration);
+
+    const int best = CollisionSweep::selectCheapest(results, this->sweep_target);
+    if (best < 0)
+    {
+        logWarning(
+            "No settings variant met the target of {} hulls, {} vertices per hull and {:.2f}% error",
+            this->sweep_target.max_hulls,
+            this->sweep_target.max_hull_vertices,
+            this->sweep_target.max_error * 100.0
+        );
+        return;
+    }
+
+    CollisionSweepResult &selected = results.at(best);
+    logInfo(
+        "Selected variant {} with {} hulls and {} vertices in total",
+        best,
+        selected.num_hulls,
+        selected.num_vertices
+    );
+
+    this->settings = selected.settings;
+    Q_EMIT this->settingsTuned(this->settings);
+
+    CollisionJobResult result = std::make_shared<std::vector<std::vector<std::unique_ptr<Mesh>>>>(
+        std::move(selected.hulls)
+    );
+    Q_EMIT this->collisionGenerated(result);
+}
+
+/// Measure approximation quality of generated collision against its input meshes,
+/// log the results and write them to a report file if report directory is set.
+/// @param: result Collision generated by this job.
+/// @param: result_sources Indices of input meshes each group of the result was generated from,
+/// see CollisionGen::getResultSources.
+/// @param: generation_duration Time spent generating the collision in seconds.
+void CollisionJob::measureCollision(
+    const CollisionJobResult &result,
+    const std::vector<std::vector<size_t>> &result_sources,
+    double generation_duration
+)
+{
+    Q_EMIT this->progressChanged(1.0, "Measuring collision quality");
+
+    /// Groups generated from multiple input meshes are measured against them combined.
+    std::vector<std::unique_ptr<Mesh>> sources;
+    for (const std::vector<size_t> &source_meshes : result_sources)
+    {
+        if (source_meshes.size() == 1)
+        {
+            sources.push_back(std::make_unique<Mesh>(*this->input_meshes.at(source_meshes.front())));
+            continue;
+        }
+
+        std::vector<QVector3D> vertices;
+        std::vector<int> indices;
+        for (size_t mesh_idx : source_meshes)
+        {
+            const Mesh &mesh = *this->input_meshes.at(mesh_idx);
+            const int offset = vertices.size();
+            std::span<const QVector3D> mesh_vertices = mesh.getVertices();
+            vertices.insert(vertices.end(), mesh_vertices.begin(), mesh_vertices.end());
+            for (const int &idx : mesh.getIndices())
+            {
+                indices.push_back(idx + offset);
+            }
+        }
+
+        sources.push_back(std::make_unique<Mesh>(vertices, indices));
+    }
+
+    CollisionMetrics metrics;
+    std::vector<CollisionMetricsResult> metrics_results(result->size());
+    tbb::parallel_for(size_t(0), std::min(result->size(), sources.size()), [&](size_t i)
+    {
+        metrics_results[i] = metrics.evaluate(*sources.at(i), result->at(i));
+    });
+
+    std::vector<std::vector<CollisionDegradation>> degradations = this->collision_gen.getMeshDegradations();
+    for (size_t i=0; i < metrics_results.size() && i < degradations.size(); i++)
+    {
+        metrics_results[i].degradations = std::move(degradations[i]);
+    }
+
+    for (size_t i=0; i < metrics_results.size(); i++)
+    {
+        CollisionMetrics::logResult(i, metrics_results[i]);
+    }
+
+    if (this->report_directory.empty())
+    {
+        return;
+    }
+
+    std::error_code err;
+    std::filesystem::create_directories(this->report_directory, err);
+    const std::string timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss").toStdString();
+    const std::string filepath = (std::filesystem::path(this->report_directory) / ("metrics_" + timestamp + ".json")).string();
+    CollisionMetrics::writeReport(filepath, this->settings, metrics_results, generation_duration);
+}
@@ -0,0 +1,73 @@
+#ifndef COLLISION_JOB_H
+#define COLLISION_JOB_H
+
+#include "collisioncache.h"
+#include "collisiongen.h"
+#include "collisionsweep.h"
+#include "mesh.h"
+
+#include <QThread>
+#include <QString>
+#include <QMetaType>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Generated collision hulls grouped by input mesh, see CollisionGen::generate.
+using CollisionJobResult = std::shared_ptr<std::vector<std::vector<std::unique_ptr<Mesh>>>>;
+
+/// Coarser collision LOD levels, see CollisionGen::generateLODChain.
+using CollisionJobLODResult = std::shared_ptr<CollisionLODChain>;
+
+
+class CollisionJob : public QThread
+{
+    Q_OBJECT
+
+public:
+    CollisionJob(const CollisionGenSettings &settings, QObject *parent = nullptr);
+
+    void addInputMesh(const Mesh &mesh);
+    void setCache(std::shared_ptr<CollisionCache> cache);
+    void setReportDirectory(const std::string &directory);
+    void setSweep(const std::vector<CollisionGenSettings> &variants, const CollisionSweepTarget &target);
+    void cancel();
+    bool isCancelled() const;
+
+    Q_SIGNAL
+    void progressChanged(double progress, const QString &stage);
+
+    Q_SIGNAL
+    void collisionGenerated(CollisionJobResult result);
+
+    Q_SIGNAL
+    void settingsTuned(const CollisionGenSettings &settings);
+
+    Q_SIGNAL
+    void collisionLODsGenerated(CollisionJobLODResult lods);
+
+protected:
+    void run() override;
+    void runSweep();
+    void measureCollision(
+        const CollisionJobResult &result,
+        const std::vector<std::vector<size_t>> &result_sources,
+        double generation_duration
+    );
+
+private:
+    CollisionGenSettings settings;
+    CollisionGen collision_gen;
+    std::vector<std::unique_ptr<Mesh>> input_meshes;
+    std::string report_directory;
+
+    CollisionSweep collision_sweep;
+    CollisionSweepTarget sweep_target;
+    std::vector<CollisionGenSettings> sweep_variants;
+};
+
+Q_DECLARE_METATYPE(CollisionJobResult)
+Q_DECLARE_METATYPE(CollisionJobLODResult)
+Q_DECLARE_METATYPE(CollisionGenSettings)
+
+#endif
@@ -0,0 +1,573 @@
+#include "collisionmetrics.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QString>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+
+#include <CGAL/AABB_tree.h>
+#include <CGAL/AABB_traits.h>
+#include <CGAL/AABB_triangle_primitive.h>
+#include <CGAL/Side_of_triangle_mesh.h>
+#include <CGAL/Polygon_mesh_processing/orient_polygon_soup.h>
+#include <CGAL/Polygon_mesh_processing/polygon_soup_to_polygon_mesh.h>
+#include <CGAL/Polygon_mesh_processing/orientation.h>
+
+using CGAL_FastTriangle = CGAL_FastKernel::Triangle_3;
+using CGAL_TrianglePrimitive = CGAL::AABB_triangle_primitive<
+    CGAL_FastKernel,
+    std::vector<CGAL_FastTriangle>::const_iterator
+>;
+using CGAL_TriangleTree = CGAL::AABB_tree<CGAL::AABB_traits<CGAL_FastKernel, CGAL_TrianglePrimitive>>;
+using CGAL_SideOfSurface = CGAL::Side_of_triangle_mesh<CGAL_FastSurface, CGAL_FastKernel>;
+
+/// Seed of surface sampling, fixed so reports of identical input are comparable.
+static const uint32_t SAMPLE_SEED = 0x5eed;
+
+
+/// Convex hull represented by its bounds and face planes for fast containment tests.
+struct HullVolume
+{
+    QVector3D min_bound;
+    QVector3D max_bound;
+    std::vector<std::array<double, 4>> planes;
+
+    bool contains(double x, double y, double z) const
+    {
+        if (x < this->min_bound.x() || y < this->min_bound.y() || z < this->min_bound.z() ||
+            x > this->max_bound.x() || y > this->max_bound.y() || z > this->max_bound.z())
+        {
+            return false;
+        }
+
+        for (const std::array<double, 4> &plane : this->planes)
+        {
+            if (plane[0] * x + plane[1] * y + plane[2] * z - plane[3] > 0.0)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
+
+/// Build containment test data of convex hull with faces oriented away from its centroid.
+static HullVolume buildHullVolume(const Mesh &hull)
+{
+    HullVolume volume;
+    std::span<const QVector3D> vertices = hull.getVertices();
+    std::span<const int> indices = hull.getIndices();
+    if (vertices.empty())
+    {
+        return volume;
+    }
+
+    QVector3D center(0.0, 0.0, 0.0);
+    volume.min_bound = vertices.front();
+    volume.max_bound = vertices.front();
+    for (const QVector3D &vertex : vertices)
+    {
+        center += vertex;
+        for (int axis=0; axis < 3; axis++)
+        {
+            volume.min_bound[axis] = std::min(volume.min_bound[axis], vertex[axis]);
+            volume.max_bound[axis] = std::max(volume.max_bound[axis], vertex[axis]);
+        }
+    }
+    center /= float(vertices.size());
+
+    for (size_t i=0; i+2 < indices.size(); i+=3)
+    {
+        const QVector3D &a = vertices[indices[i]];
+        QVector3D normal = QVector3D::crossProduct(vertices[indices[i+1]] - a, vertices[indices[i+2]] - a);
+        if (normal.lengthSquared() <= 0.0f)
+        {
+            continue;
+        }
+
+        normal.normalize();
+        if (QVector3D::dotProduct(normal, center - a) > 0.0f)
+        {
+            normal = -normal;
+        }
+
+        volume.planes.push_back({normal.x(), normal.y(), normal.z(), QVector3D::dotProduct(normal, a)});
+    }
+
+    return volume;
+}
+
+/// Append triangles of given mesh to the list of CGAL triangles.
+static void appendTriangles(const Mesh &mesh, std::vector<CGAL_FastTriangle> &out_triangles)
+{
+    std::span<const QVector3D> vertices = mesh.getVertices();
+    std::span<const int> indices = mesh.getIndices();
+    for (size_t i=0; i+2 < indices.size(); i+=3)
+    {
+        const QVector3D &a = vertices[indices[i]];
+        const QVector3D &b = vertices[indices[i+1]];
+        const QVector3D &c = vertices[indices[i+2]];
+
+        CGAL_FastTriangle triangle(
+            CGAL_FastPoint(a.x(), a.y(), a.z()),
+            CGAL_FastPoint(b.x(), b.y(), b.z()),
+            CGAL_FastPoint(c.x(), c.y(), c.z())
+        );
+
+        if (!triangle.is_degenerate())
+        {
+            out_triangles.push_back(triangle);
+        }
+    }
+}
+
+/// Get largest distance from given points to triangles stored in given tree.
+static double maxDistance(const std::vector<CGAL_FastPoint> &points, const CGAL_TriangleTree &tree)
+{
+    if (points.empty() || tree.empty())
+    {
+        return 0.0;
+    }
+
+    return std::sqrt(tbb::parallel_reduce(
+        tbb::blocked_range<size_t>(0, points.size()),
+        0.0,
+        [&](const tbb::blocked_range<size_t> &range, double max_distance)
+        {
+            for (size_t i=range.begin(); i != range.end(); i++)
+            {
+                max_distance = std::max(max_distance, CGAL::to_double(tree.squared_distance(points[i])));
+            }
+
+            return max_distance;
+        },
+        [](double a, double b)
+        {
+            return std::max(a, b);
+        }
+    ));
+}
+
+
+/// Create metrics engine.
+/// @param: volume_resolution Number of volume samples along the longest bounding box axis.
+/// @param: surface_samples Number of random surface samples used for distance metrics,
+/// mesh vertices are always sampled in addition.
+CollisionMetrics::CollisionMetrics(int volume_resolution, size_t surface_samples) :
+    volume_resolution(std::max(volume_resolution, 1)),
+    surface_samples(surface_samples)
+{
+}
+
+/// Measure how well given hulls approximate source mesh.
+/// Volume metrics are estimated on a regular grid of samples covering both source and hulls.
+/// Hausdorff distances are estimated from surface samples queried against AABB trees of the
+/// opposite surface. Sampling and queries run in parallel.
+/// @param: source Mesh the hulls were generated for.
+/// @param: hulls Generated collision hulls.
+CollisionMetricsResult CollisionMetrics::evaluate(
+    const Mesh &source,
+    const std::vector<std::unique_ptr<Mesh>> &hulls
+) const
+{
+    namespace PMP = CGAL::Polygon_mesh_processing;
+
+    auto start_time = std::chrono::steady_clock::now();
+    CollisionMetricsResult result;
+    result.num_hulls = hulls.size();
+    result.hull_excess_volumes.assign(hulls.size(), 0.0);
+    for (const std::unique_ptr<Mesh> &hull : hulls)
+    {
+        result.num_hull_vertices += hull->numVertices();
+    }
+
+    if (source.numIndices() < 3 || hulls.empty())
+    {
+        return result;
+    }
+
+    /// Distance queries against both surfaces.
+    std::vector<CGAL_FastTriangle> source_triangles;
+    std::vector<CGAL_FastTriangle> hull_triangles;
+    appendTriangles(source, source_triangles);
+    for (const std::unique_ptr<Mesh> &hull : hulls)
+    {
+        appendTriangles(*hull, hull_triangles);
+    }
+
+    CGAL_TriangleTree source_tree(source_triangles.begin(), source_triangles.end());
+    CGAL_TriangleTree hull_tree(hull_triangles.begin(), hull_triangles.end());
+    source_tree.accelerate_distance_queries();
+    hull_tree.accelerate_distance_queries();
+
+    std::vector<CGAL_FastPoint> source_samples;
+    std::vector<CGAL_FastPoint> hull_samples;
+    this->sampleSurface(source, source_samples);
+    for (const std::unique_ptr<Mesh> &hull : hulls)
+    {
+        this->sampleSurface(*hull, hull_samples);
+    }
+
+    result.hausdorff_source_to_hull = maxDistance(source_samples, hull_tree);
+    result.hausdorff_hull_to_source = maxDistance(hull_samples, source_tree);
+    result.hausdorff = std::max(result.hausdorff_source_to_hull, result.hausdorff_hull_to_source);
+
+    /// Volume metrics need closed source surface to tell inside from outside.
+    std::vector<CGAL_FastPoint> points;
+    std::vector<std::array<std::size_t, 3>> faces;
+    for (const QVector3D &vertex : source.getVertices())
+    {
+        points.emplace_back(vertex.x(), vertex.y(), vertex.z());
+    }
+
+    std::span<const int> indices = source.getIndices();
+    for (size_t i=0; i+2 < indices.size(); i+=3)
+    {
+        faces.push_back({std::size_t(indices[i]), std::size_t(indices[i+1]), std::size_t(indices[i+2])});
+    }
+
+    CGAL_FastSurface surface;
+    PMP::orient_polygon_soup(points, faces);
+    PMP::polygon_soup_to_polygon_mesh(points, faces, surface);
+    if (!CGAL::is_valid_polygon_mesh(surface) || !CGAL::is_closed(surface))
+    {
+        logDebug("Source mesh is not closed, skipping volume metrics");
+        auto end_time = std::chrono::steady_clock::now();
+        result.duration = std::chrono::duration<double>(end_time - start_time).count();
+        return result;
+    }
+
+    PMP::orient_to_bound_a_volume(surface);
+    CGAL_SideOfSurface inside_source(surface);
+
+    std::vector<HullVolume> hull_volumes;
+    hull_volumes.reserve(hulls.size());
+    QVector3D min_bound = source.getVertices().front();
+    QVector3D max_bound = source.getVertices().front();
+    for (const QVector3D &vertex : source.getVertices())
+    {
+        for (int axis=0; axis < 3; axis++)
+        {
+            min_bound[axis] = std::min(min_bound[axis], vertex[axis]);
+            max_bound[axis] = std::max(max_bound[axis], vertex[axis]);
+        }
+    }
+
+    for (const std::unique_ptr<Mesh> &hull : hulls)
+    {
+        hull_volumes.push_back(buildHullVolume(*hull));
+        for (int axis=0; axis < 3; axis++)
+        {
+            min_bound[axis] = std::min(min_bound[axis], hull_volumes.back().min_bound[axis]);
+            max_bound[axis] = std::max(max_bound[axis], hull_volumes.back().max_bound[axis]);
+        }
+    }
+
+    const QVector3D extent = max_bound - min_bound;
+    const double cell_size = std::max({extent.x(), extent.y(), extent.z()}) / this->volume_resolution;
+    if (cell_size <= 0.0)
+    {
+        return result;
+    }
+
+    std::array<size_t, 3> cells;
+    for (int axis=0; axis < 3; axis++)
+    {
+        cells[axis] = std::max<size_t>(1, size_t(std::ceil(extent[axis] / cell_size)));
+    }
+
+    /// Side of surface builds its search tree on first query, do it before going parallel.
+    inside_source(CGAL_FastPoint(min_bound.x(), min_bound.y(), min_bound.z()));
+
+    /// Sample counts gathered per z slice and reduced afterwards to stay deterministic.
+    struct SliceCounts
+    {
+        size_t source = 0;
+        size_t hull = 0;
+        size_t both = 0;
+        std::vector<size_t> hull_excess;
+    };
+
+    std::vector<SliceCounts> slices(cells[2]);
+    tbb::parallel_for(size_t(0), cells[2], [&](size_t z)
+    {
+        SliceCounts &counts = slices[z];
+        counts.hull_excess.assign(hulls.size(), 0);
+
+        const double pz = min_bound.z() + (z + 0.5) * cell_size;
+        for (size_t y=0; y < cells[1]; y++)
+        {
+            const double py = min_bound.y() + (y + 0.5) * cell_size;
+            for (size_t x=0; x < cells[0]; x++)
+            {
+                const double px = min_bound.x() + (x + 0.5) * cell_size;
+                const bool in_source = inside_source(CGAL_FastPoint(px, py, pz)) != CGAL::ON_UNBOUNDED_SIDE;
+
+                bool in_hull = false;
+                for (size_t h=0; h < hull_volumes.size(); h++)
+                {
+                    if (hull_volumes[h].contains(px, py, pz))
+                    {
+                        in_hull = true;
+                        if (!in_source)
+                        {
+                            counts.hull_excess[h]++;
+                        }
+                    }
+                }
+
+                counts.source += in_source;
+                counts.hull += in_hull;
+                counts.both += in_source && in_hull;
+            }
+        }
+    });
+
+    size_t source_count = 0;
+    size_t hull_count = 0;
+    size_t both_count = 0;
+    const double cell_volume = cell_size * cell_size * cell_size;
+    for (const SliceCounts &counts : slices)
+    {
+        source_count += counts.source;
+        hull_count += counts.hull;
+        both_count += counts.both;
+        for (size_t h=0; h < hulls.size(); h++)
+        {
+            result.hull_excess_volumes[h] += counts.hull_excess[h] * cell_volume;
+        }
+    }
+
+    const size_t union_count = source_count + hull_count - both_count;
+    result.volume_valid = true;
+    result.source_volume = source_count * cell_volume;
+    result.hull_volume = hull_count * cell_volume;
+    result.volume_iou = union_count > 0 ? double(both_count) / union_count : 0.0;
+
+    auto end_time = std::chrono::steady_clock::now();
+    result.duration = std::chrono::duration<double>(end_time - start_time).count();
+    return result;
+}
+
+/// Sample mesh surface uniformly by area, mesh vertices are included in the samples.
+/// Sampling is deterministic, same mesh always yields the same samples.
+/// @param: mesh Mesh to sample.
+/// @param: out_points List to append sampled points to.
+void CollisionMetrics::sampleSurface(const Mesh &mesh, std::vector<CGAL_FastPoint> &out_points) const
+{
+    std::span<const QVector3D> vertices = mesh.getVertices();
+    std::span<const int> indices = mesh.getIndices();
+    for (const QVector3D &vertex : vertices)
+    {
+        out_points.emplace_back(vertex.x(), vertex.y(), vertex.z());
+    }
+
+    std::vector<double> cumulative_area;
+    cumulative_area.reserve(indices.size() / 3);
+    double total_area = 0.0;
+    for (size_t i=0; i+2 < indices.size(); i+=3)
+    {
+        const QVector3D &a = vertices[indices[i]];
+        total_area += QVector3D::crossProduct(vertices[indices[i+1]] - a, vertices[indices[i+2]] - a).length() * 0.5;
+        cumulative_area.push_back(total_area);
+    }
+
+    if (total_area <= 0.0 || this->surface_samples == 0)
+    {
+        return;
+    }
+
+    /// Random numbers are drawn up front from single generator seeded once per evaluation,
+    /// so samples are uncorrelated while parallel sampling stays deterministic.
+    std::mt19937 generator(SAMPLE_SEED);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    std::vector<double> random_values(this->surface_samples * 3);
+    for (double &value : random_values)
+    {
+        value = distribution(generator);
+    }
+
+    const size_t offset = out_points.size();
+    out_points.resize(offset + this->surface_samples, CGAL_FastPoint(0.0, 0.0, 0.0));
+    tbb::parallel_for(size_t(0), this->surface_samples, [&](size_t sample)
+    {
+        const double *values = &random_values[sample * 3];
+        const double area = values[0] * total_area;
+        const size_t triangle = std::min<size_t>(
+            std::lower_bound(cumulative_area.begin(), cumulative_area.end(), area) - cumulative_area.begin(),
+            cumulative_area.size() - 1
+        );
+
+        /// Uniform barycentric coordinates on the triangle.
+        const double r1 = std::sqrt(values[1]);
+        const double r2 = values[2];
+        const QVector3D &a = vertices[indices[triangle*3]];
+        const QVector3D &b = vertices[indices[triangle*3 + 1]];
+        const QVector3D &c = vertices[indices[triangle*3 + 2]];
+        const QVector3D point = a * float(1.0 - r1) + b * float(r1 * (1.0 - r2)) + c * float(r1 * r2);
+
+        out_points[offset + sample] = CGAL_FastPoint(point.x(), point.y(), point.z());
+    });
+}
+
+/// Write metrics of the mesh with given index to the log.
+void CollisionMetrics::logResult(size_t mesh_idx, const CollisionMetricsResult &result)
+{
+    const double excess_volume = std::accumulate(
+        result.hull_excess_volumes.begin(),
+        result.hull_excess_volumes.end(),
+        0.0
+    );
+
+    logInfo(
+        "Mesh {} collision metrics: {} hulls, {} vertices, IoU {}, excess volume {:.6f}, "
+        "Hausdorff {:.6f} (source to hull {:.6f}, hull to source {:.6f}), measured in {:.3f}s",
+        mesh_idx,
+        result.num_hulls,
+        result.num_hull_vertices,
+        result.volume_valid ? std::vformat("{:.4f}", std::make_format_args(result.volume_iou)) : "n/a",
+        excess_volume,
+        result.hausdorff,
+        result.hausdorff_source_to_hull,
+        result.hausdorff_hull_to_source,
+        result.duration
+    );
+}
+
+/// Convert collision generation settings to JSON object keyed by setting names.
+/// @param: settings Settings to convert.
+/// Returns JSON object with one field per setting.
+QJsonObject CollisionMetrics::settingsToJson(const CollisionGenSettings &settings)
+{
+    QJsonObject json_settings;
+    json_settings["scale"] = settings.scale;
+    json_settings["technique"] = settings.technique;
+    json_settings["cleanup_mode"] = settings.cleanup_mode;
+    json_settings["resolution"] = settings.resolution;
+    json_settings["concavity"] = settings.concavity;
+    json_settings["mode"] = settings.mode;
+    json_settings["depth_planes"] = settings.depth_planes;
+    json_settings["worker_threads"] = settings.worker_threads;
+    json_settings["max_hulls"] = settings.max_hulls;
+    json_settings["max_hull_vertices"] = settings.max_hull_vertices;
+    json_settings["min_hull_volume"] = settings.min_hull_volume;
+    json_settings["downsample"] = settings.downsample;
+    json_settings["decimate"] = settings.decimate;
+    json_settings["merge_threshold"] = settings.merge_threshold;
+    json_settings["strict_vertex_limit"] = settings.strict_vertex_limit;
+    json_settings["hull_per_mesh"] = settings.hull_per_mesh;
+    json_settings["hull_padding"] = settings.hull_padding;
+    json_settings["exact_time_budget"] = settings.exact_time_budget;
+    json_settings["exact_max_pieces"] = settings.exact_max_pieces;
+    json_settings["primitive_tolerance"] = settings.primitive_tolerance;
+    json_settings["voxel_resolution"] = settings.voxel_resolution;
+    json_settings["max_boxes"] = settings.max_boxes;
+    json_settings["oriented_boxes"] = settings.oriented_boxes;
+    json_settings["lod_levels"] = settings.lod_levels;
+    json_settings["lod_ratio"] = settings.lod_ratio;
+    json_settings["dedupe_instances"] = settings.dedupe_instances;
+    json_settings["wrap_alpha"] = settings.wrap_alpha;
+    json_settings["wrap_offset"] = settings.wrap_offset;
+    json_settings["mesh_time_budget"] = settings.mesh_time_budget;
+    json_settings["mesh_memory_budget"] = settings.mesh_memory_budget;
+    json_settings["worker_processes"] = settings.worker_processes;
+    json_settings["compute_metrics"] = settings.compute_metrics;
+
+    return json_settings;
+}
+
+/// Convert collision metrics of single mesh to JSON object.
+/// @param: result Metrics to convert.
+/// Returns JSON object with one field per metric.
+QJsonObject CollisionMetrics::resultToJson(const CollisionMetricsResult &result)
+{
+    QJsonArray json_excess;
+    for (const double &volume : result.hull_excess_volumes)
+    {
+        json_excess.append(volume);
+    }
+
+    QJsonArray json_degradations;
+    for (const CollisionDegradation &degradation : result.degradations)
+    {
+        QJsonObject json_degradation;
+        json_degradation["reason"] = QString::fromStdString(degradation.reason);
+        json_degradation["resolution"] = degradation.resolution;
+        json_degradation["elapsed"] = degradation.elapsed;
+        json_degradation["peak_memory"] = qint64(degradation.peak_memory);
+        json_degradation["fallback"] = QString::fromStdString(degradation.fallback);
+        json_degradation["fallback_resolution"] = degradation.fallback_resolution;
+        json_degradations.append(json_degradation);
+    }
+
+    QJsonObject json_mesh;
+    json_mesh["num_hulls"] = qint64(result.num_hulls);
+    json_mesh["num_hull_vertices"] = qint64(result.num_hull_vertices);
+    json_mesh["volume_valid"] = result.volume_valid;
+    json_mesh["source_volume"] = result.source_volume;
+    json_mesh["hull_volume"] = result.hull_volume;
+    json_mesh["volume_iou"] = result.volume_valid ? QJsonValue(result.volume_iou) : QJsonValue();
+    json_mesh["hausdorff"] = result.hausdorff;
+    json_mesh["hausdorff_source_to_hull"] = result.hausdorff_source_to_hull;
+    json_mesh["hausdorff_hull_to_source"] = result.hausdorff_hull_to_source;
+    json_mesh["hull_excess_volumes"] = json_excess;
+    json_mesh["duration"] = result.duration;
+    json_mesh["degradations"] = json_degradations;
+
+    return json_mesh;
+}
+
+/// Write machine readable JSON report of collision metrics.
+/// @param: filepath Location of the report file on disk.
+/// @param: settings Settings used to generate the measured collision.
+/// @param: results Metrics of each input mesh.
+/// @param: generation_duration Time spent generating the collision in seconds.
+bool CollisionMetrics::writeReport(
+    const std::string &filepath,
+    const CollisionGenSettings &settings,
+    const std::vector<CollisionMetricsResult> &results,
+    double generation_duration
+)
+{
+    const QJsonObject json_settings = CollisionMetrics::settingsToJson(settings);
+
+    QJsonArray json_meshes;
+    for (const CollisionMetricsResult &result : results)
+    {
+        json_meshes.append(CollisionMetrics::resultToJson(result));
+    }
+
+    QJsonObject json_report;
+    json_report["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    json_report["generation_duration"] = generation_duration;
+    json_report["settings"] = json_settings;
+    json_report["meshes"] = json_meshes;
+
+    QFile file(QString::fromStdString(filepath));
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+    {
+        logError("Failed to open collision metrics report for writing -> {}", filepath);
+        return false;
+    }
+
+    file.write(QJsonDocument(json_report).toJson(QJsonDocument::Indented));
+    logInfo("Collision metrics report written -> {}", filepath);
+    return true;
+}
@@ -0,0 +1,67 @@
+#ifndef COLLISION_METRICS_H
+#define COLLISION_METRICS_H
+
+#include "collisiongen.h"
+#include "mesh.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <QJsonObject>
+
+
+/// Approximation quality of collision hulls generated for single source mesh.
+struct CollisionMetricsResult
+{
+    /// Volume metrics are only valid for closed source meshes.
+    bool    volume_valid = false;
+    double  source_volume = 0.0;
+    double  hull_volume = 0.0;
+    double  volume_iou = 0.0;
+
+    /// Largest distance from source surface to hulls, from hulls to source and both ways.
+    double  hausdorff_source_to_hull = 0.0;
+    double  hausdorff_hull_to_source = 0.0;
+    double  hausdorff = 0.0;
+
+    /// Volume of each hull lying outside the source mesh.
+    std::vector<double> hull_excess_volumes;
+
+    size_t  num_hulls = 0;
+    size_t  num_hull_vertices = 0;
+    double  duration = 0.0;
+
+    /// Fallbacks taken while generating the hulls because the mesh exceeded its budget.
+    std::vector<CollisionDegradation> degradations;
+};
+
+
+class CollisionMetrics
+{
+public:
+    CollisionMetrics(int volume_resolution = 64, size_t surface_samples = 20000);
+
+    CollisionMetricsResult evaluate(
+        const Mesh &source,
+        const std::vector<std::unique_ptr<Mesh>> &hulls
+    ) const;
+
+    static void logResult(size_t mesh_idx, const CollisionMetricsResult &result);
+    static QJsonObject settingsToJson(const CollisionGenSettings &settings);
+    static QJsonObject resultToJson(const CollisionMetricsResult &result);
+    static bool writeReport(
+        const std::string &filepath,
+        const CollisionGenSettings &settings,
+        const std::vector<CollisionMetricsResult> &results,
+        double generation_duration
+    );
+
+protected:
+    void sampleSurface(const Mesh &mesh, std::vector<CGAL_FastPoint> &out_points) const;
+
+private:
+    int volume_resolution;
+    size_t surface_samples;
+};
+
+#endif
@@ -0,0 +1,407 @@
+#include "collisionprimitives.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <vector>
+
+#include <QQuaternion>
+#include <QVector3D>
+
+#include <CGAL/optimal_bounding_box.h>
+#include <CGAL/Simple_cartesian.h>
+#include <CGAL/Min_sphere_of_spheres_d.h>
+#include <CGAL/Min_sphere_of_spheres_d_traits_d.h>
+
+using MinSphereKernel = CGAL::Simple_cartesian<double>;
+using MinSphereTraits = CGAL::Min_sphere_of_spheres_d_traits_3<MinSphereKernel, double>;
+using MinSphere = CGAL::Min_sphere_of_spheres_d<MinSphereTraits>;
+
+/// Number of segments around the circumference of tessellated spheres and capsules.
+static const int PRIMITIVE_SEGMENTS = 16;
+
+/// Number of rings in each tessellated hemisphere.
+static const int PRIMITIVE_HEMISPHERE_RINGS = 4;
+
+
+/// Get unit vector perpendicular to given unit vector.
+static QVector3D perpendicular(const QVector3D &dir)
+{
+    const QVector3D helper = std::abs(dir.x()) < 0.9f ? QVector3D(1.0f, 0.0f, 0.0f) : QVector3D(0.0f, 1.0f, 0.0f);
+    return QVector3D::crossProduct(dir, helper).normalized();
+}
+
+/// Fit oriented bounding box enclosing given points.
+/// Box local Z axis is aligned with its longest edge, which is used as capsule axis.
+/// @param: points Points to enclose, convex hull vertices are sufficient.
+/// @param: out_primitive Receives fitted box.
+bool CollisionPrimitives::fitBox(const std::vector<CGAL_FastPoint> &points, MeshPrimitive &out_primitive)
+{
+    if (points.size() < 4)
+    {
+        return false;
+    }
+
+    /// Box corners are ordered so that corners 1, 3 and 5 share an edge with corner 0.
+    std::array<CGAL_FastPoint, 8> corners;
+    CGAL::oriented_bounding_box(points, corners, CGAL::parameters::use_convex_hull(true));
+
+    auto edge = [&corners](int idx)
+    {
+        const CGAL_FastKernel::Vector_3 v = corners[idx] - corners[0];
+        return QVector3D(v.x(), v.y(), v.z());
+    };
+
+    std::array<QVector3D, 3> edges = {edge(1), edge(3), edge(5)};
+    std::sort(edges.begin(), edges.end(), [](const QVector3D &a, const QVector3D &b)
+    {
+        return a.lengthSquared() > b.lengthSquared();
+    });
+
+    if (edges[0].lengthSquared() <= 0.0f)
+    {
+        return false;
+    }
+
+    /// Rebuild orthonormal right-handed frame, flat point sets produce degenerate edges.
+    const QVector3D axis_z = edges[0].normalized();
+    QVector3D axis_x = edges[1] - axis_z * QVector3D::dotProduct(edges[1], axis_z);
+    axis_x = axis_x.lengthSquared() > 0.0f ? axis_x.normalized() : perpendicular(axis_z);
+    const QVector3D axis_y = QVector3D::crossProduct(axis_z, axis_x);
+
+    /// Extents are measured from the points so the box always encloses them.
+    QVector3D min_local(
+        std::numeric_limits<float>::max(),
+        std::numeric_limits<float>::max(),
+        std::numeric_limits<float>::max()
+    );
+    QVector3D max_local = -min_local;
+    for (const CGAL_FastPoint &point : points)
+    {
+        const QVector3D p(point.x(), point.y(), point.z());
+        const QVector3D local(
+            QVector3D::dotProduct(p, axis_x),
+            QVector3D::dotProduct(p, axis_y),
+            QVector3D::dotProduct(p, axis_z)
+        );
+
+        min_local = QVector3D(
+            std::min(min_local.x(), local.x()),
+            std::min(min_local.y(), local.y()),
+            std::min(min_local.z(), local.z())
+        );
+        max_local = QVector3D(
+            std::max(max_local.x(), local.x()),
+            std::max(max_local.y(), local.y()),
+            std::max(max_local.z(), local.z())
+        );
+    }
+
+    const QVector3D local_center = (min_local + max_local) * 0.5f;
+
+    out_primitive = MeshPrimitive();
+    out_primitive.type = MeshPrimitiveType::BoxPrimitive;
+    out_primitive.center = axis_x * local_center.x() + axis_y * local_center.y() + axis_z * local_center.z();
+    out_primitive.rotation = QQuaternion::fromAxes(axis_x, axis_y, axis_z);
+    out_primitive.half_extents = (max_local - min_local) * 0.5f;
+
+    return true;
+}
+
+/// Fit minimal sphere enclosing given points.
+/// @param: points Points to enclose, convex hull vertices are sufficient.
+/// @param: out_primitive Receives fitted sphere.
+bool CollisionPrimitives::fitSphere(const std::vector<CGAL_FastPoint> &points, MeshPrimitive &out_primitive)
+{
+    if (points.empty())
+    {
+        return false;
+    }
+
+    std::vector<MinSphereTraits::Sphere> spheres;
+    spheres.reserve(points.size());
+    for (const CGAL_FastPoint &point : points)
+    {
+        spheres.emplace_back(MinSphereKernel::Point_3(point.x(), point.y(), point.z()), 0.0);
+    }
+
+    MinSphere sphere(spheres.begin(), spheres.end());
+    const QVector3D center(
+        CGAL::to_double(*(sphere.center_cartesian_begin() + 0)),
+        CGAL::to_double(*(sphere.center_cartesian_begin() + 1)),
+        CGAL::to_double(*(sphere.center_cartesian_begin() + 2))
+    );
+
+    /// Radius is measured from the points so rounding never leaves a point outside.
+    float radius = 0.0f;
+    for (const CGAL_FastPoint &point : points)
+    {
+        radius = std::max(radius, (QVector3D(point.x(), point.y(), point.z()) - center).length());
+    }
+
+    out_primitive = MeshPrimitive();
+    out_primitive.type = MeshPrimitiveType::SpherePrimitive;
+    out_primitive.center = center;
+    out_primitive.radius = radius;
+
+    return true;
+}
+
+/// Fit capsule enclosing given points along the longest axis of their bounding box.
+/// Radius covers the widest point, the spine is then shortened as far as the end caps allow.
+/// @param: points Points to enclose, convex hull vertices are sufficient.
+/// @param: box Oriented bounding box of the points, see CollisionPrimitives::fitBox.
+/// @param: out_primitive Receives fitted capsule.
+bool CollisionPrimitives::fitCapsule(
+    const std::vector<CGAL_FastPoint> &points,
+    const MeshPrimitive &box,
+    MeshPrimitive &out_primitive
+)
+{
+    if (points.empty() || box.type != MeshPrimitiveType::BoxPrimitive)
+    {
+        return false;
+    }
+
+    const QVector3D axis = box.rotation.rotatedVector(QVector3D(0.0f, 0.0f, 1.0f));
+
+    std::vector<float> heights(points.size());
+    std::vector<float> distances(points.size());
+    float radius = 0.0f;
+    for (size_t i=0; i < points.size(); i++)
+    {
+        const QVector3D offset = QVector3D(points[i].x(), points[i].y(), points[i].z()) - box.center;
+        heights[i] = QVector3D::dotProduct(offset, axis);
+        distances[i] = (offset - axis * heights[i]).length();
+        radius = std::max(radius, distances[i]);
+    }
+
+    /// Spine has to reach within cap reach of every point, from both ends.
+    float spine_min = std::numeric_limits<float>::max();
+    float spine_max = std::numeric_limits<float>::lowest();
+    for (size_t i=0; i < points.size(); i++)
+    {
+        const float reach = std::sqrt(std::max(radius * radius - distances[i] * distances[i], 0.0f));
+        spine_min = std::min(spine_min, heights[i] + reach);
+        spine_max = std::max(spine_max, heights[i] - reach);
+    }
+
+    if (spine_max < spine_min)
+    {
+        spine_min = spine_max = (spine_min + spine_max) * 0.5f;
+    }
+
+    out_primitive = MeshPrimitive();
+    out_primitive.type = MeshPrimitiveType::CapsulePrimitive;
+    out_primitive.center = box.center + axis * ((spine_min + spine_max) * 0.5f);
+    out_primitive.rotation = box.rotation;
+    out_primitive.radius = radius;
+    out_primitive.half_height = (spine_max - spine_min) * 0.5f;
+
+    return true;
+}
+
+/// Fit cheapest primitive enclosing given points within error tolerance.
+/// Primitives are tried from the cheapest to test at runtime: sphere, capsule and box.
+/// Error is the fraction of primitive volume not covered by the reference volume.
+/// @param: points Points to enclose, convex hull vertices are sufficient.
+/// @param: reference_volume Volume the primitive approximates, usually volume of the convex hull.
+/// @param: tolerance Maximum error of the accepted primitive.
+/// @param: out_primitive Receives fitted primitive.
+/// @param: out_error Receives error of the fitted primitive.
+/// Returns false if no primitive meets the tolerance.
+bool CollisionPrimitives::fitCheapest(
+    const std::vector<CGAL_FastPoint> &points,
+    double reference_volume,
+    double tolerance,
+    MeshPrimitive &out_primitive,
+    double &out_error
+)
+{
+    MeshPrimitive box;
+    if (!CollisionPrimitives::fitBox(points, box))
+    {
+        return false;
+    }
+
+    /// Flat point sets have no volume to compare with, box is the only primitive that fits them tightly.
+    if (reference_volume <= 0.0)
+    {
+        out_primitive = box;
+        out_error = 0.0;
+        return true;
+    }
+
+    std::vector<MeshPrimitive> candidates(2);
+    CollisionPrimitives::fitSphere(points, candidates[0]);
+    CollisionPrimitives::fitCapsule(points, box, candidates[1]);
+    candidates.push_back(box);
+
+    for (const MeshPrimitive &candidate : candidates)
+    {
+        const double volume = CollisionPrimitives::computeVolume(candidate);
+        if (candidate.type == MeshPrimitiveType::NoPrimitive || volume <= 0.0)
+        {
+            continue;
+        }
+
+        const double error = std::max(1.0 - reference_volume / volume, 0.0);
+        if (error <= tolerance)
+        {
+            out_primitive = candidate;
+            out_error = error;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// Compute volume enclosed by given primitive.
+double CollisionPrimitives::computeVolume(const MeshPrimitive &primitive)
+{
+    const double pi = std::numbers::pi;
+    const double radius = primitive.radius;
+
+    switch (primitive.type)
+    {
+        case MeshPrimitiveType::BoxPrimitive:
+            return 8.0 * primitive.half_extents.x() * primitive.half_extents.y() * primitive.half_extents.z();
+        case MeshPrimitiveType::SpherePrimitive:
+            return 4.0 / 3.0 * pi * radius * radius * radius;
+        case MeshPrimitiveType::CapsulePrimitive:
+            return pi * radius * radius * (2.0 * primitive.half_height) + 4.0 / 3.0 * pi * radius * radius * radius;
+        default:
+            return 0.0;
+    }
+}
+
+/// Build triangle mesh approximating given primitive, mesh is tagged with the primitive.
+/// Mesh is used for display and metrics, exporters write the primitive itself.
+/// @param: primitive Primitive to tessellate.
+/// @param: out_mesh Reference to mesh to store the tessellation in.
+void CollisionPrimitives::tessellate(const MeshPrimitive &primitive, Mesh &out_mesh)
+{
+    std::vector<QVector3D> vertices;
+    std::vector<int> indices;
+
+    /// All primitives are convex around their center, which gives outward winding of each triangle.
+    auto add_triangle = [&](int a, int b, int c)
+    {
+        const QVector3D normal = QVector3D::crossProduct(vertices[b] - vertices[a], vertices[c] - vertices[a]);
+        const QVector3D centroid = (vertices[a] + vertices[b] + vertices[c]) / 3.0f;
+        if (QVector3D::dotProduct(normal, centroid - primitive.center) < 0.0f)
+        {
+            std::swap(b, c);
+        }
+
+        indices.insert(indices.end(), {a, b, c});
+    };
+
+    auto add_vertex = [&](const QVector3D &local)
+    {
+        vertices.push_back(primitive.center + primitive.rotation.rotatedVector(local));
+        return int(vertices.size() - 1);
+    };
+
+    if (primitive.type == MeshPrimitiveType::BoxPrimitive)
+    {
+        const QVector3D &extents = primitive.half_extents;
+        for (int i=0; i < 8; i++)
+        {
+            add_vertex(QVector3D(
+                (i & 1) ? extents.x() : -extents.x(),
+                (i & 2) ? extents.y() : -extents.y(),
+                (i & 4) ? extents.z() : -extents.z()
+            ));
+        }
+
+        static const int faces[6][4] = {
+            {0, 2, 6, 4}, {1, 3, 7, 5},
+            {0, 1, 5, 4}, {2, 3, 7, 6},
+            {0, 1, 3, 2}, {4, 5, 7, 6}
+        };
+
+        for (const auto &face : faces)
+        {
+            add_triangle(face[0], face[1], face[2]);
+            add_triangle(face[0], face[2], face[3]);
+        }
+    }
+    else if (primitive.type == MeshPrimitiveType::SpherePrimitive ||
+             primitive.type == MeshPrimitiveType::CapsulePrimitive)
+    {
+        const float radius = primitive.radius;
+        const float half_height = primitive.type == MeshPrimitiveType::CapsulePrimitive ? primitive.half_height : 0.0f;
+        const double ring_step = std::numbers::pi * 0.5 / PRIMITIVE_HEMISPHERE_RINGS;
+
+        /// Latitude of each ring and the spine end it is attached to, equator is doubled for capsules.
+        std::vector<std::pair<double, float>> rings;
+        for (int i=1; i <= PRIMITIVE_HEMISPHERE_RINGS; i++)
+        {
+            rings.emplace_back(std::numbers::pi * 0.5 - i * ring_step, half_height);
+        }
+
+        for (int i=(half_height > 0.0f ? 0 : 1); i < PRIMITIVE_HEMISPHERE_RINGS; i++)
+        {
+            rings.emplace_back(-i * ring_step, -half_height);
+        }
+
+        const int top = add_vertex(QVector3D(0.0f, 0.0f, radius + half_height));
+        for (const auto &[latitude, offset] : rings)
+        {
+            const float ring_radius = radius * std::cos(latitude);
+            const float ring_z = radius * std::sin(latitude) + offset;
+            for (int j=0; j < PRIMITIVE_SEGMENTS; j++)
+            {
+                const double angle = 2.0 * std::numbers::pi * j / PRIMITIVE_SEGMENTS;
+                add_vertex(QVector3D(ring_radius * std::cos(angle), ring_radius * std::sin(angle), ring_z));
+            }
+        }
+        const int bottom = add_vertex(QVector3D(0.0f, 0.0f, -radius - half_height));
+
+        auto ring_vertex = [&](size_t ring, int segment)
+        {
+            return int(1 + ring * PRIMITIVE_SEGMENTS + segment % PRIMITIVE_SEGMENTS);
+        };
+
+        for (int j=0; j < PRIMITIVE_SEGMENTS; j++)
+        {
+            add_triangle(top, ring_vertex(0, j), ring_vertex(0, j+1));
+            for (size_t ring=0; ring+1 < rings.size(); ring++)
+            {
+                add_triangle(ring_vertex(ring, j), ring_vertex(ring+1, j), ring_vertex(ring+1, j+1));
+                add_triangle(ring_vertex(ring, j), ring_vertex(ring+1, j+1), ring_vertex(ring, j+1));
+            }
+            add_triangle(bottom, ring_vertex(rings.size()-1, j), ring_vertex(rings.size()-1, j+1));
+        }
+    }
+    else
+    {
+        logWarning("Unable to tessellate unsupported primitive type -> {}", primitive.type);
+    }
+
+    out_mesh = Mesh(vertices, indices);
+    out_mesh.generateNormals();
+    out_mesh.computeBounds();
+    out_mesh.setPrimitive(primitive);
+}
+
+/// Get display name of given primitive type.
+std::string CollisionPrimitives::getTypeName(int type)
+{
+    switch (type)
+    {
+        case MeshPrimitiveType::BoxPrimitive:
+            return "Box";
+        case MeshPrimitiveType::SpherePrimitive:
+            return "Sphere";
+        case MeshPrimitiveType::CapsulePrimitive:
+            return "Capsule";
+        default:
+            return "Hull";
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef COLLISION_PRIMITIVES_H
+#define COLLISION_PRIMITIVES_H
+
+#include "collisiongen.h"
+#include "mesh.h"
+
+#include <string>
+#include <vector>
+
+
+/// Fitting of analytic collision shapes enclosing a set of points.
+/// Fitted shapes are tessellated into meshes tagged with the shape, see Mesh::getPrimitive.
+class CollisionPrimitives
+{
+public:
+    static bool fitBox(const std::vector<CGAL_FastPoint> &points, MeshPrimitive &out_primitive);
+    static bool fitSphere(const std::vector<CGAL_FastPoint> &points, MeshPrimitive &out_primitive);
+    static bool fitCapsule(
+        const std::vector<CGAL_FastPoint> &points,
+        const MeshPrimitive &box,
+        MeshPrimitive &out_primitive
+    );
+    static bool fitCheapest(
+        const std::vector<CGAL_FastPoint> &points,
+        double reference_volume,
+        double tolerance,
+        MeshPrimitive &out_primitive,
+        double &out_error
+    );
+
+    static double computeVolume(const MeshPrimitive &primitive);
+    static void tessellate(const MeshPrimitive &primitive, Mesh &out_mesh);
+    static std::string getTypeName(int type);
+};
+
+#endif
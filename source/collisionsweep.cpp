@@ -0,0 +1,326 @@
+#include "collisionsweep.h"
+#include "collisionmetrics.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+/// Resolution of volume and surface sampling used to measure error of each variant.
+/// Kept lower than the standalone metrics as only relative comparison between variants matters.
+static const int SWEEP_VOLUME_RESOLUTION = 32;
+static const size_t SWEEP_SURFACE_SAMPLES = 5000;
+
+
+CollisionSweep::CollisionSweep() :
+    cancelled(false)
+{
+}
+
+/// Adds new mesh to use as input for every swept variant.
+void CollisionSweep::addInputMesh(const Mesh *mesh)
+{
+    this->input_meshes.push_back(mesh);
+}
+
+/// Bind cache shared by generators of all variants.
+void CollisionSweep::setCache(std::shared_ptr<CollisionCache> cache)
+{
+    this->cache = cache;
+}
+
+/// Set function to receive overall sweep progress.
+void CollisionSweep::setProgressCallback(const CollisionProgressCallback &callback)
+{
+    this->progress_callback = callback;
+}
+
+/// Request running sweep to stop as soon as possible.
+/// Safe to call from any thread.
+void CollisionSweep::cancel()
+{
+    this->cancelled = true;
+
+    std::lock_guard<std::mutex> lock(this->generators_mutex);
+    for (CollisionGen *generator : this->active_generators)
+    {
+        generator->cancel();
+    }
+}
+
+/// Get value indicating if the sweep has been cancelled.
+bool CollisionSweep::isCancelled() const
+{
+    return this->cancelled;
+}
+
+/// Generate and measure collision for each settings variant.
+/// Variants run concurrently on a worker pool sized by worker threads of the first variant.
+/// @param: variants Settings variants to generate collision with.
+/// @param: out_results List to receive results in the order of variants.
+void CollisionSweep::run(
+    const std::vector<CollisionGenSettings> &variants,
+    std::vector<CollisionSweepResult> &out_results
+)
+{
+    out_results.clear();
+    out_results.resize(variants.size());
+    if (variants.empty())
+    {
+        return;
+    }
+
+    std::mutex progress_mutex;
+    std::vector<double> variant_progress(variants.size(), 0.0);
+    auto update_progress = [&](size_t variant_idx, double progress, const std::string &stage)
+    {
+        if (!this->progress_callback)
+        {
+            return;
+        }
+
+        double total = 0.0;
+        {
+            std::lock_guard<std::mutex> lock(progress_mutex);
+            variant_progress[variant_idx] = progress;
+            for (const double &value : variant_progress)
+            {
+                total += value;
+            }
+        }
+
+        this->progress_callback(total / variants.size(), "Sweeping settings");
+    };
+
+    /// Bounding sphere diameter of each input mesh used to normalize errors.
+    std::vector<double> mesh_sizes;
+    for (const Mesh *mesh : this->input_meshes)
+    {
+        mesh_sizes.push_back(std::max(mesh->getBoundingSphereRadius() * 2.0, 1e-9));
+    }
+
+    const int num_workers = variants.front().worker_threads > 0
+        ? variants.front().worker_threads
+        : tbb::task_arena::automatic;
+
+    tbb::task_arena arena(num_workers);
+    logInfo("Sweeping {} settings variants using {} worker threads", variants.size(), arena.max_concurrency());
+    arena.execute([&]()
+    {
+        tbb::parallel_for(size_t(0), variants.size(), [&](size_t variant_idx)
+        {
+            if (this->isCancelled())
+            {
+                return;
+            }
+
+            CollisionSweepResult &result = out_results.at(variant_idx);
+            result.settings = variants.at(variant_idx);
+
+            CollisionGen generator;
+            generator.setCache(this->cache);
+            for (const Mesh *mesh : this->input_meshes)
+            {
+                generator.addInputMesh(mesh);
+            }
+
+            generator.setProgressCallback([&, variant_idx](double progress, const std::string &stage)
+            {
+                update_progress(variant_idx, progress, stage);
+            });
+
+            {
+                std::lock_guard<std::mutex> lock(this->generators_mutex);
+                this->active_generators.push_back(&generator);
+                if (this->isCancelled())
+                {
+                    generator.cancel();
+                }
+            }
+
+            auto start_time = std::chrono::steady_clock::now();
+            generator.generate(result.settings, result.hulls);
+            auto end_time = std::chrono::steady_clock::now();
+            result.duration = std::chrono::duration<double>(end_time - start_time).count();
+
+            {
+                std::lock_guard<std::mutex> lock(this->generators_mutex);
+                auto it = std::find(this->active_generators.begin(), this->active_generators.end(), &generator);
+                this->active_generators.erase(it);
+            }
+
+            if (generator.isCancelled() || result.hulls.size() != this->input_meshes.size())
+            {
+                return;
+            }
+
+            /// Error is the worst Hausdorff distance relative to the size of its mesh.
+            CollisionMetrics metrics(SWEEP_VOLUME_RESOLUTION, SWEEP_SURFACE_SAMPLES);
+            for (size_t mesh_idx=0; mesh_idx < this->input_meshes.size(); mesh_idx++)
+            {
+                const std::vector<std::unique_ptr<Mesh>> &hulls = result.hulls.at(mesh_idx);
+                CollisionMetricsResult metrics_result = metrics.evaluate(*this->input_meshes.at(mesh_idx), hulls);
+                result.error = std::max(result.error, metrics_result.hausdorff / mesh_sizes.at(mesh_idx));
+                result.num_hulls += hulls.size();
+                result.max_mesh_hulls = std::max(result.max_mesh_hulls, hulls.size());
+
+                for (const std::unique_ptr<Mesh> &hull : hulls)
+                {
+                    result.num_vertices += hull->numVertices();
+                    result.max_hull_vertices = std::max(result.max_hull_vertices, hull->numVertices());
+                }
+            }
+
+            result.valid = true;
+        });
+    });
+}
+
+/// Build grid of settings variants around given base settings for approximate decomposition.
+/// Resolution and concavity are scaled around their base values, hull count is sampled
+/// up to the target budget. Every variant enforces the target hull vertex limit.
+/// @param: base_settings Settings the variants are derived from.
+/// @param: target Budget the variants should meet.
+std::vector<CollisionGenSettings> CollisionSweep::generateVariants(
+    const CollisionGenSettings &base_settings,
+    const CollisionSweepTarget &target
+)
+{
+    const double resolution_scales[] = {0.5, 1.0, 2.0};
+    const double concavity_scales[] = {0.4, 1.0, 4.0};
+
+    std::vector<int> hull_counts = {
+        std::max(1, target.max_hulls / 4),
+        std::max(1, target.max_hulls / 2),
+        std::max(1, target.max_hulls)
+    };
+    hull_counts.erase(std::unique(hull_counts.begin(), hull_counts.end()), hull_counts.end());
+
+    std::vector<CollisionGenSettings> variants;
+    for (const double &resolution_scale : resolution_scales)
+    {
+        for (const double &concavity_scale : concavity_scales)
+        {
+            for (const int &hull_count : hull_counts)
+            {
+                CollisionGenSettings settings = base_settings;
+                settings.technique = CollisionTechnique::ApproximateDecomposition;
+                settings.resolution = std::clamp(base_settings.resolution * resolution_scale, 10000.0, 64000000.0);
+                settings.concavity = std::clamp(base_settings.concavity * concavity_scale, 0.0, 1.0);
+                settings.max_hulls = hull_count;
+                settings.max_hull_vertices = target.max_hull_vertices;
+                settings.strict_vertex_limit = true;
+                settings.compute_metrics = false;
+                settings.lod_levels = 1;
+                variants.push_back(settings);
+            }
+        }
+    }
+
+    return variants;
+}
+
+/// Flag results which are not dominated by any other result in hull count,
+/// vertex count and error.
+void CollisionSweep::markParetoSet(std::vector<CollisionSweepResult> &results)
+{
+    for (CollisionSweepResult &result : results)
+    {
+        result.pareto = result.valid;
+        for (const CollisionSweepResult &other : results)
+        {
+            if (!result.pareto)
+            {
+                break;
+            }
+
+            if (!other.valid || &other == &result)
+            {
+                continue;
+            }
+
+            const bool no_worse =
+                other.num_hulls <= result.num_hulls &&
+                other.num_vertices <= result.num_vertices &&
+                other.error <= result.error;
+
+            const bool better =
+                other.num_hulls < result.num_hulls ||
+                other.num_vertices < result.num_vertices ||
+                other.error < result.error;
+
+            result.pareto = !(no_worse && better);
+        }
+    }
+}
+
+/// Select result which meets the target with the lowest runtime collision cost.
+/// Hull limit of the target applies to each mesh on its own, as it does for generation.
+/// Cost is the total hull vertex count, ties are broken by hull count and then error.
+/// Returns index of the selected result or -1 if no result meets the target.
+int CollisionSweep::selectCheapest(
+    const std::vector<CollisionSweepResult> &results,
+    const CollisionSweepTarget &target
+)
+{
+    int best = -1;
+    for (size_t i=0; i < results.size(); i++)
+    {
+        const CollisionSweepResult &result = results[i];
+        if (!result.valid ||
+            result.max_mesh_hulls > size_t(target.max_hulls) ||
+            result.max_hull_vertices > size_t(target.max_hull_vertices) ||
+            result.error > target.max_error)
+        {
+            continue;
+        }
+
+        if (best < 0)
+        {
+            best = i;
+            continue;
+        }
+
+        const CollisionSweepResult &current = results[best];
+        if (std::tie(result.num_vertices, result.num_hulls, result.error) <
+            std::tie(current.num_vertices, current.num_hulls, current.error))
+        {
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+/// Write table of sweep results to the log, Pareto optimal results are marked.
+void CollisionSweep::logResults(const std::vector<CollisionSweepResult> &results)
+{
+    for (size_t i=0; i < results.size(); i++)
+    {
+        const CollisionSweepResult &result = results[i];
+        if (!result.valid)
+        {
+            logInfo("Variant {}: not completed", i);
+            continue;
+        }
+
+        logInfo(
+            "Variant {}: resolution {:.0f}, concavity {:.4f}, max hulls {} -> {} hulls, {} vertices, "
+            "error {:.3f}%, {:.2f}s{}",
+            i,
+            result.settings.resolution,
+            result.settings.concavity,
+            result.settings.max_hulls,
+            result.num_hulls,
+            result.num_vertices,
+            result.error * 100.0,
+            result.duration,
+            result.pareto ? " [pareto]" : ""
+        );
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef COLLISION_SWEEP_H
+#define COLLISION_SWEEP_H
+
+#include "collisioncache.h"
+#include "collisiongen.h"
+#include "mesh.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+/// Budget collision has to meet to be selected by auto-tuning.
+struct CollisionSweepTarget
+{
+    /// Maximum number of hulls of each mesh.
+    int     max_hulls;
+    int     max_hull_vertices;
+
+    /// Maximum Hausdorff distance relative to the bounding sphere diameter of each mesh.
+    double  max_error;
+};
+
+
+/// Collision generated with single settings variant and its measured cost and error.
+struct CollisionSweepResult
+{
+    CollisionGenSettings settings;
+    std::vector<std::vector<std::unique_ptr<Mesh>>> hulls;
+
+    size_t  num_hulls = 0;
+    size_t  max_mesh_hulls = 0;
+    size_t  num_vertices = 0;
+    size_t  max_hull_vertices = 0;
+    double  error = 0.0;
+    double  duration = 0.0;
+    bool    valid = false;
+    bool    pareto = false;
+};
+
+
+class CollisionSweep
+{
+public:
+    CollisionSweep();
+
+    void addInputMesh(const Mesh *mesh);
+    void setCache(std::shared_ptr<CollisionCache> cache);
+    void setProgressCallback(const CollisionProgressCallback &callback);
+    void cancel();
+    bool isCancelled() const;
+
+    void run(
+        const std::vector<CollisionGenSettings> &variants,
+        std::vector<CollisionSweepResult> &out_results
+    );
+
+    static std::vector<CollisionGenSettings> generateVariants(
+        const CollisionGenSettings &base_settings,
+        const CollisionSweepTarget &target
+    );
+    static void markParetoSet(std::vector<CollisionSweepResult> &results);
+    static int selectCheapest(
+        const std::vector<CollisionSweepResult> &results,
+        const CollisionSweepTarget &target
+    );
+    static void logResults(const std::vector<CollisionSweepResult> &results);
+
+private:
+    std::vector<const Mesh*> input_meshes;
+    std::shared_ptr<CollisionCache> cache;
+    CollisionProgressCallback progress_callback;
+
+    std::atomic<bool> cancelled;
+    std::mutex generators_mutex;
+    std::vector<CollisionGen*> active_generators;
+};
+
+#endif
@@ -0,0 +1,416 @@
+#include "collisionvoxelizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <vector>
+
+#include <tbb/parallel_for.h>
+
+/// Relative enlargement of voxels in overlap tests, keeps triangles lying on voxel faces solid.
+static const double VOXEL_OVERLAP_EPSILON = 1e-6;
+
+
+using VoxelVector = std::array<double, 3>;
+
+static VoxelVector toVoxelVector(const QVector3D &v)
+{
+    return {v.x(), v.y(), v.z()};
+}
+
+static VoxelVector subtract(const VoxelVector &a, const VoxelVector &b)
+{
+    return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+}
+
+static VoxelVector cross(const VoxelVector &a, const VoxelVector &b)
+{
+    return {a[1]*b[2] - a[2]*b[1], a[2]*b[0] - a[0]*b[2], a[0]*b[1] - a[1]*b[0]};
+}
+
+static double dot(const VoxelVector &a, const VoxelVector &b)
+{
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+
+/// Initialize empty grid of cubic voxels covering given vertices.
+/// Grid keeps empty voxel layer around the vertices so the outside stays connected.
+/// @param: vertices Vertices the grid has to cover.
+/// @param: resolution Number of voxels along the longest side of the vertices bounds.
+/// @param: out_grid Grid to initialize.
+void CollisionVoxelizer::initGrid(std::span<const QVector3D> vertices, int resolution, VoxelGrid &out_grid)
+{
+    QVector3D min_bound = vertices.empty() ? QVector3D() : vertices.front();
+    QVector3D max_bound = min_bound;
+    for (const QVector3D &vertex : vertices)
+    {
+        for (int axis=0; axis < 3; axis++)
+        {
+            min_bound[axis] = std::min(min_bound[axis], vertex[axis]);
+            max_bound[axis] = std::max(max_bound[axis], vertex[axis]);
+        }
+    }
+
+    const QVector3D extent = max_bound - min_bound;
+    const float longest = std::max({extent.x(), extent.y(), extent.z()});
+
+    /// Bounds are centered in the grid with at least one and a half voxels to spare on each side,
+    /// so faces lying on voxel boundaries never reach the border layer.
+    out_grid.voxel_size = longest > 0.0f ? longest / std::max(resolution, 1) : 1.0f;
+    for (int axis=0; axis < 3; axis++)
+    {
+        out_grid.size[axis] = int(std::ceil(extent[axis] / out_grid.voxel_size)) + 3;
+        out_grid.origin[axis] = min_bound[axis] - (out_grid.size[axis] * out_grid.voxel_size - extent[axis]) * 0.5f;
+    }
+
+    out_grid.voxels.assign(size_t(out_grid.size[0]) * out_grid.size[1] * out_grid.size[2], 0);
+}
+
+/// Mark voxels overlapped by any triangle as solid.
+/// Overlap uses the separating axis test of triangle and box. Along a row of voxels the box center
+/// moves only in X, so each axis limits the overlapping voxels to a contiguous range and the whole
+/// row is resolved by intersecting at most 13 ranges instead of testing every voxel.
+/// Slices along Z are processed in parallel, each slice only writes its own voxels.
+/// @param: vertices Mesh vertices in grid space.
+/// @param: indices Mesh triangle indices.
+/// @param: grid Grid to mark solid voxels in, see CollisionVoxelizer::initGrid.
+void CollisionVoxelizer::voxelizeSurface(
+    std::span<const QVector3D> vertices,
+    std::span<const int> indices,
+    VoxelGrid &grid
+)
+{
+    const double voxel_size = grid.voxel_size;
+    const double half_size = voxel_size * 0.5 * (1.0 + VOXEL_OVERLAP_EPSILON);
+    const VoxelVector origin = toVoxelVector(grid.origin);
+
+    auto to_cell = [&](double value, int axis)
+    {
+        const int cell = int(std::floor((value - origin[axis]) / voxel_size));
+        return std::clamp(cell, 0, grid.size[axis] - 1);
+    };
+
+    /// Bucket triangles by slices they span so slices can be filled independently.
+    const size_t num_triangles = indices.size() / 3;
+    std::vector<std::vector<size_t>> slice_triangles(grid.size[2]);
+    for (size_t tri=0; tri < num_triangles; tri++)
+    {
+        float min_z = std::numeric_limits<float>::max();
+        float max_z = std::numeric_limits<float>::lowest();
+        for (int i=0; i < 3; i++)
+        {
+            min_z = std::min(min_z, vertices[indices[tri*3 + i]].z());
+            max_z = std::max(max_z, vertices[indices[tri*3 + i]].z());
+        }
+
+        for (int z=to_cell(min_z - half_size, 2); z <= to_cell(max_z + half_size, 2); z++)
+        {
+            slice_triangles[z].push_back(tri);
+        }
+    }
+
+    tbb::parallel_for(0, grid.size[2], [&](int z)
+    {
+        const double center_z = origin[2] + (z + 0.5) * voxel_size;
+        for (const size_t &tri : slice_triangles[z])
+        {
+            const std::array<VoxelVector, 3> v = {
+                toVoxelVector(vertices[indices[tri*3 + 0]]),
+                toVoxelVector(vertices[indices[tri*3 + 1]]),
+                toVoxelVector(vertices[indices[tri*3 + 2]])
+            };
+            const std::array<VoxelVector, 3> edges = {
+                subtract(v[1], v[0]),
+                subtract(v[2], v[1]),
+                subtract(v[0], v[2])
+            };
+
+            /// Candidate separating axes: grid axes, triangle normal and cross products of both.
+            std::array<VoxelVector, 13> axes;
+            axes[0] = {1.0, 0.0, 0.0};
+            axes[1] = {0.0, 1.0, 0.0};
+            axes[2] = {0.0, 0.0, 1.0};
+            axes[3] = cross(edges[0], edges[1]);
+            for (int i=0; i < 3; i++)
+            {
+                for (int j=0; j < 3; j++)
+                {
+                    axes[4 + i*3 + j] = cross(axes[i], edges[j]);
+                }
+            }
+
+            /// Range of box center projections overlapping the triangle projection on each axis.
+            std::array<double, 13> range_min;
+            std::array<double, 13> range_max;
+            double min_y = std::numeric_limits<double>::max();
+            double max_y = std::numeric_limits<double>::lowest();
+            for (size_t i=0; i < axes.size(); i++)
+            {
+                const VoxelVector &axis = axes[i];
+                const double p0 = dot(axis, v[0]);
+                const double p1 = dot(axis, v[1]);
+                const double p2 = dot(axis, v[2]);
+                const double radius = half_size * (std::abs(axis[0]) + std::abs(axis[1]) + std::abs(axis[2]));
+                range_min[i] = std::min({p0, p1, p2}) - radius;
+                range_max[i] = std::max({p0, p1, p2}) + radius;
+            }
+
+            for (const VoxelVector &vertex : v)
+            {
+                min_y = std::min(min_y, vertex[1]);
+                max_y = std::max(max_y, vertex[1]);
+            }
+
+            for (int y=to_cell(min_y - half_size, 1); y <= to_cell(max_y + half_size, 1); y++)
+            {
+                const double center_y = origin[1] + (y + 0.5) * voxel_size;
+
+                /// Intersect ranges of voxel center X allowed by each axis.
+                double x_min = std::numeric_limits<double>::lowest();
+                double x_max = std::numeric_limits<double>::max();
+                for (size_t i=0; i < axes.size() && x_min <= x_max; i++)
+                {
+                    const VoxelVector &axis = axes[i];
+                    const double offset = axis[1] * center_y + axis[2] * center_z;
+                    const double lower = range_min[i] - offset;
+                    const double upper = range_max[i] - offset;
+                    if (axis[0] > 0.0)
+                    {
+                        x_min = std::max(x_min, lower / axis[0]);
+                        x_max = std::min(x_max, upper / axis[0]);
+                    }
+                    else if (axis[0] < 0.0)
+                    {
+                        x_min = std::max(x_min, upper / axis[0]);
+                        x_max = std::min(x_max, lower / axis[0]);
+                    }
+                    else if (lower > 0.0 || upper < 0.0)
+                    {
+                        x_max = x_min - 1.0;
+                    }
+                }
+
+                if (x_min > x_max)
+                {
+                    continue;
+                }
+
+                const double first = std::ceil((x_min - origin[0]) / voxel_size - 0.5);
+                const double last = std::floor((x_max - origin[0]) / voxel_size - 0.5);
+                const int x_begin = int(std::max(first, 0.0));
+                const int x_end = int(std::min(last, double(grid.size[0] - 1)));
+                for (int x=x_begin; x <= x_end; x++)
+                {
+                    grid.voxels[grid.index(x, y, z)] = 1;
+                }
+            }
+        }
+    });
+}
+
+/// Mark voxels enclosed by solid voxels as solid.
+/// Outside is flood filled from the grid border, everything it does not reach is inside.
+/// Returns number of voxels filled.
+size_t CollisionVoxelizer::fillInterior(VoxelGrid &grid)
+{
+    const uint8_t OUTSIDE = 2;
+    const std::array<int, 3> &size = grid.size;
+
+    std::deque<std::array<int, 3>> queue;
+    auto visit = [&](int x, int y, int z)
+    {
+        if (x < 0 || y < 0 || z < 0 || x >= size[0] || y >= size[1] || z >= size[2])
+        {
+            return;
+        }
+
+        uint8_t &voxel = grid.voxels[grid.index(x, y, z)];
+        if (voxel == 0)
+        {
+            voxel = OUTSIDE;
+            queue.push_back({x, y, z});
+        }
+    };
+
+    for (int z=0; z < size[2]; z++)
+    {
+        for (int y=0; y < size[1]; y++)
+        {
+            for (int x=0; x < size[0]; x++)
+            {
+                if (x == 0 || y == 0 || z == 0 || x == size[0]-1 || y == size[1]-1 || z == size[2]-1)
+                {
+                    visit(x, y, z);
+                }
+            }
+        }
+    }
+
+    while (!queue.empty())
+    {
+        const std::array<int, 3> voxel = queue.front();
+        queue.pop_front();
+
+        visit(voxel[0] - 1, voxel[1], voxel[2]);
+        visit(voxel[0] + 1, voxel[1], voxel[2]);
+        visit(voxel[0], voxel[1] - 1, voxel[2]);
+        visit(voxel[0], voxel[1] + 1, voxel[2]);
+        visit(voxel[0], voxel[1], voxel[2] - 1);
+        visit(voxel[0], voxel[1], voxel[2] + 1);
+    }
+
+    size_t num_filled = 0;
+    for (uint8_t &voxel : grid.voxels)
+    {
+        if (voxel == 0)
+        {
+            num_filled++;
+        }
+
+        voxel = voxel == OUTSIDE ? 0 : 1;
+    }
+
+    return num_filled;
+}
+
+/// Cover solid voxels with boxes, greedily growing each box along X, then Y and then Z.
+/// Boxes never overlap and cover exactly the solid voxels.
+/// @param: grid Grid of solid voxels.
+/// @param: out_boxes List to receive boxes.
+void CollisionVoxelizer::mergeBoxes(const VoxelGrid &grid, std::vector<VoxelBox> &out_boxes)
+{
+    const std::array<int, 3> &size = grid.size;
+    std::vector<uint8_t> covered(grid.voxels.size(), 0);
+
+    auto is_free = [&](int x, int y, int z)
+    {
+        const size_t idx = grid.index(x, y, z);
+        return grid.voxels[idx] && !covered[idx];
+    };
+
+    auto is_free_rect = [&](int x0, int x1, int y0, int y1, int z)
+    {
+        for (int y=y0; y <= y1; y++)
+        {
+            for (int x=x0; x <= x1; x++)
+            {
+                if (!is_free(x, y, z))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    };
+
+    out_boxes.clear();
+    for (int z=0; z < size[2]; z++)
+    {
+        for (int y=0; y < size[1]; y++)
+        {
+            for (int x=0; x < size[0]; x++)
+            {
+                if (!is_free(x, y, z))
+                {
+                    continue;
+                }
+
+                VoxelBox box = {{x, y, z}, {x, y, z}};
+                while (box.max[0] + 1 < size[0] && is_free(box.max[0] + 1, y, z))
+                {
+                    box.max[0]++;
+                }
+
+                while (box.max[1] + 1 < size[1] && is_free_rect(x, box.max[0], box.max[1] + 1, box.max[1] + 1, z))
+                {
+                    box.max[1]++;
+                }
+
+                while (box.max[2] + 1 < size[2] && is_free_rect(x, box.max[0], y, box.max[1], box.max[2] + 1))
+                {
+                    box.max[2]++;
+                }
+
+                for (int bz=box.min[2]; bz <= box.max[2]; bz++)
+                {
+                    for (int by=box.min[1]; by <= box.max[1]; by++)
+                    {
+                        for (int bx=box.min[0]; bx <= box.max[0]; bx++)
+                        {
+                            covered[grid.index(bx, by, bz)] = 1;
+                        }
+                    }
+                }
+
+                out_boxes.push_back(box);
+            }
+        }
+    }
+}
+
+/// Merge boxes until there are at most given number of them.
+/// Each step replaces the pair of boxes whose bounding box adds the least empty volume by that bounding box,
+/// so the result still covers all solid voxels.
+/// @param: boxes List of boxes to merge in place.
+/// @param: max_boxes Maximum number of boxes to keep, at least one.
+/// Returns number of empty voxels added by the merged boxes.
+size_t CollisionVoxelizer::limitBoxes(std::vector<VoxelBox> &boxes, size_t max_boxes)
+{
+    auto box_volume = [](const VoxelBox &box)
+    {
+        size_t volume = 1;
+        for (int axis=0; axis < 3; axis++)
+        {
+            volume *= size_t(box.max[axis] - box.min[axis] + 1);
+        }
+
+        return volume;
+    };
+
+    auto merge = [](const VoxelBox &a, const VoxelBox &b)
+    {
+        VoxelBox merged;
+        for (int axis=0; axis < 3; axis++)
+        {
+            merged.min[axis] = std::min(a.min[axis], b.min[axis]);
+            merged.max[axis] = std::max(a.max[axis], b.max[axis]);
+        }
+
+        return merged;
+    };
+
+    size_t added_volume = 0;
+    max_boxes = std::max<size_t>(max_boxes, 1);
+    while (boxes.size() > max_boxes)
+    {
+        size_t best_i = 0;
+        size_t best_j = 1;
+        size_t best_cost = std::numeric_limits<size_t>::max();
+        for (size_t i=0; i < boxes.size(); i++)
+        {
+            for (size_t j=i + 1; j < boxes.size(); j++)
+            {
+                /// Merged boxes may overlap others, so the added volume is only an upper bound.
+                const size_t merged_volume = box_volume(merge(boxes[i], boxes[j]));
+                const size_t volume = box_volume(boxes[i]) + box_volume(boxes[j]);
+                const size_t cost = merged_volume > volume ? merged_volume - volume : 0;
+                if (cost < best_cost)
+                {
+                    best_i = i;
+                    best_j = j;
+                    best_cost = cost;
+                }
+            }
+        }
+
+        boxes[best_i] = merge(boxes[best_i], boxes[best_j]);
+        boxes.erase(boxes.begin() + best_j);
+        added_volume += best_cost;
+    }
+
+    return added_volume;
+}
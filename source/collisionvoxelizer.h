@@ -0,0 +1,55 @@
+#ifndef COLLISION_VOXELIZER_H
+#define COLLISION_VOXELIZER_H
+
+#include "mesh.h"
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <QVector3D>
+
+
+/// Dense grid of cubic voxels, voxel is non-zero when solid.
+struct VoxelGrid
+{
+    std::array<int, 3>   size = {0, 0, 0};
+    QVector3D            origin;
+    float                voxel_size = 0.0f;
+    std::vector<uint8_t> voxels;
+
+    size_t index(int x, int y, int z) const
+    {
+        return (size_t(z) * this->size[1] + y) * this->size[0] + x;
+    }
+};
+
+
+/// Box spanning inclusive range of voxels.
+struct VoxelBox
+{
+    std::array<int, 3> min;
+    std::array<int, 3> max;
+};
+
+
+/// Conversion of closed meshes into solid voxel grids and compounds of boxes.
+class CollisionVoxelizer
+{
+public:
+    static void initGrid(
+        std::span<const QVector3D> vertices,
+        int resolution,
+        VoxelGrid &out_grid
+    );
+    static void voxelizeSurface(
+        std::span<const QVector3D> vertices,
+        std::span<const int> indices,
+        VoxelGrid &grid
+    );
+    static size_t fillInterior(VoxelGrid &grid);
+    static void mergeBoxes(const VoxelGrid &grid, std::vector<VoxelBox> &out_boxes);
+    static size_t limitBoxes(std::vector<VoxelBox> &boxes, size_t max_boxes);
+};
+
+#endif
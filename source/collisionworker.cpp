@@ -0,0 +1,660 @@
+#include "collisionworker.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <new>
+#include <span>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+#define COLLISION_WORKER_SUPPORTED 1
+#else
+#define COLLISION_WORKER_SUPPORTED 0
+#endif
+
+/// Command line argument which starts this application as decomposition worker.
+static const char *WORKER_ARGUMENT = "--decompose-worker";
+
+/// Identifies shared memory segments written by this version of the worker protocol.
+static const uint32_t WORKER_MAGIC = 0x43435731;
+
+/// Interval between checks of running worker for completion, cancellation and progress.
+static const auto WORKER_POLL_INTERVAL = std::chrono::milliseconds(10);
+
+/// Suffix appended to request segment name to name the result segment.
+static const char *WORKER_RESULT_SUFFIX = "r";
+
+/// Executable started as worker process, empty disables worker processes.
+static std::string worker_executable;
+
+
+/// Decomposition the worker runs, see WorkerRequest.
+enum WorkerTask : uint32_t
+{
+    ApproximateTask = 0,
+    ExactTask = 1
+};
+
+/// Worker exit code of decomposition which did not produce any result.
+static const int WORKER_TASK_FAILED = 3;
+
+/// Layout of shared memory segment passed to the worker, followed by vertex positions and indices.
+struct WorkerRequest
+{
+    uint32_t                magic;
+    WorkerTask              task;
+    /// Maximum number of hulls, or pieces of exact decomposition.
+    int32_t                 max_hulls;
+    CollisionGenSettings    settings;
+    uint64_t                num_vertices;
+    uint64_t                num_indices;
+    /// Decomposition progress in thousandths, written by the worker.
+    std::atomic<uint32_t>   progress;
+};
+
+/// Layout of shared memory segment written by the worker, followed by size of each hull,
+/// vertex positions and indices of all hulls.
+struct WorkerResult
+{
+    uint32_t magic;
+    uint32_t num_hulls;
+    uint64_t num_vertices;
+    uint64_t num_indices;
+};
+
+struct WorkerHull
+{
+    uint32_t num_vertices;
+    uint32_t num_indices;
+};
+
+static_assert(std::is_trivially_copyable_v<CollisionGenSettings>, "Settings are copied into shared memory");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Progress is shared between processes");
+
+
+#if COLLISION_WORKER_SUPPORTED
+/// POSIX shared memory segment mapped into this process.
+class SharedSegment
+{
+public:
+    SharedSegment() = default;
+    SharedSegment(const SharedSegment&) = delete;
+    SharedSegment& operator=(const SharedSegment&) = delete;
+
+    ~SharedSegment()
+    {
+        if (this->data)
+        {
+            munmap(this->data, this->size);
+        }
+
+        if (this->unlink_on_close)
+        {
+            shm_unlink(this->name.c_str());
+        }
+    }
+
+    /// Create new zero filled segment of given size, segment of the same name must not exist.
+    /// @param: unlink Remove the segment name once this mapping is closed.
+    bool create(const std::string &name, size_t size, bool unlink)
+    {
+        const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        this->name = name;
+        this->unlink_on_close = unlink;
+        if (ftruncate(fd, size) != 0)
+        {
+            close(fd);
+            shm_unlink(name.c_str());
+            this->unlink_on_close = false;
+            return false;
+        }
+
+        return this->map(fd, size);
+    }
+
+    /// Map existing segment as a whole.
+    /// @param: unlink Remove the segment name once this mapping is closed.
+    bool open(const std::string &name, bool unlink)
+    {
+        const int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        this->name = name;
+        this->unlink_on_close = unlink;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0)
+        {
+            close(fd);
+            return false;
+        }
+
+        return this->map(fd, size_t(info.st_size));
+    }
+
+    unsigned char* bytes() const
+    {
+        return static_cast<unsigned char*>(this->data);
+    }
+
+    size_t getSize() const
+    {
+        return this->size;
+    }
+
+private:
+    bool map(int fd, size_t size)
+    {
+        void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED)
+        {
+            return false;
+        }
+
+        this->data = data;
+        this->size = size;
+        return true;
+    }
+
+    std::string name;
+    void *data = nullptr;
+    size_t size = 0;
+    bool unlink_on_close = false;
+};
+
+
+/// Forwards worker decomposition progress into the shared request segment.
+class WorkerProgressCallback : public VHACD::IVHACD::IUserCallback
+{
+public:
+    WorkerRequest *request = nullptr;
+
+    void Update(
+        const double overall_progress,
+        const double stage_progress,
+        const double operation_progress,
+        const char *const stage,
+        const char *const operation
+    ) override
+    {
+        this->request->progress = uint32_t(std::clamp(overall_progress * 10.0, 0.0, 1000.0));
+    }
+};
+#endif
+
+
+/// Read hulls from result written by worker process. The whole layout and every index is
+/// validated before any hull is added, the worker is not trusted to be well behaved.
+/// @param: data Result data starting with WorkerResult header.
+/// @param: size Size of the result data in bytes.
+/// @param: out_meshes List to add hulls to, left untouched if the result is malformed.
+/// Returns true if the result was well formed.
+bool CollisionWorker::readWorkerResult(const unsigned char *data, size_t size, std::vector<std::unique_ptr<Mesh>> &out_meshes)
+{
+    const size_t hulls_offset = sizeof(WorkerResult);
+    if (size < hulls_offset)
+    {
+        return false;
+    }
+
+    WorkerResult result;
+    std::memcpy(&result, data, sizeof(WorkerResult));
+    if (result.magic != WORKER_MAGIC ||
+        result.num_vertices > size / (3 * sizeof(float)) ||
+        result.num_indices > size / sizeof(int))
+    {
+        return false;
+    }
+
+    const size_t positions_offset = hulls_offset + size_t(result.num_hulls) * sizeof(WorkerHull);
+    const size_t indices_offset = positions_offset + size_t(result.num_vertices) * 3 * sizeof(float);
+    const size_t end_offset = indices_offset + size_t(result.num_indices) * sizeof(int);
+    if (size < end_offset)
+    {
+        return false;
+    }
+
+    const WorkerHull *hulls = reinterpret_cast<const WorkerHull*>(data + hulls_offset);
+    const QVector3D *hull_vertices = reinterpret_cast<const QVector3D*>(data + positions_offset);
+    const int *hull_indices = reinterpret_cast<const int*>(data + indices_offset);
+
+    std::vector<std::unique_ptr<Mesh>> meshes;
+    size_t vertex_offset = 0;
+    size_t index_offset = 0;
+    for (uint32_t i=0; i < result.num_hulls; i++)
+    {
+        const WorkerHull &hull = hulls[i];
+        if (vertex_offset + hull.num_vertices > result.num_vertices ||
+            index_offset + hull.num_indices > result.num_indices ||
+            hull.num_indices % 3 != 0)
+        {
+            return false;
+        }
+
+        std::span<const int> indices(hull_indices + index_offset, hull.num_indices);
+        for (int index : indices)
+        {
+            if (index < 0 || uint32_t(index) >= hull.num_vertices)
+            {
+                return false;
+            }
+        }
+
+        meshes.push_back(std::make_unique<Mesh>(
+            std::span<const QVector3D>(hull_vertices + vertex_offset, hull.num_vertices),
+            indices
+        ));
+        meshes.back()->generateNormals();
+        meshes.back()->computeBounds();
+
+        vertex_offset += hull.num_vertices;
+        index_offset += hull.num_indices;
+    }
+
+    std::move(meshes.begin(), meshes.end(), std::back_inserter(out_meshes));
+    return true;
+}
+
+
+/// Serialize hulls into the layout read by CollisionWorker::readWorkerResult.
+/// @param: meshes Hulls to serialize.
+/// @param: out_data Receives WorkerResult header followed by size of each hull, vertex positions
+/// and indices of all hulls.
+void CollisionWorker::writeWorkerResult(const std::vector<std::unique_ptr<Mesh>> &meshes, std::vector<unsigned char> &out_data)
+{
+    WorkerResult result;
+    result.magic = WORKER_MAGIC;
+    result.num_hulls = uint32_t(meshes.size());
+    result.num_vertices = 0;
+    result.num_indices = 0;
+
+    std::vector<WorkerHull> hulls;
+    for (const std::unique_ptr<Mesh> &mesh : meshes)
+    {
+        hulls.push_back({uint32_t(mesh->numVertices()), uint32_t(mesh->numIndices())});
+        result.num_vertices += mesh->numVertices();
+        result.num_indices += mesh->numIndices();
+    }
+
+    auto append = [&out_data](const void *data, size_t size)
+    {
+        const unsigned char *bytes = static_cast<const unsigned char*>(data);
+        out_data.insert(out_data.end(), bytes, bytes + size);
+    };
+
+    out_data.clear();
+    append(&result, sizeof(WorkerResult));
+    append(hulls.data(), hulls.size() * sizeof(WorkerHull));
+    for (const std::unique_ptr<Mesh> &mesh : meshes)
+    {
+        append(mesh->getVertices().data(), mesh->getVertices().size_bytes());
+    }
+
+    for (const std::unique_ptr<Mesh> &mesh : meshes)
+    {
+        append(mesh->getIndices().data(), mesh->getIndices().size_bytes());
+    }
+}
+
+
+/// Run decomposition of given mesh in a new worker process and read the hulls it delivers.
+/// Worker is killed as soon as the stop callback requests it.
+/// @param: task Decomposition the worker runs.
+/// @param: max_hulls Maximum number of hulls or exact decomposition pieces.
+/// @param: should_stop Callback polled with resident memory of the worker in bytes while it runs,
+/// returns true to stop the worker.
+/// @param: on_progress Callback receiving worker decomposition progress, may be empty.
+/// @param: out_meshes List to add hulls to.
+/// Returns whether the worker succeeded, was stopped or failed.
+static CollisionWorkerStatus runWorkerRequest(
+    const Mesh &mesh,
+    const CollisionGenSettings &settings,
+    WorkerTask task,
+    int max_hulls,
+    const std::function<bool(size_t worker_memory)> &should_stop,
+    const std::function<void(double progress)> &on_progress,
+    std::vector<std::unique_ptr<Mesh>> &out_meshes
+)
+{
+#if COLLISION_WORKER_SUPPORTED
+    static std::atomic<uint64_t> segment_counter(0);
+    const uint64_t segment_id = segment_counter++;
+    const int process_id = getpid();
+
+    /// Short names as some platforms limit shared memory names to 31 characters.
+    const std::string request_name = std::vformat("/ccw{}_{}", std::make_format_args(process_id, segment_id));
+    const std::string result_name = request_name + WORKER_RESULT_SUFFIX;
+
+    std::span<const float> positions = mesh.getPositionData();
+    std::span<const uint32_t> indices = mesh.getIndexData();
+    SharedSegment request_segment;
+    if (!request_segment.create(request_name, sizeof(WorkerRequest) + positions.size_bytes() + indices.size_bytes(), true))
+    {
+        logError("Failed to create shared memory segment for decomposition worker -> {}", std::strerror(errno));
+        return CollisionWorkerStatus::WorkerFailed;
+    }
+
+    WorkerRequest *request = new (request_segment.bytes()) WorkerRequest();
+    request->magic = WORKER_MAGIC;
+    request->task = task;
+    request->max_hulls = max_hulls;
+    request->settings = settings;
+    request->num_vertices = mesh.numVertices();
+    request->num_indices = indices.size();
+    request->progress = 0;
+
+    unsigned char *request_data = request_segment.bytes() + sizeof(WorkerRequest);
+    std::memcpy(request_data, positions.data(), positions.size_bytes());
+    std::memcpy(request_data + positions.size_bytes(), indices.data(), indices.size_bytes());
+
+    std::string argument = WORKER_ARGUMENT;
+    std::string segment_argument = request_name;
+    std::vector<char*> arguments = {
+        worker_executable.data(),
+        argument.data(),
+        segment_argument.data(),
+        nullptr
+    };
+
+    pid_t worker_pid = 0;
+    const int spawn_error = posix_spawn(&worker_pid, worker_executable.c_str(), nullptr, nullptr, arguments.data(), environ);
+    if (spawn_error != 0)
+    {
+        logError("Failed to start decomposition worker process -> {}", std::strerror(spawn_error));
+        return CollisionWorkerStatus::WorkerFailed;
+    }
+
+    int status = 0;
+    bool stopped = false;
+    while (true)
+    {
+        const pid_t result_pid = waitpid(worker_pid, &status, WNOHANG);
+        if (result_pid == worker_pid)
+        {
+            break;
+        }
+
+        if (result_pid < 0 && errno != EINTR)
+        {
+            logError("Lost track of decomposition worker process {} -> {}", int(worker_pid), std::strerror(errno));
+            kill(worker_pid, SIGKILL);
+            while (waitpid(worker_pid, &status, 0) < 0 && errno == EINTR)
+            {
+            }
+
+            shm_unlink(result_name.c_str());
+            return CollisionWorkerStatus::WorkerFailed;
+        }
+
+        /// Memory of the worker is measured here, the budget only sees memory of this process.
+        if (!stopped && should_stop && should_stop(CollisionBudget::getResidentMemory(worker_pid)))
+        {
+            kill(worker_pid, SIGKILL);
+            stopped = true;
+        }
+
+        if (on_progress)
+        {
+            on_progress(request->progress * 0.001);
+        }
+
+        std::this_thread::sleep_for(WORKER_POLL_INTERVAL);
+    }
+
+    if (stopped)
+    {
+        shm_unlink(result_name.c_str());
+        return CollisionWorkerStatus::WorkerStopped;
+    }
+
+    if (WIFSIGNALED(status))
+    {
+        logError("Decomposition worker process {} crashed with signal {}", int(worker_pid), WTERMSIG(status));
+        shm_unlink(result_name.c_str());
+        return CollisionWorkerStatus::WorkerFailed;
+    }
+
+    if (WIFEXITED(status) && WEXITSTATUS(status) == WORKER_TASK_FAILED)
+    {
+        logDebug("Decomposition worker process {} found no decomposition within its limits", int(worker_pid));
+        shm_unlink(result_name.c_str());
+        return CollisionWorkerStatus::WorkerFailed;
+    }
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        logError("Decomposition worker process {} failed with exit code {}", int(worker_pid), WEXITSTATUS(status));
+        shm_unlink(result_name.c_str());
+        return CollisionWorkerStatus::WorkerFailed;
+    }
+
+    SharedSegment result_segment;
+    if (!result_segment.open(result_name, true))
+    {
+        logError("Decomposition worker process {} did not deliver its results", int(worker_pid));
+        shm_unlink(result_name.c_str());
+        return CollisionWorkerStatus::WorkerFailed;
+    }
+
+    const size_t num_meshes = out_meshes.size();
+    if (!CollisionWorker::readWorkerResult(result_segment.bytes(), result_segment.getSize(), out_meshes))
+    {
+        logError("Decomposition worker process {} delivered malformed results", int(worker_pid));
+        return CollisionWorkerStatus::WorkerFailed;
+    }
+
+    logDebug("Decomposition worker process {} generated {} hulls", int(worker_pid), out_meshes.size() - num_meshes);
+    return CollisionWorkerStatus::WorkerSucceeded;
+#else
+    return CollisionWorkerStatus::WorkerFailed;
+#endif
+}
+
+
+/// Get value indicating if worker processes can be used on this platform and were configured.
+bool CollisionWorker::isSupported()
+{
+    return COLLISION_WORKER_SUPPORTED && !worker_executable.empty();
+}
+
+/// Set executable started as worker process, expected to be this application.
+/// Must be called before any collision generation starts.
+void CollisionWorker::setExecutable(const std::string &filepath)
+{
+    worker_executable = filepath;
+}
+
+/// Get value indicating if given command line starts this application as decomposition worker.
+bool CollisionWorker::isWorkerCommand(int argc, char *argv[])
+{
+    return argc == 3 && std::strcmp(argv[1], WORKER_ARGUMENT) == 0;
+}
+
+/// Run approximate convex decomposition of given mesh in a new worker process.
+/// Worker is killed as soon as the stop callback requests it.
+/// @param: mesh Cleaned up mesh to decompose.
+/// @param: max_hulls Maximum number of hulls to generate.
+/// @param: should_stop Callback polled with resident memory of the worker in bytes while it runs,
+/// returns true to stop the worker.
+/// @param: on_progress Callback receiving worker decomposition progress.
+/// @param: out_meshes List to add newly generated collision hulls to.
+/// Returns whether the worker succeeded, was stopped or failed.
+CollisionWorkerStatus CollisionWorker::decompose(
+    const Mesh &mesh,
+    const CollisionGenSettings &settings,
+    int max_hulls,
+    const std::function<bool(size_t worker_memory)> &should_stop,
+    const std::function<void(double progress)> &on_progress,
+    std::vector<std::unique_ptr<Mesh>> &out_meshes
+)
+{
+    return runWorkerRequest(mesh, settings, WorkerTask::ApproximateTask, max_hulls, should_stop, on_progress, out_meshes);
+}
+
+/// Run exact convex decomposition of given closed mesh in a new worker process.
+/// Exact decomposition cannot be interrupted, so it is stopped by killing the worker as soon as
+/// the stop callback requests it.
+/// @param: mesh Closed mesh of single connected volume to decompose.
+/// @param: max_pieces Maximum number of pieces, the worker fails on more fragmented results.
+/// @param: should_stop Callback polled with resident memory of the worker in bytes while it runs,
+/// returns true to stop the worker.
+/// @param: out_meshes List to add convex pieces to.
+/// Returns whether the worker succeeded, was stopped or failed.
+CollisionWorkerStatus CollisionWorker::decomposeExact(
+    const Mesh &mesh,
+    int max_pieces,
+    const std::function<bool(size_t worker_memory)> &should_stop,
+    std::vector<std::unique_ptr<Mesh>> &out_meshes
+)
+{
+    return runWorkerRequest(mesh, CollisionGenSettings(), WorkerTask::ExactTask, max_pieces, should_stop, nullptr, out_meshes);
+}
+
+/// Entry point of worker process, decomposes mesh in given request segment and writes
+/// resulting hulls into new result segment named after it.
+/// @param: segment_name Name of the shared memory segment holding the request.
+/// Returns process exit code, zero on success.
+int CollisionWorker::runWorker(const std::string &segment_name)
+{
+#if COLLISION_WORKER_SUPPORTED
+    SharedSegment request_segment;
+    if (!request_segment.open(segment_name, false) || request_segment.getSize() < sizeof(WorkerRequest))
+    {
+        return 2;
+    }
+
+    WorkerRequest *request = reinterpret_cast<WorkerRequest*>(request_segment.bytes());
+    const size_t positions_size = size_t(request->num_vertices) * 3 * sizeof(float);
+    const size_t indices_size = size_t(request->num_indices) * sizeof(uint32_t);
+    if (request->magic != WORKER_MAGIC ||
+        request_segment.getSize() < sizeof(WorkerRequest) + positions_size + indices_size)
+    {
+        return 2;
+    }
+
+    const unsigned char *request_data = request_segment.bytes() + sizeof(WorkerRequest);
+    const float *positions = reinterpret_cast<const float*>(request_data);
+    const uint32_t *indices = reinterpret_cast<const uint32_t*>(request_data + positions_size);
+
+    /// Exact decomposition has no progress to report and is bounded by killing the worker.
+    if (request->task == WorkerTask::ExactTask)
+    {
+        const Mesh mesh(
+            std::span<const QVector3D>(reinterpret_cast<const QVector3D*>(positions), request->num_vertices),
+            std::span<const int>(reinterpret_cast<const int*>(indices), request->num_indices)
+        );
+
+        std::vector<std::unique_ptr<Mesh>> pieces;
+        if (!CollisionGen::decomposeMeshExact(mesh, std::chrono::steady_clock::time_point::max(), request->max_hulls, pieces))
+        {
+            return WORKER_TASK_FAILED;
+        }
+
+        std::vector<unsigned char> result;
+        CollisionWorker::writeWorkerResult(pieces, result);
+
+        SharedSegment result_segment;
+        if (!result_segment.create(segment_name + WORKER_RESULT_SUFFIX, result.size(), false))
+        {
+            return 4;
+        }
+
+        std::memcpy(result_segment.bytes(), result.data(), result.size());
+        return 0;
+    }
+
+    WorkerProgressCallback callback;
+    callback.request = request;
+
+    VHACD::IVHACD::Parameters params;
+    CollisionGen::getVHACDParameters(request->settings, request->max_hulls, params);
+    params.m_callback = &callback;
+
+    VHACD::IVHACD *vhacd = VHACD::CreateVHACD();
+    if (!vhacd->Compute(positions, request->num_vertices, indices, request->num_indices / 3, params))
+    {
+        vhacd->Release();
+        return WORKER_TASK_FAILED;
+    }
+
+    const uint32_t num_hulls = vhacd->GetNConvexHulls();
+    std::vector<WorkerHull> hulls(num_hulls);
+    uint64_t num_vertices = 0;
+    uint64_t num_indices = 0;
+
+    VHACD::IVHACD::ConvexHull hull;
+    for (uint32_t i=0; i < num_hulls; i++)
+    {
+        vhacd->GetConvexHull(i, hull);
+        hulls[i].num_vertices = hull.m_nPoints;
+        hulls[i].num_indices = hull.m_nTriangles * 3;
+        num_vertices += hulls[i].num_vertices;
+        num_indices += hulls[i].num_indices;
+    }
+
+    const size_t positions_offset = sizeof(WorkerResult) + num_hulls * sizeof(WorkerHull);
+    const size_t indices_offset = positions_offset + num_vertices * 3 * sizeof(float);
+    SharedSegment result_segment;
+    if (!result_segment.create(segment_name + WORKER_RESULT_SUFFIX, indices_offset + num_indices * sizeof(int), false))
+    {
+        vhacd->Release();
+        return 4;
+    }
+
+    WorkerResult *result = reinterpret_cast<WorkerResult*>(result_segment.bytes());
+    result->magic = WORKER_MAGIC;
+    result->num_hulls = num_hulls;
+    result->num_vertices = num_vertices;
+    result->num_indices = num_indices;
+    std::memcpy(result_segment.bytes() + sizeof(WorkerResult), hulls.data(), hulls.size() * sizeof(WorkerHull));
+
+    float *out_positions = reinterpret_cast<float*>(result_segment.bytes() + positions_offset);
+    int *out_indices = reinterpret_cast<int*>(result_segment.bytes() + indices_offset);
+    for (uint32_t i=0; i < num_hulls; i++)
+    {
+        vhacd->GetConvexHull(i, hull);
+        for (uint32_t j=0; j < hull.m_nPoints * 3; j++)
+        {
+            *out_positions++ = float(hull.m_points[j]);
+        }
+
+        for (uint32_t j=0; j < hull.m_nTriangles * 3; j++)
+        {
+            *out_indices++ = int(hull.m_triangles[j]);
+        }
+    }
+
+    vhacd->Release();
+    return 0;
+#else
+    return 1;
+#endif
+}
@@ -0,0 +1,54 @@
+#ifndef COLLISION_WORKER_H
+#define COLLISION_WORKER_H
+
+#include "collisiongen.h"
+#include "mesh.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+enum CollisionWorkerStatus
+{
+    WorkerSucceeded = 0,
+    WorkerStopped = 1,
+    WorkerFailed = 2
+};
+
+
+/// Convex decomposition running in a helper process of this application.
+/// Mesh buffers and resulting hulls are passed through POSIX shared memory, so a crash of the
+/// decomposition library only takes the helper process down and decompositions which cannot
+/// be interrupted are stopped by killing the helper.
+class CollisionWorker
+{
+public:
+    static bool isSupported();
+    static void setExecutable(const std::string &filepath);
+
+    static CollisionWorkerStatus decompose(
+        const Mesh &mesh,
+        const CollisionGenSettings &settings,
+        int max_hulls,
+        const std::function<bool(size_t worker_memory)> &should_stop,
+        const std::function<void(double progress)> &on_progress,
+        std::vector<std::unique_ptr<Mesh>> &out_meshes
+    );
+
+    static CollisionWorkerStatus decomposeExact(
+        const Mesh &mesh,
+        int max_pieces,
+        const std::function<bool(size_t worker_memory)> &should_stop,
+        std::vector<std::unique_ptr<Mesh>> &out_meshes
+    );
+
+    static bool isWorkerCommand(int argc, char *argv[]);
+    static int runWorker(const std::string &segment_name);
+
+    static bool readWorkerResult(const unsigned char *data, size_t size, std::vector<std::unique_ptr<Mesh>> &out_meshes);
+    static void writeWorkerResult(const std::vector<std::unique_ptr<Mesh>> &meshes, std::vector<unsigned char> &out_data);
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef HASHING_H
+#define HASHING_H
+
+#include <cstddef>
+#include <cstdint>
+
+
+/// 64-bit FNV-1a hashing of raw bytes, used for content hashes and cache keys.
+class Hashing
+{
+public:
+    /// FNV-1a offset basis, seed of hashes not chained from another value.
+    static constexpr uint64_t OFFSET_BASIS = 0xcbf29ce484222325ull;
+
+    /// Computes 64-bit FNV-1a hash of given bytes.
+    /// @param: seed Hash value to continue from, allows chaining multiple values into single key.
+    static uint64_t hashBytes(uint64_t seed, const void *data, size_t size)
+    {
+        const uint64_t prime = 0x100000001b3ull;
+        uint64_t hash = seed;
+
+        const unsigned char *bytes = static_cast<const unsigned char*>(data);
+        for (size_t i=0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= prime;
+        }
+
+        return hash;
+    }
+
+    /// Shorthand for hashing trivially copyable values.
+    template <typename T>
+    static uint64_t hashValue(uint64_t seed, const T &value)
+    {
+        return Hashing::hashBytes(seed, &value, sizeof(T));
+    }
+};
+
+#endif
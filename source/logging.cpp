@@ -11,6 +11,11 @@ Logger::Logger(const std::string &filepath) :
     debug_enabled(false)
 {
     this->log_filepath = filepath;
+
+    /// Messages can be logged from worker threads, register signal argument types
+    /// so they can be delivered via queued connections.
+    qRegisterMetaType<std::string>("std::string");
+    qRegisterMetaType<LogLevel>("LogLevel");
 }
 
 /// Default destructor.
@@ -92,8 +97,11 @@ void Logger::logMessage(const std::string &msg, LogLevel level)
 
     message_stream << timestamp << " - " << level_desc << " - " << msg;
     std::string message = message_stream.str();
-    std::cout << message << std::endl;
-    *this->log_file << message << std::endl; 
+    {
+        std::lock_guard<std::mutex> lock(this->log_mutex);
+        std::cout << message << std::endl;
+        *this->log_file << message << std::endl; 
+    }
 
     Q_EMIT this->messageLogged(message, level);
 }
@@ -8,6 +8,7 @@
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
 
 enum LogLevel
 {
@@ -45,6 +46,7 @@ private:
     bool debug_enabled;
     std::string log_filepath;
     std::unique_ptr<std::ofstream> log_file;
+    std::mutex log_mutex;
     static std::weak_ptr<Logger> active_log;
 
     void logMessage(const std::string &msg, LogLevel level);
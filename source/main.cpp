@@ -12,6 +12,10 @@
 #include <pxr/base/tf/diagnosticMgr.h>
 
 #include "appwindow.h"
+#include "batchcluster.h"
+#include "batchrunner.h"
+#include "collisioncache.h"
+#include "collisionworker.h"
 #include "logging.h"
 
 /// Get suitable location for local app data storage.
@@ -65,6 +69,13 @@ bool applyStyleSheet(QApplication& app, const std::string &filepath)
 
 int main(int argc, char *argv[])
 {
+    /// Decomposition worker processes are started from this executable, they do not
+    /// initialise logging or any UI.
+    if (CollisionWorker::isWorkerCommand(argc, argv))
+    {
+        return CollisionWorker::runWorker(argv[2]);
+    }
+
     /// Enable USD debug output.
     //pxr::TfDiagnosticMgr::GetInstance().EnableNotification2();
     //pxr::TfDiagnosticMgr::GetInstance().SetQuiet(false);
@@ -82,6 +93,54 @@ int main(int argc, char *argv[])
 #ifdef DEBUG
     Logger::active()->setDebugEnabled(true);
 #endif
+
+    /// Initialise persistent collision cache shared by all generation jobs.
+    const uint64_t cache_size_limit = 1024ull * 1024ull * 1024ull;
+    std::string cache_location = local_app_data + "cache/";
+    std::shared_ptr<CollisionCache> cache = std::make_shared<CollisionCache>(cache_location, cache_size_limit);
+    cache->evict();
+    logDebug("Collision cache location -> {}", cache_location);
+
+    /// Headless batch processing of assets listed in manifest, runs without any window
+    /// or graphics context.
+    if (argc == 3 && std::string(argv[1]) == "--batch")
+    {
+        QCoreApplication app(argc, argv);
+        CollisionWorker::setExecutable(QCoreApplication::applicationFilePath().toStdString());
+
+        BatchRunner runner(cache);
+        if (!runner.loadManifest(argv[2]))
+        {
+            return 2;
+        }
+
+        return runner.run();
+    }
+
+    /// Distributed batch, coordinator hands manifest assets out to worker nodes connecting
+    /// over TCP, which may run on this or other machines.
+    if (argc == 3 && std::string(argv[1]) == "--coordinate")
+    {
+        QCoreApplication app(argc, argv);
+        CollisionWorker::setExecutable(QCoreApplication::applicationFilePath().toStdString());
+
+        BatchCoordinator coordinator(cache);
+        if (!coordinator.loadManifest(argv[2]))
+        {
+            return 2;
+        }
+
+        return coordinator.run();
+    }
+
+    if (argc == 3 && std::string(argv[1]) == "--node")
+    {
+        QCoreApplication app(argc, argv);
+        CollisionWorker::setExecutable(QCoreApplication::applicationFilePath().toStdString());
+
+        BatchNode node(cache);
+        return node.runNode(argv[2]);
+    }
     
 #if defined(__linux__)
     /// Force X11 session & disable window alpha to avoid issues with window alpha sorting
@@ -122,8 +181,12 @@ int main(int argc, char *argv[])
     }
 
     logInfo("Theme style loaded -> {}", app.style()->objectName().toStdString());
+    CollisionWorker::setExecutable(QCoreApplication::applicationFilePath().toStdString());
+
     Logger::active()->debug("Initialising application main window");
     AppWindow win;
+    win.setCollisionCache(cache);
+    win.setReportDirectory(local_app_data + "reports/");
     win.setWindowTitle("Collision Craft");
     win.resize(1000, 720);
     win.show();
@@ -1,25 +1,29 @@
 #include "mesh.h"
+#include "hashing.h"
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <memory>
 #include <vector>
 
-Mesh::Mesh(const std::vector<QVector3D> &vertices, const std::vector<int> &indices) :
+Mesh::Mesh(std::span<const QVector3D> vertices, std::span<const int> indices) :
         bsphere_center(QVector3D(0.0, 0.0, 0.0)),
         bsphere_radius(0.0)
 {
-    this->vertices = std::vector<QVector3D>(vertices.begin(), vertices.end());
-    this->indices = std::vector<int>(indices.begin(), indices.end());
+    this->vertices = MeshBuffer<QVector3D>(vertices.begin(), vertices.end());
+    this->indices = MeshBuffer<int>(indices.begin(), indices.end());
 }
 
 /// Default copy constructor
 Mesh::Mesh(const Mesh &from) :
     bsphere_center(from.bsphere_center),
-    bsphere_radius(from.bsphere_radius)
+    bsphere_radius(from.bsphere_radius),
+    primitive(from.primitive)
 {
     
-    this->vertices = std::vector<QVector3D>(from.vertices.begin(), from.vertices.end());
-    this->indices = std::vector<int>(from.indices.begin(), from.indices.end());
-    this->normals = std::vector<QVector3D>(from.normals.begin(), from.normals.end());
+    this->vertices = from.vertices;
+    this->indices = from.indices;
+    this->normals = from.normals;
 }
 
 /// Auto generates normals based on existing triangle data.
@@ -100,24 +104,74 @@ void Mesh::computeBounds()
     this->bsphere_radius = radius;
 }
 
+/// Computes volume enclosed by this mesh.
+/// Result is only meaningful for closed meshes with consistent winding order.
+double Mesh::computeVolume() const
+{
+    double volume = 0.0;
+    for (int i=0; i+2 < this->indices.size(); i+=3)
+    {
+        const QVector3D &a = this->vertices.at(this->indices.at(i));
+        const QVector3D &b = this->vertices.at(this->indices.at(i+1));
+        const QVector3D &c = this->vertices.at(this->indices.at(i+2));
+
+        volume += QVector3D::dotProduct(a, QVector3D::crossProduct(b, c));
+    }
+
+    return std::abs(volume / 6.0);
+}
+
+/// Computes 64-bit FNV-1a hash of this mesh vertex positions and triangle indices.
+/// Normals and bounds are derived data and do not contribute to the hash.
+uint64_t Mesh::computeHash() const
+{
+    const uint64_t num_vertices = this->vertices.size();
+    const uint64_t num_indices = this->indices.size();
+    uint64_t hash = Hashing::OFFSET_BASIS;
+    hash = Hashing::hashValue(hash, num_vertices);
+    hash = Hashing::hashValue(hash, num_indices);
+
+    hash = Hashing::hashBytes(hash, this->getPositionData().data(), this->getPositionData().size_bytes());
+    hash = Hashing::hashBytes(hash, this->indices.data(), this->indices.size() * sizeof(int));
+    return hash;
+}
+
 /// Get read-only access to mesh vertices.
-const std::vector<QVector3D>& Mesh::getVertices() const
+std::span<const QVector3D> Mesh::getVertices() const
 {
     return this->vertices;
 }
 
 /// Get read-only access to mesh normals.
-const std::vector<QVector3D>& Mesh::getNormals() const
+std::span<const QVector3D> Mesh::getNormals() const
 {
     return this->normals;
 }
 
 /// Get read-only access to mesh triangle indices.
-const std::vector<int>& Mesh::getIndices() const
+std::span<const int> Mesh::getIndices() const
 {
     return this->indices;
 }
 
+/// Get mesh vertex positions as flat array of interleaved xyz floats.
+std::span<const float> Mesh::getPositionData() const
+{
+    return {reinterpret_cast<const float*>(this->vertices.data()), this->vertices.size() * 3};
+}
+
+/// Get mesh normals as flat array of interleaved xyz floats.
+std::span<const float> Mesh::getNormalData() const
+{
+    return {reinterpret_cast<const float*>(this->normals.data()), this->normals.size() * 3};
+}
+
+/// Get mesh triangle indices as unsigned integers.
+std::span<const uint32_t> Mesh::getIndexData() const
+{
+    return {reinterpret_cast<const uint32_t*>(this->indices.data()), this->indices.size()};
+}
+
 /// Get number of vertices stored in this mesh data.
 size_t Mesh::numVertices() const
 {
@@ -130,6 +184,24 @@ size_t Mesh::numNormals() const
     return this->normals.size();
 }
 
+/// Get analytic shape this mesh was tessellated from.
+const MeshPrimitive& Mesh::getPrimitive() const
+{
+    return this->primitive;
+}
+
+/// Mark this mesh as tessellation of given analytic shape.
+void Mesh::setPrimitive(const MeshPrimitive &primitive)
+{
+    this->primitive = primitive;
+}
+
+/// Get value indicating if this mesh represents analytic shape rather than arbitrary triangles.
+bool Mesh::isPrimitive() const
+{
+    return this->primitive.type != MeshPrimitiveType::NoPrimitive;
+}
+
 /// Get number of triangle indices stored in this mesh data.
 size_t Mesh::numIndices() const
 {
@@ -152,14 +224,35 @@ const double Mesh::getBoundingSphereRadius() const
 
 bool Mesh::isValid(const Mesh &mesh)
 {
-    const float epsilon = 1e-6f;
+    if (mesh.numVertices() == 0)
+    {
+        return mesh.numIndices() == 0;
+    }
+
+    /// Minimum triangle area is relative to squared bounding box diagonal, matching
+    /// the threshold CollisionGen::weldMesh drops degenerate triangles by.
+    QVector3D min_bound = mesh.getVertices().front();
+    QVector3D max_bound = min_bound;
+    for (const QVector3D &vertex : mesh.getVertices())
+    {
+        for (int axis=0; axis < 3; axis++)
+        {
+            min_bound[axis] = std::min(min_bound[axis], vertex[axis]);
+            max_bound[axis] = std::max(max_bound[axis], vertex[axis]);
+        }
+    }
+
+    const float diagonal = (max_bound - min_bound).length();
+    const float epsilon = std::max(diagonal * diagonal * 1e-12f, std::numeric_limits<float>::min());
     for (int i=0; i+2<mesh.numIndices(); i+=3)
     {
         const int p0 = mesh.getIndices()[i];
         const int p1 = mesh.getIndices()[i+1];
         const int p2 = mesh.getIndices()[i+2];
 
-        if (p0 < 0 || p0 >= mesh.numVertices())
+        if (p0 < 0 || p0 >= mesh.numVertices() ||
+            p1 < 0 || p1 >= mesh.numVertices() ||
+            p2 < 0 || p2 >= mesh.numVertices())
         {
             return false;
         }
@@ -1,25 +1,73 @@
 #ifndef MESH_H
 #define MESH_H
 
+#include "alignedallocator.h"
+#include <cstdint>
 #include <memory>
+#include <span>
+#include <type_traits>
 #include <vector>
+#include <QQuaternion>
 #include <QVector3D>
 
+/// Vertex data is handed to VHACD, OpenGL and USD as flat float arrays.
+static_assert(sizeof(QVector3D) == 3 * sizeof(float), "QVector3D must be tightly packed");
+static_assert(sizeof(int) == sizeof(uint32_t), "Triangle indices must be 32-bit");
+
+/// Contiguous cache line aligned storage for mesh data.
+template <typename T>
+using MeshBuffer = std::vector<T, AlignedAllocator<T>>;
+
+enum MeshPrimitiveType
+{
+    NoPrimitive = 0,
+    BoxPrimitive = 1,
+    SpherePrimitive = 2,
+    CapsulePrimitive = 3
+};
+
+
+/// Analytic shape a mesh was tessellated from, allows exporting it as typed shape.
+/// Box spans half extents along its local axes, capsule extends along its local Z axis.
+struct MeshPrimitive
+{
+    int         type = MeshPrimitiveType::NoPrimitive;
+    QVector3D   center;
+    QQuaternion rotation;
+    QVector3D   half_extents;
+    float       radius = 0.0f;
+    float       half_height = 0.0f;
+};
+
+static_assert(std::is_trivially_copyable_v<MeshPrimitive>, "Mesh primitive is stored as raw bytes");
+
+
 class Mesh
 {
 public:
-    Mesh(const std::vector<QVector3D> &vertices, const std::vector<int> &indices);
+    Mesh(std::span<const QVector3D> vertices, std::span<const int> indices);
     Mesh(const Mesh &from);
+    Mesh& operator=(const Mesh &from) = default;
 
-    const std::vector<QVector3D>& getVertices() const;
-    const std::vector<QVector3D>& getNormals() const;
-    const std::vector<int>& getIndices() const;
+    std::span<const QVector3D> getVertices() const;
+    std::span<const QVector3D> getNormals() const;
+    std::span<const int> getIndices() const;
+
+    std::span<const float> getPositionData() const;
+    std::span<const float> getNormalData() const;
+    std::span<const uint32_t> getIndexData() const;
+
+    const MeshPrimitive& getPrimitive() const;
+    void setPrimitive(const MeshPrimitive &primitive);
+    bool isPrimitive() const;
 
     size_t numIndices() const;
     size_t numVertices() const;
     size_t numNormals() const;
     void generateNormals();
     void computeBounds();
+    double computeVolume() const;
+    uint64_t computeHash() const;
 
     const QVector3D& getBoundingSphereCenter() const;
     const double getBoundingSphereRadius() const;
@@ -27,12 +75,14 @@ public:
     static bool isValid(const Mesh &mesh);
 
 protected:
-    std::vector<QVector3D> vertices;
-    std::vector<QVector3D> normals;
-    std::vector<int> indices;
+    MeshBuffer<QVector3D> vertices;
+    MeshBuffer<QVector3D> normals;
+    MeshBuffer<int> indices;
 
     QVector3D bsphere_center;
     double bsphere_radius;
+
+    MeshPrimitive primitive;
 };
 
 #endif
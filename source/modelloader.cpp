@@ -5,6 +5,7 @@
 #include "pxr/base/gf/vec3d.h"
 #include "pxr/usd/usd/common.h"
 
+#include <cstring>
 #include <vector>
 #include <QString>
 #include <QDir>
@@ -19,8 +20,14 @@
 #include <pxr/usd/usdGeom/xformCommonAPI.h>
 #include <pxr/usd/usd/primRange.h>
 #include <pxr/usd/usdGeom/mesh.h>
+#include <pxr/usd/usdGeom/cube.h>
+#include <pxr/usd/usdGeom/sphere.h>
+#include <pxr/usd/usdGeom/capsule.h>
+#include <pxr/base/gf/quatf.h>
 #include <pxr/base/vt/array.h>
 
+static_assert(sizeof(pxr::GfVec3f) == sizeof(QVector3D), "Mesh vertex layout must match GfVec3f");
+
 /// Load model data from USD file stored in QT resource pack.
 /// @param: resource_path Resource pack relative path to the usd model.
 /// @param: meshes Container to append loaded meshes to.
@@ -131,32 +138,67 @@ void ModelLoader::SaveUSD(const std::string &filepath, const std::vector<const M
 {
     pxr::UsdStageRefPtr stage = pxr::UsdStage::CreateNew(filepath);
     pxr::UsdGeomXform root_xform = pxr::UsdGeomXform::Define(stage, pxr::SdfPath("/Scene"));
+    ModelLoader::DefineMeshesUSD(stage, "/Scene", meshes);
+
+    stage->GetRootLayer()->Save(true);
+}
+
+/// Save collision LOD levels to USD model file on disk, each level is written under its own
+/// scene root child named LOD_<level>, finest level first.
+/// @param: filepath Location to write model file on disk.
+/// @param: levels List of meshes of each level to write to USD file.
+void ModelLoader::SaveLODsUSD(const std::string &filepath, const std::vector<std::vector<const Mesh*>> &levels)
+{
+    pxr::UsdStageRefPtr stage = pxr::UsdStage::CreateNew(filepath);
+    pxr::UsdGeomXform root_xform = pxr::UsdGeomXform::Define(stage, pxr::SdfPath("/Scene"));
+    for (size_t level=0; level < levels.size(); level++)
+    {
+        const std::string level_path = std::vformat("/Scene/LOD_{}", std::make_format_args(level));
+        pxr::UsdGeomXform::Define(stage, pxr::SdfPath(level_path));
+        ModelLoader::DefineMeshesUSD(stage, level_path, levels.at(level));
+    }
 
+    stage->GetRootLayer()->Save(true);
+}
+
+/// Define mesh or typed shape prims for given meshes under given parent prim.
+/// @param: stage Stage to define the prims in.
+/// @param: parent_path Path of the prim to define meshes under.
+/// @param: meshes List of meshes to define.
+void ModelLoader::DefineMeshesUSD(
+    const pxr::UsdStageRefPtr &stage,
+    const std::string &parent_path,
+    const std::vector<const Mesh*> &meshes
+)
+{
     unsigned int id = 1;
     for (const Mesh *mesh : meshes)
     {
+        /// Fitted primitives are written as typed shapes so importers can use analytic collision.
+        if (mesh->isPrimitive())
+        {
+            ModelLoader::DefinePrimitiveUSD(stage, parent_path, mesh->getPrimitive(), id);
+            id ++;
+            continue;
+        }
+
         /// Note we use std::vformat as std::format is not fully implemented on MacOS
         std::string mesh_name = std::vformat(
-        "/Scene/Mesh_{}",
-        std::make_format_args(id)
-    );
+            "{}/Mesh_{}",
+            std::make_format_args(parent_path, id)
+        );
         pxr::UsdGeomMesh usd_mesh = pxr::UsdGeomMesh::Define(stage, pxr::SdfPath(mesh_name));
 
-        pxr::VtArray<pxr::GfVec3f> vertices;
-        vertices.reserve(mesh->numVertices());
-        for (const QVector3D &vertex : mesh->getVertices())
-        {
-            vertices.emplace_back(vertex.x(), vertex.y(), vertex.z());
-        }
+        /// Mesh buffers are contiguous, so each array is filled by a single copy.
+        pxr::VtArray<pxr::GfVec3f> vertices(mesh->numVertices());
+        std::memcpy(vertices.data(), mesh->getPositionData().data(), mesh->getPositionData().size_bytes());
 
-        pxr::VtArray<pxr::GfVec3f> normals;
-        vertices.reserve(mesh->numNormals());
-        for (const QVector3D &normal : mesh->getNormals())
-        {
-            normals.emplace_back(normal.x(), normal.y(), normal.z());
-        }
+        pxr::VtArray<pxr::GfVec3f> normals(mesh->numNormals());
+        std::memcpy(normals.data(), mesh->getNormalData().data(), mesh->getNormalData().size_bytes());
+
+        pxr::VtArray<int> indices(mesh->numIndices());
+        std::memcpy(indices.data(), mesh->getIndices().data(), mesh->getIndices().size_bytes());
 
-        pxr::VtArray<int> indices(mesh->getIndices().begin(), mesh->getIndices().end());
         pxr::VtArray<int> nums(mesh->numIndices() / 3, 3);
 
         usd_mesh.CreatePointsAttr().Set(vertices);
@@ -166,6 +208,78 @@ void ModelLoader::SaveUSD(const std::string &filepath, const std::vector<const M
         usd_mesh.CreateFaceVertexCountsAttr().Set(nums);
         id ++;
     }
+}
 
-    stage->GetRootLayer()->Save(true);
+/// Define typed shape prim for given primitive.
+/// @param: stage Stage to define the prim in.
+/// @param: parent_path Path of the prim to define the shape under.
+/// @param: primitive Primitive to write.
+/// @param: id Unique number used in the prim name.
+void ModelLoader::DefinePrimitiveUSD(
+    const pxr::UsdStageRefPtr &stage,
+    const std::string &parent_path,
+    const MeshPrimitive &primitive,
+    unsigned int id
+)
+{
+    const pxr::GfVec3d translation(primitive.center.x(), primitive.center.y(), primitive.center.z());
+    const pxr::GfQuatf orientation(
+        primitive.rotation.scalar(),
+        primitive.rotation.x(),
+        primitive.rotation.y(),
+        primitive.rotation.z()
+    );
+    const float radius = primitive.radius;
+
+    switch (primitive.type)
+    {
+        case MeshPrimitiveType::BoxPrimitive:
+        {
+            /// Cube of size 2 spans unit half extents, scale gives the box its extents.
+            const pxr::SdfPath path(std::vformat("{}/Box_{}", std::make_format_args(parent_path, id)));
+            pxr::UsdGeomCube cube = pxr::UsdGeomCube::Define(stage, path);
+            cube.CreateSizeAttr().Set(2.0);
+            cube.CreateExtentAttr().Set(pxr::VtVec3fArray({pxr::GfVec3f(-1.0f), pxr::GfVec3f(1.0f)}));
+            cube.AddTranslateOp().Set(translation);
+            cube.AddOrientOp().Set(orientation);
+            cube.AddScaleOp().Set(pxr::GfVec3f(
+                primitive.half_extents.x(),
+                primitive.half_extents.y(),
+                primitive.half_extents.z()
+            ));
+            break;
+        }
+
+        case MeshPrimitiveType::SpherePrimitive:
+        {
+            const pxr::SdfPath path(std::vformat("{}/Sphere_{}", std::make_format_args(parent_path, id)));
+            pxr::UsdGeomSphere sphere = pxr::UsdGeomSphere::Define(stage, path);
+            sphere.CreateRadiusAttr().Set(double(radius));
+            sphere.CreateExtentAttr().Set(pxr::VtVec3fArray({pxr::GfVec3f(-radius), pxr::GfVec3f(radius)}));
+            sphere.AddTranslateOp().Set(translation);
+            break;
+        }
+
+        case MeshPrimitiveType::CapsulePrimitive:
+        {
+            /// Capsule height excludes its end caps.
+            const float half_length = primitive.half_height + radius;
+            const pxr::SdfPath path(std::vformat("{}/Capsule_{}", std::make_format_args(parent_path, id)));
+            pxr::UsdGeomCapsule capsule = pxr::UsdGeomCapsule::Define(stage, path);
+            capsule.CreateAxisAttr().Set(pxr::UsdGeomTokens->z);
+            capsule.CreateRadiusAttr().Set(double(radius));
+            capsule.CreateHeightAttr().Set(double(primitive.half_height * 2.0f));
+            capsule.CreateExtentAttr().Set(pxr::VtVec3fArray({
+                pxr::GfVec3f(-radius, -radius, -half_length),
+                pxr::GfVec3f(radius, radius, half_length)
+            }));
+            capsule.AddTranslateOp().Set(translation);
+            capsule.AddOrientOp().Set(orientation);
+            break;
+        }
+
+        default:
+            logWarning("Skipping export of unsupported primitive type -> {}", primitive.type);
+            break;
+    }
 }
@@ -3,6 +3,9 @@
 
 #include "mesh.h"
 
+#include <pxr/base/vt/array.h>
+#include <pxr/usd/usd/stage.h>
+
 #include <string>
 #include <vector>
 
@@ -17,6 +20,25 @@ public:
 
     static void
     SaveUSD(const std::string &filepath, const std::vector<const Mesh*> &meshes);
+
+    static void
+    SaveLODsUSD(const std::string &filepath, const std::vector<std::vector<const Mesh*>> &levels);
+
+private:
+    static void
+    DefineMeshesUSD(
+        const pxr::UsdStageRefPtr &stage,
+        const std::string &parent_path,
+        const std::vector<const Mesh*> &meshes
+    );
+
+    static void
+    DefinePrimitiveUSD(
+        const pxr::UsdStageRefPtr &stage,
+        const std::string &parent_path,
+        const MeshPrimitive &primitive,
+        unsigned int id
+    );
 };
 
 #endif
@@ -9,7 +9,8 @@
 
 
 PropertyPanelWidget::PropertyPanelWidget(QWidget *parent) : 
-    QWidget(parent)
+    QWidget(parent),
+    generation_active(false)
 {
     QVBoxLayout *panel_layout = new QVBoxLayout();
     panel_layout->setContentsMargins(QMargins(0.0, 0.0, 0.0, 0.0));
@@ -27,6 +28,36 @@ PropertyPanelWidget::PropertyPanelWidget(QWidget *parent) :
 /// Should be called onlly once in the constructor.
 void PropertyPanelWidget::initGenerationProperties(QLayout *parent_layout)
 {
+    this->technique_property = new DropdownPropertyWidget(
+        "Technique",
+        "Collision generation technique",
+        this
+    );
+    this->technique_property->addItem("Approximate Decomposition", CollisionTechnique::ApproximateDecomposition);
+    this->technique_property->addItem("Exact Decomposition", CollisionTechnique::ExactDecomposition);
+    this->technique_property->addItem("Simple Hull", CollisionTechnique::SimpleHull);
+    this->technique_property->addItem("Primitive Fit", CollisionTechnique::PrimitiveFit);
+    this->technique_property->addItem("Voxel Boxes", CollisionTechnique::VoxelBoxes);
+    this->technique_property->setSelected(CollisionTechnique::ApproximateDecomposition);
+
+    this->hull_per_mesh_property = new TogglePropertyWidget(
+        "Hull Per Mesh",
+        true,
+        "Simple Hull - Generate one hull per mesh instead of one hull for the whole scene",
+        this
+    );
+
+    this->hull_padding_property = new DecimalPropertyWidget(
+        "Hull Padding",
+        0.0,
+        0.0,
+        0.5,
+        0.01,
+        2,
+        "Simple Hull - Padding relative to the bounding sphere diameter of each mesh",
+        this
+    );
+
     this->scale_property = new DecimalPropertyWidget(
         "Scale",
         1.0,
@@ -38,6 +69,65 @@ void PropertyPanelWidget::initGenerationProperties(QLayout *parent_layout)
         this
     );
     
+    this->primitive_tolerance_property = new DecimalPropertyWidget(
+        "Primitive Tolerance",
+        0.25,
+        0.0,
+        1.0,
+        0.01,
+        2,
+        "Primitive Fit - Maximum fraction of primitive volume outside the convex hull, otherwise hull is kept",
+        this
+    );
+
+    this->voxel_resolution_property = new IntegerPropertyWidget(
+        "Voxel Resolution",
+        32,
+        2,
+        256,
+        1,
+        "Voxel Boxes - Number of voxels along the longest side of each mesh",
+        this
+    );
+
+    this->max_boxes_property = new IntegerPropertyWidget(
+        "Max Box Count",
+        32,
+        1,
+        1024,
+        1,
+        "Voxel Boxes - Maximum number of boxes for each mesh, voxel resolution is lowered to meet it",
+        this
+    );
+
+    this->oriented_boxes_property = new TogglePropertyWidget(
+        "Oriented Boxes",
+        false,
+        "Voxel Boxes - Align boxes with the oriented bounding box of each mesh instead of the world axes",
+        this
+    );
+
+    this->exact_time_budget_property = new DecimalPropertyWidget(
+        "Time Budget",
+        30.0,
+        0.1,
+        3600.0,
+        1.0,
+        1,
+        "Exact Decomposition - Wall-clock budget in seconds for each mesh",
+        this
+    );
+
+    this->exact_max_pieces_property = new IntegerPropertyWidget(
+        "Max Pieces",
+        64,
+        1,
+        1024,
+        1,
+        "Exact Decomposition - Maximum number of convex pieces for each mesh",
+        this
+    );
+
     this->mode_property = new IntegerPropertyWidget(
         "Mode",
         0,
@@ -121,20 +211,221 @@ void PropertyPanelWidget::initGenerationProperties(QLayout *parent_layout)
         this
     );
     
+    this->worker_threads_property = new IntegerPropertyWidget(
+        "Worker Threads",
+        0,
+        0,
+        256,
+        1,
+        "Number of meshes processed in parallel, 0=Use all cores",
+        this
+    );
+    
+    this->cleanup_mode_property = new DropdownPropertyWidget(
+        "Mesh Cleanup",
+        "Mesh repair technique - Fast and Alpha Wrap fall back to Exact when they fail to produce closed volume",
+        this
+    );
+    this->cleanup_mode_property->addItem("Fast", MeshCleanupMode::FastCleanup);
+    this->cleanup_mode_property->addItem("Exact", MeshCleanupMode::ExactCleanup);
+    this->cleanup_mode_property->addItem("Alpha Wrap", MeshCleanupMode::AlphaWrapCleanup);
+    this->cleanup_mode_property->setSelected(MeshCleanupMode::ExactCleanup);
+
+    this->wrap_alpha_property = new DecimalPropertyWidget(
+        "Wrap Alpha",
+        2.0,
+        0.1,
+        100.0,
+        0.5,
+        2,
+        "Alpha Wrap - Size of the carving ball in decomposition voxels, smaller follows concavities closer",
+        this
+    );
+
+    this->wrap_offset_property = new DecimalPropertyWidget(
+        "Wrap Offset",
+        0.5,
+        0.01,
+        10.0,
+        0.1,
+        2,
+        "Alpha Wrap - Distance of the wrap from the input surface in decomposition voxels",
+        this
+    );
+    
+    this->decimate_property = new TogglePropertyWidget(
+        "Pre-Decimation",
+        false,
+        "Approximate - Simplify dense meshes within error bound given by the voxel size before decomposition",
+        this
+    );
+
+    this->merge_threshold_property = new DecimalPropertyWidget(
+        "Hull Merge Threshold",
+        0.0,
+        0.0,
+        1.0,
+        0.01,
+        2,
+        "Approximate - Merge hulls while merged hull adds less volume than given fraction, 0=Disabled",
+        this
+    );
+
+    this->strict_vertex_limit_property = new TogglePropertyWidget(
+        "Strict Vertex Limit",
+        false,
+        "Simplify hulls exceeding max hull vertex count by merging coplanar faces and removing planes",
+        this
+    );
+
+    this->lod_levels_property = new IntegerPropertyWidget(
+        "LOD Levels",
+        1,
+        1,
+        8,
+        1,
+        "Number of collision LOD levels generated in single run, coarser levels merge hulls of the finer ones",
+        this
+    );
+
+    this->lod_ratio_property = new DecimalPropertyWidget(
+        "LOD Hull Ratio",
+        0.5,
+        0.05,
+        0.95,
+        0.05,
+        2,
+        "Fraction of hulls each LOD level keeps from the level above",
+        this
+    );
+
+    this->mesh_time_budget_property = new DecimalPropertyWidget(
+        "Mesh Time Budget",
+        0.0,
+        0.0,
+        86400.0,
+        10.0,
+        1,
+        "Approximate Decomposition - Seconds each mesh may take before it is retried at lower resolution, 0=Unlimited",
+        this
+    );
+
+    this->mesh_memory_budget_property = new DecimalPropertyWidget(
+        "Mesh Memory Budget",
+        0.0,
+        0.0,
+        1048576.0,
+        256.0,
+        0,
+        "Approximate Decomposition - Megabytes of memory each mesh may take before it is retried at lower resolution, 0=Unlimited",
+        this
+    );
+
+    this->worker_processes_property = new TogglePropertyWidget(
+        "Worker Processes",
+        false,
+        "Approximate Decomposition - Decompose meshes in separate processes so library crashes do not close the app",
+        this
+    );
+
+    this->dedupe_instances_property = new TogglePropertyWidget(
+        "Deduplicate Instances",
+        false,
+        "Generate collision once for meshes that are copies of each other, including rotated and moved copies",
+        this
+    );
+
+    this->compute_metrics_property = new TogglePropertyWidget(
+        "Quality Metrics",
+        false,
+        "Measure volume IoU and Hausdorff distance of generated collision and write JSON report",
+        this
+    );
+
+    this->target_hull_count_property = new IntegerPropertyWidget(
+        "Target Hull Count",
+        16,
+        1,
+        255,
+        1,
+        "Auto-Tune - Maximum number of hulls for each mesh the tuned collision may use",
+        this
+    );
+
+    this->target_vertex_count_property = new IntegerPropertyWidget(
+        "Target Vertex Count",
+        32,
+        4,
+        1024,
+        1,
+        "Auto-Tune - Maximum number of vertices in each hull of the tuned collision",
+        this
+    );
+
+    this->target_error_property = new DecimalPropertyWidget(
+        "Target Error",
+        1.0,
+        0.01,
+        100.0,
+        0.1,
+        2,
+        "Auto-Tune - Maximum Hausdorff distance in percent of the bounding sphere diameter of each mesh",
+        this
+    );
+
     this->generate_button = new QPushButton("Generate Collision", this);
     this->generate_button->setMinimumHeight(32);
 
+    this->auto_tune_button = new QPushButton("Auto-Tune Collision", this);
+    this->auto_tune_button->setMinimumHeight(32);
+    this->auto_tune_button->setToolTip(
+        "Sweep approximate decomposition settings and keep the cheapest collision meeting the targets"
+    );
+
+    this->generate_progress = new QProgressBar(this);
+    this->generate_progress->setRange(0, 100);
+    this->generate_progress->setValue(0);
+    this->generate_progress->setVisible(false);
+
     ExpanderWidget *expander = new ExpanderWidget("Collision Generation", this);
+    expander->addWidget(this->technique_property);
+    expander->addWidget(this->hull_per_mesh_property);
+    expander->addWidget(this->hull_padding_property);
+    expander->addWidget(this->primitive_tolerance_property);
+    expander->addWidget(this->voxel_resolution_property);
+    expander->addWidget(this->max_boxes_property);
+    expander->addWidget(this->oriented_boxes_property);
+    expander->addWidget(this->exact_time_budget_property);
+    expander->addWidget(this->exact_max_pieces_property);
     expander->addWidget(this->mode_property);
+    expander->addWidget(this->cleanup_mode_property);
+    expander->addWidget(this->wrap_alpha_property);
+    expander->addWidget(this->wrap_offset_property);
+    expander->addWidget(this->decimate_property);
+    expander->addWidget(this->merge_threshold_property);
     expander->addWidget(this->scale_property);
     expander->addWidget(this->resolution_property);
     expander->addWidget(this->concavity_property);
     expander->addWidget(this->depth_property);
     expander->addWidget(this->hull_count_property);
     expander->addWidget(this->hull_vertex_count_property);
+    expander->addWidget(this->strict_vertex_limit_property);
     expander->addWidget(this->hull_min_volume_property);
     expander->addWidget(this->downsampling_property);
+    expander->addWidget(this->worker_threads_property);
+    expander->addWidget(this->mesh_time_budget_property);
+    expander->addWidget(this->mesh_memory_budget_property);
+    expander->addWidget(this->worker_processes_property);
+    expander->addWidget(this->lod_levels_property);
+    expander->addWidget(this->lod_ratio_property);
+    expander->addWidget(this->dedupe_instances_property);
+    expander->addWidget(this->compute_metrics_property);
+    expander->addWidget(this->target_hull_count_property);
+    expander->addWidget(this->target_vertex_count_property);
+    expander->addWidget(this->target_error_property);
     expander->addWidget(this->generate_button);
+    expander->addWidget(this->auto_tune_button);
+    expander->addWidget(this->generate_progress);
 
     parent_layout->addWidget(expander);
 
@@ -142,7 +433,14 @@ void PropertyPanelWidget::initGenerationProperties(QLayout *parent_layout)
         this->generate_button,
         &QPushButton::clicked,
         this,
-        &PropertyPanelWidget::collisionGenerationRequested
+        &PropertyPanelWidget::onGenerateButtonClick
+    );
+
+    connect(
+        this->auto_tune_button,
+        &QPushButton::clicked,
+        this,
+        &PropertyPanelWidget::onAutoTuneButtonClick
     );
 }
 
@@ -290,6 +588,49 @@ void PropertyPanelWidget::onViewportSettingsPropertyChanged()
     Q_EMIT this->viewportSettingsChanged(settings);
 }
 
+/// Event handler invoked when the user clicks the generate button.
+/// Button requests new generation when idle and cancels active generation otherwise.
+void PropertyPanelWidget::onGenerateButtonClick()
+{
+    if (this->generation_active)
+    {
+        Q_EMIT this->collisionGenerationCancelRequested();
+    }
+    else
+    {
+        Q_EMIT this->collisionGenerationRequested();
+    }
+}
+
+/// Event handler invoked when the user clicks the auto-tune button.
+void PropertyPanelWidget::onAutoTuneButtonClick()
+{
+    if (!this->generation_active)
+    {
+        Q_EMIT this->collisionAutoTuneRequested();
+    }
+}
+
+/// Switch generation controls between idle and running state.
+void PropertyPanelWidget::setGenerationActive(bool active)
+{
+    this->generation_active = active;
+    this->generate_button->setText(active ? "Cancel Generation" : "Generate Collision");
+    this->auto_tune_button->setEnabled(!active);
+    this->generate_progress->setValue(0);
+    this->generate_progress->setFormat("%p%");
+    this->generate_progress->setVisible(active);
+}
+
+/// Update generation progress indicator.
+/// @param: progress Normalized progress value.
+/// @param: stage Description of currently running generation stage.
+void PropertyPanelWidget::setGenerationProgress(double progress, const QString &stage)
+{
+    this->generate_progress->setValue(static_cast<int>(progress * 100.0));
+    this->generate_progress->setFormat(stage.isEmpty() ? "%p%" : stage + " - %p%");
+}
+
 /// Get collision generation settings from property values.
 CollisionGenSettings PropertyPanelWidget::getSettings() const
 {
@@ -303,6 +644,51 @@ CollisionGenSettings PropertyPanelWidget::getSettings() const
     settings.mode = this->mode_property->getValue();
     settings.concavity = this->concavity_property->getValue();
     settings.depth_planes = this->depth_property->getValue();
+    settings.worker_threads = this->worker_threads_property->getValue();
+    settings.cleanup_mode = this->cleanup_mode_property->getSelected();
+    settings.technique = this->technique_property->getSelected();
+    settings.hull_per_mesh = this->hull_per_mesh_property->getValue();
+    settings.hull_padding = this->hull_padding_property->getValue();
+    settings.exact_time_budget = this->exact_time_budget_property->getValue();
+    settings.exact_max_pieces = this->exact_max_pieces_property->getValue();
+    settings.decimate = this->decimate_property->getValue();
+    settings.merge_threshold = this->merge_threshold_property->getValue();
+    settings.strict_vertex_limit = this->strict_vertex_limit_property->getValue();
+    settings.compute_metrics = this->compute_metrics_property->getValue();
+    settings.primitive_tolerance = this->primitive_tolerance_property->getValue();
+    settings.voxel_resolution = this->voxel_resolution_property->getValue();
+    settings.max_boxes = this->max_boxes_property->getValue();
+    settings.oriented_boxes = this->oriented_boxes_property->getValue();
+    settings.lod_levels = this->lod_levels_property->getValue();
+    settings.lod_ratio = this->lod_ratio_property->getValue();
+    settings.dedupe_instances = this->dedupe_instances_property->getValue();
+    settings.wrap_alpha = this->wrap_alpha_property->getValue();
+    settings.wrap_offset = this->wrap_offset_property->getValue();
+    settings.mesh_time_budget = this->mesh_time_budget_property->getValue();
+    settings.mesh_memory_budget = this->mesh_memory_budget_property->getValue();
+    settings.worker_processes = this->worker_processes_property->getValue();
 
     return settings;
 }
+
+/// Get budget auto-tuned collision has to meet from property values.
+CollisionSweepTarget PropertyPanelWidget::getSweepTarget() const
+{
+    CollisionSweepTarget target;
+    target.max_hulls = this->target_hull_count_property->getValue();
+    target.max_hull_vertices = this->target_vertex_count_property->getValue();
+    target.max_error = this->target_error_property->getValue() / 100.0;
+
+    return target;
+}
+
+/// Update properties to settings selected by auto-tuning so the user can keep refining them.
+void PropertyPanelWidget::applyTunedSettings(const CollisionGenSettings &settings)
+{
+    this->technique_property->setSelected(settings.technique);
+    this->resolution_property->setValue(settings.resolution);
+    this->concavity_property->setValue(settings.concavity);
+    this->hull_count_property->setValue(settings.max_hulls);
+    this->hull_vertex_count_property->setValue(settings.max_hull_vertices);
+    this->strict_vertex_limit_property->setValue(settings.strict_vertex_limit);
+}
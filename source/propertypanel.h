@@ -2,11 +2,13 @@
 #define PROPERTY_PANEL_H
 
 #include "collisiongen.h"
+#include "collisionsweep.h"
 #include "propertywidgets.h"
 #include "viewportwidget.h"
 
 #include <QWidget>
 #include <QPushButton>
+#include <QProgressBar>
 
 
 class PropertyPanelWidget : public QWidget
@@ -16,16 +18,28 @@ class PropertyPanelWidget : public QWidget
 public:
     PropertyPanelWidget(QWidget *parent = nullptr);
     CollisionGenSettings getSettings() const;
+    CollisionSweepTarget getSweepTarget() const;
+    void applyTunedSettings(const CollisionGenSettings &settings);
     ViewportSettings getViewportSettings() const;
+    void setGenerationActive(bool active);
+    void setGenerationProgress(double progress, const QString &stage);
 
     Q_SIGNAL
     void collisionGenerationRequested();
 
+    Q_SIGNAL
+    void collisionGenerationCancelRequested();
+
+    Q_SIGNAL
+    void collisionAutoTuneRequested();
+
     Q_SIGNAL
     void viewportSettingsChanged(ViewportSettings settings);
 
 protected:
     void onViewportSettingsPropertyChanged();
+    void onGenerateButtonClick();
+    void onAutoTuneButtonClick();
 
 private:
     void initGenerationProperties(QLayout *parent_layout);
@@ -34,17 +48,47 @@ private:
 
 private:
     QPushButton             *generate_button;
+    QPushButton             *auto_tune_button;
+    QProgressBar            *generate_progress;
+    bool                    generation_active;
 
     DecimalPropertyWidget   *scale_property;
     DecimalPropertyWidget   *resolution_property;
     DecimalPropertyWidget   *hull_min_volume_property;
     DecimalPropertyWidget   *concavity_property;
+    DecimalPropertyWidget   *hull_padding_property;
+    DecimalPropertyWidget   *exact_time_budget_property;
+    DecimalPropertyWidget   *merge_threshold_property;
+    DecimalPropertyWidget   *target_error_property;
+    DecimalPropertyWidget   *primitive_tolerance_property;
+    DecimalPropertyWidget   *lod_ratio_property;
+    DecimalPropertyWidget   *wrap_alpha_property;
+    DecimalPropertyWidget   *wrap_offset_property;
+    DecimalPropertyWidget   *mesh_time_budget_property;
+    DecimalPropertyWidget   *mesh_memory_budget_property;
     
     IntegerPropertyWidget   *downsampling_property;
     IntegerPropertyWidget   *hull_count_property;
     IntegerPropertyWidget   *hull_vertex_count_property;
     IntegerPropertyWidget   *depth_property;
     IntegerPropertyWidget   *mode_property;
+    IntegerPropertyWidget   *worker_threads_property;
+    IntegerPropertyWidget   *exact_max_pieces_property;
+    IntegerPropertyWidget   *target_hull_count_property;
+    IntegerPropertyWidget   *target_vertex_count_property;
+    IntegerPropertyWidget   *voxel_resolution_property;
+    IntegerPropertyWidget   *max_boxes_property;
+    IntegerPropertyWidget   *lod_levels_property;
+
+    DropdownPropertyWidget  *cleanup_mode_property;
+    DropdownPropertyWidget  *technique_property;
+    TogglePropertyWidget    *hull_per_mesh_property;
+    TogglePropertyWidget    *decimate_property;
+    TogglePropertyWidget    *strict_vertex_limit_property;
+    TogglePropertyWidget    *compute_metrics_property;
+    TogglePropertyWidget    *oriented_boxes_property;
+    TogglePropertyWidget    *dedupe_instances_property;
+    TogglePropertyWidget    *worker_processes_property;
 
     TogglePropertyWidget    *collision_hidden_property;
     TogglePropertyWidget    *collision_fill_property;
@@ -17,8 +17,8 @@ RenderMesh::RenderMesh(const Mesh &mesh)
     this->vertex_attributes.create();
     this->vertex_attributes.bind();
 
-    const int position_size = mesh.numVertices() * sizeof(QVector3D);
-    const int normal_size = mesh.numNormals() * sizeof(QVector3D);
+    const int position_size = mesh.getPositionData().size_bytes();
+    const int normal_size = mesh.getNormalData().size_bytes();
     const int buffer_size = position_size + normal_size;
 
     this->vertex_buffer.create();
@@ -27,14 +27,14 @@ RenderMesh::RenderMesh(const Mesh &mesh)
 
     /// We write vertex buffer data sequentially by data type.
     /// Buffer layout example [[position], [normals], [other]]
-    this->vertex_buffer.write(0, mesh.getVertices().data(), position_size);
-    this->vertex_buffer.write(position_size, mesh.getNormals().data(), normal_size);
+    this->vertex_buffer.write(0, mesh.getPositionData().data(), position_size);
+    this->vertex_buffer.write(position_size, mesh.getNormalData().data(), normal_size);
 
     this->index_buffer.create();
     this->index_buffer.bind();
     this->index_buffer.allocate(
-        mesh.getIndices().data(),
-        mesh.numIndices() * sizeof(int)
+        mesh.getIndexData().data(),
+        mesh.getIndexData().size_bytes()
     );
 
     /// Note: Depending on platform (MacOS) OpenGL context can defer buffer writes causing first
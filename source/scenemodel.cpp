@@ -7,6 +7,7 @@ SceneModel::SceneModel(const Mesh &source_mesh)
 {
     this->mesh = std::make_unique<Mesh>(source_mesh);
     this->render_mesh = std::make_unique<RenderMesh>(source_mesh);
+    this->mesh_hash = this->mesh->computeHash();
 }
 
 /// Get readonly reference to this model geometry mesh.
@@ -20,3 +21,10 @@ RenderMesh& SceneModel::getRenderMesh()
 {
     return *this->render_mesh;
 }
+
+/// Get content hash of this model geometry mesh.
+/// Hash is computed once when the model is created as the geometry is immutable.
+uint64_t SceneModel::getMeshHash() const
+{
+    return this->mesh_hash;
+}
@@ -3,6 +3,7 @@
 
 #include "mesh.h"
 #include "rendermesh.h"
+#include <cstdint>
 #include <memory>
 
 class SceneModel
@@ -12,8 +13,10 @@ public:
 
     const Mesh& getMesh() const;
     RenderMesh& getRenderMesh();
+    uint64_t getMeshHash() const;
 
 private:
+    uint64_t mesh_hash;
     std::unique_ptr<Mesh> mesh;
     std::unique_ptr<RenderMesh> render_mesh;
 };
@@ -0,0 +1,39 @@
+#include "testing.h"
+#include "batchcluster.h"
+
+#include <string>
+
+
+TEST_CASE(batchParseAddress)
+{
+    std::string host;
+    int port = 0;
+
+    TEST_CHECK(BatchNode::parseAddress("127.0.0.1:4711", host, port));
+    TEST_CHECK(host == "127.0.0.1");
+    TEST_CHECK(port == 4711);
+
+    TEST_CHECK(BatchNode::parseAddress("render-farm.local:65535", host, port));
+    TEST_CHECK(host == "render-farm.local");
+    TEST_CHECK(port == 65535);
+
+    /// IPv6 hosts are enclosed in brackets, which are stripped.
+    TEST_CHECK(BatchNode::parseAddress("[::1]:8080", host, port));
+    TEST_CHECK(host == "::1");
+    TEST_CHECK(port == 8080);
+}
+
+TEST_CASE(batchParseAddressRejectsInvalid)
+{
+    std::string host;
+    int port = 0;
+
+    TEST_CHECK(!BatchNode::parseAddress("", host, port));
+    TEST_CHECK(!BatchNode::parseAddress("localhost", host, port));
+    TEST_CHECK(!BatchNode::parseAddress(":4711", host, port));
+    TEST_CHECK(!BatchNode::parseAddress("localhost:", host, port));
+    TEST_CHECK(!BatchNode::parseAddress("localhost:port", host, port));
+    TEST_CHECK(!BatchNode::parseAddress("localhost:0", host, port));
+    TEST_CHECK(!BatchNode::parseAddress("localhost:65536", host, port));
+    TEST_CHECK(!BatchNode::parseAddress("localhost:-1", host, port));
+}
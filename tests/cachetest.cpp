@@ -0,0 +1,115 @@
+#include "testing.h"
+#include "testmeshes.h"
+#include "collisioncache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+
+static const uint64_t CACHE_KEY = 0x1234abcd5678ef00ull;
+static const uint64_t OTHER_CACHE_KEY = 0x00ff00ff00ff00ffull;
+
+/// Byte offset of the first index in entry holding single box, see CollisionCache::store.
+static const std::streamoff FIRST_INDEX_OFFSET = 20 + 8 + 8 * sizeof(QVector3D);
+
+
+static std::filesystem::path getEntryPath(const std::filesystem::path &directory, uint64_t key)
+{
+    return directory / std::format("{:016x}.bin", key);
+}
+
+static void storeBoxes(CollisionCache &cache, uint64_t key)
+{
+    std::vector<std::unique_ptr<Mesh>> meshes;
+    meshes.push_back(std::make_unique<Mesh>(TestMeshes::box(QVector3D(0, 0, 0), QVector3D(1, 2, 3))));
+    meshes.push_back(std::make_unique<Mesh>(TestMeshes::box(QVector3D(-1, -1, -1), QVector3D(0, 0, 0))));
+
+    MeshPrimitive primitive;
+    primitive.type = MeshPrimitiveType::BoxPrimitive;
+    primitive.center = QVector3D(0.5f, 1.0f, 1.5f);
+    primitive.half_extents = QVector3D(0.5f, 1.0f, 1.5f);
+    meshes.front()->setPrimitive(primitive);
+
+    cache.store(key, meshes);
+}
+
+
+TEST_CASE(cacheRoundTrip)
+{
+    const std::filesystem::path directory = TestMeshes::scratchDirectory("cache_round_trip");
+    CollisionCache cache(directory.string(), 1024 * 1024);
+    storeBoxes(cache, CACHE_KEY);
+
+    std::vector<std::unique_ptr<Mesh>> loaded;
+    TEST_CHECK(cache.load(CACHE_KEY, loaded));
+    TEST_CHECK(loaded.size() == 2);
+    if (loaded.size() != 2)
+    {
+        return;
+    }
+
+    const Mesh expected = TestMeshes::box(QVector3D(0, 0, 0), QVector3D(1, 2, 3));
+    TEST_CHECK(std::ranges::equal(loaded[0]->getVertices(), expected.getVertices()));
+    TEST_CHECK(std::ranges::equal(loaded[0]->getIndices(), expected.getIndices()));
+    TEST_CHECK(loaded[0]->getPrimitive().type == MeshPrimitiveType::BoxPrimitive);
+    TEST_CHECK(loaded[0]->getPrimitive().half_extents == QVector3D(0.5f, 1.0f, 1.5f));
+    TEST_CHECK(!loaded[1]->isPrimitive());
+
+    std::vector<std::unique_ptr<Mesh>> missing;
+    TEST_CHECK(!cache.load(OTHER_CACHE_KEY, missing));
+    TEST_CHECK(missing.empty());
+}
+
+TEST_CASE(cacheEvictsMismatchedKey)
+{
+    const std::filesystem::path directory = TestMeshes::scratchDirectory("cache_mismatched_key");
+    CollisionCache cache(directory.string(), 1024 * 1024);
+    storeBoxes(cache, CACHE_KEY);
+
+    /// Entry copied under the name of another key must not be served for that key.
+    std::filesystem::rename(getEntryPath(directory, CACHE_KEY), getEntryPath(directory, OTHER_CACHE_KEY));
+
+    std::vector<std::unique_ptr<Mesh>> loaded;
+    TEST_CHECK(!cache.load(OTHER_CACHE_KEY, loaded));
+    TEST_CHECK(loaded.empty());
+    TEST_CHECK(!std::filesystem::exists(getEntryPath(directory, OTHER_CACHE_KEY)));
+}
+
+TEST_CASE(cacheEvictsOutOfRangeIndex)
+{
+    const std::filesystem::path directory = TestMeshes::scratchDirectory("cache_out_of_range_index");
+    CollisionCache cache(directory.string(), 1024 * 1024);
+    storeBoxes(cache, CACHE_KEY);
+
+    {
+        std::fstream file(getEntryPath(directory, CACHE_KEY), std::ios::binary | std::ios::in | std::ios::out);
+        const int index = 1000;
+        file.seekp(FIRST_INDEX_OFFSET);
+        file.write(reinterpret_cast<const char*>(&index), sizeof(index));
+    }
+
+    std::vector<std::unique_ptr<Mesh>> loaded;
+    TEST_CHECK(!cache.load(CACHE_KEY, loaded));
+    TEST_CHECK(loaded.empty());
+    TEST_CHECK(!std::filesystem::exists(getEntryPath(directory, CACHE_KEY)));
+}
+
+TEST_CASE(cacheEvictsTruncatedEntry)
+{
+    const std::filesystem::path directory = TestMeshes::scratchDirectory("cache_truncated_entry");
+    CollisionCache cache(directory.string(), 1024 * 1024);
+    storeBoxes(cache, CACHE_KEY);
+
+    const std::filesystem::path path = getEntryPath(directory, CACHE_KEY);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+
+    std::vector<std::unique_ptr<Mesh>> loaded;
+    TEST_CHECK(!cache.load(CACHE_KEY, loaded));
+    TEST_CHECK(loaded.empty());
+    TEST_CHECK(!std::filesystem::exists(path));
+}
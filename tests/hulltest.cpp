@@ -0,0 +1,138 @@
+#include "testing.h"
+#include "testmeshes.h"
+#include "collisiongen.h"
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <numbers>
+#include <span>
+#include <utility>
+#include <vector>
+
+
+static std::vector<std::unique_ptr<Mesh>> makeBoxes(const std::vector<std::pair<QVector3D, QVector3D>> &bounds)
+{
+    std::vector<std::unique_ptr<Mesh>> hulls;
+    for (const auto &[min, max] : bounds)
+    {
+        hulls.push_back(std::make_unique<Mesh>(TestMeshes::box(min, max)));
+    }
+
+    return hulls;
+}
+
+/// Returns true if given point lies inside of convex hull or within tolerance of its surface.
+static bool hullContains(const Mesh &hull, const QVector3D &point, float tolerance)
+{
+    QVector3D centroid;
+    for (const QVector3D &vertex : hull.getVertices())
+    {
+        centroid += vertex;
+    }
+    centroid /= float(hull.numVertices());
+
+    std::span<const QVector3D> vertices = hull.getVertices();
+    std::span<const int> indices = hull.getIndices();
+    for (size_t i=0; i + 2 < indices.size(); i+=3)
+    {
+        const QVector3D &a = vertices[indices[i]];
+        const QVector3D normal = QVector3D::crossProduct(vertices[indices[i+1]] - a, vertices[indices[i+2]] - a).normalized();
+        const float side = QVector3D::dotProduct(normal, centroid - a) < 0.0f ? 1.0f : -1.0f;
+        if (side * QVector3D::dotProduct(normal, point - a) > tolerance)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+TEST_CASE(hullMergeAdjacentBoxes)
+{
+    std::vector<std::unique_ptr<Mesh>> hulls = makeBoxes({
+        {QVector3D(0, 0, 0), QVector3D(1, 1, 1)},
+        {QVector3D(1, 0, 0), QVector3D(2, 1, 1)}
+    });
+
+    TEST_CHECK(CollisionGen::mergeHulls(hulls, 0.05) == 1);
+    TEST_CHECK(hulls.size() == 1);
+    TEST_CHECK_NEAR(hulls.front()->computeVolume(), 2.0, 1e-4);
+}
+
+TEST_CASE(hullMergeRespectsThreshold)
+{
+    /// Boxes touching along an edge only, their hull adds half of their volume.
+    std::vector<std::unique_ptr<Mesh>> hulls = makeBoxes({
+        {QVector3D(0, 0, 0), QVector3D(1, 1, 1)},
+        {QVector3D(1, 1, 0), QVector3D(2, 2, 1)}
+    });
+
+    TEST_CHECK(CollisionGen::mergeHulls(hulls, 0.05) == 0);
+    TEST_CHECK(hulls.size() == 2);
+
+    TEST_CHECK(CollisionGen::mergeHulls(hulls, 1.0) == 1);
+    TEST_CHECK(hulls.size() == 1);
+
+    /// Distant boxes are never merged while the threshold is bounded.
+    std::vector<std::unique_ptr<Mesh>> distant = makeBoxes({
+        {QVector3D(0, 0, 0), QVector3D(1, 1, 1)},
+        {QVector3D(5, 0, 0), QVector3D(6, 1, 1)}
+    });
+
+    TEST_CHECK(CollisionGen::mergeHulls(distant, 1.0) == 0);
+    TEST_CHECK(distant.size() == 2);
+}
+
+TEST_CASE(hullMergeStopsAtMinHulls)
+{
+    std::vector<std::unique_ptr<Mesh>> hulls = makeBoxes({
+        {QVector3D(0, 0, 0), QVector3D(1, 1, 1)},
+        {QVector3D(1, 0, 0), QVector3D(2, 1, 1)},
+        {QVector3D(2, 0, 0), QVector3D(3, 1, 1)},
+        {QVector3D(3, 0, 0), QVector3D(4, 1, 1)},
+        {QVector3D(10, 0, 0), QVector3D(11, 1, 1)}
+    });
+
+    TEST_CHECK(CollisionGen::mergeHulls(hulls, std::numeric_limits<double>::infinity(), 2) == 3);
+    TEST_CHECK(hulls.size() == 2);
+
+    double volume = 0.0;
+    for (const std::unique_ptr<Mesh> &hull : hulls)
+    {
+        volume += hull->computeVolume();
+    }
+    TEST_CHECK(volume >= 5.0 - 1e-4);
+}
+
+TEST_CASE(hullSimplifyMeetsVertexLimit)
+{
+    /// Hull of points spread over a unit sphere.
+    std::vector<CGAL_FastPoint> points;
+    const int num_points = 40;
+    for (int i=0; i < num_points; i++)
+    {
+        const double z = 1.0 - 2.0 * (i + 0.5) / num_points;
+        const double radius = std::sqrt(1.0 - z * z);
+        const double angle = i * std::numbers::pi * (3.0 - std::sqrt(5.0));
+        points.emplace_back(radius * std::cos(angle), radius * std::sin(angle), z);
+    }
+
+    Mesh hull({}, {});
+    TEST_CHECK(CollisionGen::computeConvexHull(points, hull));
+    TEST_CHECK(hull.numVertices() > 16);
+
+    const Mesh original = hull;
+    double added_volume = 0.0;
+    TEST_CHECK(CollisionGen::simplifyHull(hull, 16, added_volume));
+    TEST_CHECK(hull.numVertices() <= 16);
+    TEST_CHECK(added_volume >= 0.0);
+    TEST_CHECK_NEAR(hull.computeVolume() - original.computeVolume(), added_volume, 1e-3);
+
+    /// Simplification only removes planes, so the result still contains the input.
+    for (const QVector3D &vertex : original.getVertices())
+    {
+        TEST_CHECK(hullContains(hull, vertex, 1e-4f));
+    }
+}
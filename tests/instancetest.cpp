@@ -0,0 +1,93 @@
+#include "testing.h"
+#include "testmeshes.h"
+#include "collisioninstances.h"
+
+#include <vector>
+#include <QQuaternion>
+
+
+/// Returns tetrahedron without any symmetry, so its canonical frame is unambiguous.
+static Mesh makeTetrahedron()
+{
+    const std::vector<QVector3D> vertices = {
+        QVector3D(0.0f, 0.0f, 0.0f),
+        QVector3D(3.0f, 0.0f, 0.0f),
+        QVector3D(0.0f, 1.5f, 0.0f),
+        QVector3D(0.2f, 0.4f, 0.7f)
+    };
+    const std::vector<int> indices = {0, 2, 1,  0, 1, 3,  1, 2, 3,  0, 3, 2};
+
+    Mesh mesh(vertices, indices);
+    mesh.computeBounds();
+    return mesh;
+}
+
+/// Returns copy of given mesh with every vertex mapped by given function.
+template <typename Transform>
+static Mesh transformVertices(const Mesh &mesh, Transform transform)
+{
+    std::vector<QVector3D> vertices;
+    for (const QVector3D &vertex : mesh.getVertices())
+    {
+        vertices.push_back(transform(vertex));
+    }
+
+    Mesh out_mesh(vertices, mesh.getIndices());
+    out_mesh.computeBounds();
+    return out_mesh;
+}
+
+
+TEST_CASE(instanceExactCopies)
+{
+    const Mesh mesh = makeTetrahedron();
+    const Mesh copy = mesh;
+
+    std::vector<MeshInstance> instances;
+    TEST_CHECK(CollisionInstances::findInstances({&mesh, &copy}, 1e-4, instances) == 1);
+    TEST_CHECK(instances.size() == 2);
+    TEST_CHECK(instances[0].prototype == 0);
+    TEST_CHECK(instances[1].prototype == 0);
+}
+
+TEST_CASE(instanceRigidTransform)
+{
+    const Mesh mesh = makeTetrahedron();
+    const QQuaternion rotation = QQuaternion::fromAxisAndAngle(QVector3D(1.0f, 2.0f, 0.5f).normalized(), 73.0f);
+    const QVector3D translation(4.0f, -2.0f, 10.0f);
+    const Mesh moved = transformVertices(mesh, [&](const QVector3D &vertex)
+    {
+        return rotation.rotatedVector(vertex) + translation;
+    });
+
+    std::vector<MeshInstance> instances;
+    TEST_CHECK(CollisionInstances::findInstances({&mesh, &moved}, 1e-4, instances) == 1);
+    TEST_CHECK(instances[1].prototype == 0);
+
+    /// Prototype placed by the found transform lands on the moved copy.
+    Mesh placed({}, {});
+    CollisionInstances::transformMesh(mesh, instances[1], placed);
+    TEST_CHECK(placed.numVertices() == moved.numVertices());
+    for (size_t i=0; i < placed.numVertices() && i < moved.numVertices(); i++)
+    {
+        TEST_CHECK((placed.getVertices()[i] - moved.getVertices()[i]).length() < 1e-3f);
+    }
+}
+
+TEST_CASE(instanceRejectsScaledAndMirroredCopies)
+{
+    const Mesh mesh = makeTetrahedron();
+    const Mesh scaled = transformVertices(mesh, [](const QVector3D &vertex)
+    {
+        return vertex * 1.5f;
+    });
+    const Mesh mirrored = transformVertices(mesh, [](const QVector3D &vertex)
+    {
+        return QVector3D(-vertex.x(), vertex.y(), vertex.z());
+    });
+
+    std::vector<MeshInstance> instances;
+    TEST_CHECK(CollisionInstances::findInstances({&mesh, &scaled, &mirrored}, 1e-4, instances) == 3);
+    TEST_CHECK(instances[1].prototype == 1);
+    TEST_CHECK(instances[2].prototype == 2);
+}
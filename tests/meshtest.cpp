@@ -0,0 +1,87 @@
+#include "testing.h"
+#include "testmeshes.h"
+#include "collisiongen.h"
+
+#include <vector>
+
+
+/// Returns copy of given mesh with separate vertices for every triangle corner, offset by given
+/// distance along X on every other corner.
+static Mesh unweld(const Mesh &mesh, float offset = 0.0f)
+{
+    std::vector<QVector3D> vertices;
+    std::vector<int> indices;
+    for (const int &index : mesh.getIndices())
+    {
+        const float corner_offset = indices.size() % 2 ? offset : 0.0f;
+        indices.push_back(int(vertices.size()));
+        vertices.push_back(mesh.getVertices()[index] + QVector3D(corner_offset, 0.0f, 0.0f));
+    }
+
+    return Mesh(vertices, indices);
+}
+
+
+TEST_CASE(meshWeldMergesDuplicateVertices)
+{
+    Mesh mesh = unweld(TestMeshes::box(QVector3D(0, 0, 0), QVector3D(1, 1, 1)));
+    TEST_CHECK(mesh.numVertices() == 36);
+
+    CollisionGen::weldMesh(mesh);
+    TEST_CHECK(mesh.numVertices() == 8);
+    TEST_CHECK(mesh.numIndices() == 36);
+    TEST_CHECK(Mesh::isValid(mesh));
+}
+
+TEST_CASE(meshWeldMergesVerticesWithinTolerance)
+{
+    Mesh mesh = unweld(TestMeshes::box(QVector3D(0, 0, 0), QVector3D(1, 1, 1)), 5e-7f);
+    CollisionGen::weldMesh(mesh);
+    TEST_CHECK(mesh.numVertices() == 8);
+    TEST_CHECK(mesh.numIndices() == 36);
+
+    /// Offset well above the weld tolerance keeps the corners apart.
+    Mesh distinct = unweld(TestMeshes::box(QVector3D(0, 0, 0), QVector3D(1, 1, 1)), 1e-2f);
+    CollisionGen::weldMesh(distinct);
+    TEST_CHECK(distinct.numVertices() > 8);
+    TEST_CHECK(distinct.numIndices() == 36);
+}
+
+TEST_CASE(meshWeldDropsDegenerateTriangles)
+{
+    const Mesh box = TestMeshes::box(QVector3D(0, 0, 0), QVector3D(1, 1, 1));
+    std::vector<QVector3D> vertices(box.getVertices().begin(), box.getVertices().end());
+    std::vector<int> indices(box.getIndices().begin(), box.getIndices().end());
+
+    /// Triangle with repeated corner and triangle with collinear corners, the collinear
+    /// corner is not referenced by any other triangle and is dropped as well.
+    vertices.push_back(QVector3D(0.5f, 0.0f, 0.0f));
+    indices.insert(indices.end(), {0, 0, 1});
+    indices.insert(indices.end(), {0, 8, 1});
+
+    Mesh mesh(vertices, indices);
+    TEST_CHECK(!Mesh::isValid(mesh));
+
+    CollisionGen::weldMesh(mesh);
+    TEST_CHECK(mesh.numVertices() == 8);
+    TEST_CHECK(mesh.numIndices() == 36);
+    TEST_CHECK(Mesh::isValid(mesh));
+}
+
+TEST_CASE(meshIsValid)
+{
+    const Mesh box = TestMeshes::box(QVector3D(0, 0, 0), QVector3D(1, 2, 3));
+    TEST_CHECK(Mesh::isValid(box));
+    TEST_CHECK(Mesh::isValid(Mesh({}, {})));
+
+    std::vector<QVector3D> vertices(box.getVertices().begin(), box.getVertices().end());
+    std::vector<int> indices(box.getIndices().begin(), box.getIndices().end());
+    indices.back() = 8;
+    TEST_CHECK(!Mesh::isValid(Mesh(vertices, indices)));
+
+    indices.back() = -1;
+    TEST_CHECK(!Mesh::isValid(Mesh(vertices, indices)));
+
+    const std::vector<int> no_vertex_indices = {0, 1, 2};
+    TEST_CHECK(!Mesh::isValid(Mesh({}, no_vertex_indices)));
+}
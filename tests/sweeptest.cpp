@@ -0,0 +1,69 @@
+#include "testing.h"
+#include "collisionsweep.h"
+
+#include <vector>
+
+
+static CollisionSweepResult makeResult(size_t num_hulls, size_t num_vertices, double error, bool valid = true)
+{
+    CollisionSweepResult result;
+    result.num_hulls = num_hulls;
+    result.max_mesh_hulls = num_hulls;
+    result.num_vertices = num_vertices;
+    result.max_hull_vertices = num_hulls > 0 ? num_vertices / num_hulls : 0;
+    result.error = error;
+    result.valid = valid;
+    return result;
+}
+
+
+TEST_CASE(sweepParetoSet)
+{
+    std::vector<CollisionSweepResult> results;
+    results.push_back(makeResult(4, 128, 0.02));
+    results.push_back(makeResult(8, 256, 0.01));
+    results.push_back(makeResult(8, 256, 0.03));
+    results.push_back(makeResult(2, 64, 0.05));
+    results.push_back(makeResult(1, 8, 0.0, false));
+    results.push_back(makeResult(4, 128, 0.02));
+
+    CollisionSweep::markParetoSet(results);
+    TEST_CHECK(results[0].pareto);
+    TEST_CHECK(results[1].pareto);
+    TEST_CHECK(!results[2].pareto);
+    TEST_CHECK(results[3].pareto);
+    TEST_CHECK(!results[4].pareto);
+
+    /// Identical results do not dominate each other.
+    TEST_CHECK(results[5].pareto);
+}
+
+TEST_CASE(sweepSelectCheapest)
+{
+    std::vector<CollisionSweepResult> results;
+    results.push_back(makeResult(8, 256, 0.01));
+    results.push_back(makeResult(4, 128, 0.02));
+    results.push_back(makeResult(2, 64, 0.05));
+    results.push_back(makeResult(1, 8, 0.0, false));
+    results.push_back(makeResult(3, 128, 0.02));
+
+    CollisionSweepTarget target;
+    target.max_hulls = 8;
+    target.max_hull_vertices = 64;
+    target.max_error = 0.03;
+
+    /// Cheapest within the error budget, equal vertex counts are decided by hull count.
+    TEST_CHECK(CollisionSweep::selectCheapest(results, target) == 4);
+
+    /// Hull limit applies to the hull count of each mesh.
+    target.max_hulls = 2;
+    TEST_CHECK(CollisionSweep::selectCheapest(results, target) == -1);
+
+    target.max_error = 0.1;
+    TEST_CHECK(CollisionSweep::selectCheapest(results, target) == 2);
+
+    /// Vertex limit applies to each hull.
+    target.max_hulls = 8;
+    target.max_hull_vertices = 16;
+    TEST_CHECK(CollisionSweep::selectCheapest(results, target) == -1);
+}
@@ -0,0 +1,59 @@
+#ifndef TESTING_H
+#define TESTING_H
+
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+/// Minimal registry of unit tests, each test is a function registered under its name.
+/// Tests report failed checks through TEST_CHECK and keep running after a failure.
+class Testing
+{
+public:
+    struct TestCase
+    {
+        std::string           name;
+        std::function<void()> run;
+    };
+
+    static std::vector<TestCase>& tests()
+    {
+        static std::vector<TestCase> registry;
+        return registry;
+    }
+
+    static int& failures()
+    {
+        static int num_failures = 0;
+        return num_failures;
+    }
+
+    static bool add(const std::string &name, const std::function<void()> &run)
+    {
+        Testing::tests().push_back({name, run});
+        return true;
+    }
+
+    static void fail(const char *expression, const char *file, int line)
+    {
+        std::cerr << file << ":" << line << ": Check failed -> " << expression << std::endl;
+        Testing::failures()++;
+    }
+};
+
+/// Define test function registered under given name, name prefix selects tests from command line.
+#define TEST_CASE(name) \
+    static void name(); \
+    static const bool name##_registered = Testing::add(#name, name); \
+    static void name()
+
+#define TEST_CHECK(expression) \
+    do { if (!(expression)) { Testing::fail(#expression, __FILE__, __LINE__); } } while (false)
+
+#define TEST_CHECK_NEAR(a, b, tolerance) \
+    TEST_CHECK(std::abs(double(a) - double(b)) <= double(tolerance))
+
+#endif
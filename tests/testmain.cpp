@@ -0,0 +1,42 @@
+#include "testing.h"
+#include "logging.h"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+
+
+/// Run all registered tests whose name starts with the first argument, or all of them.
+/// Returns zero if every check passed and at least one test ran.
+int main(int argc, char *argv[])
+{
+    const std::string filter = argc > 1 ? argv[1] : "";
+
+    const std::string log_path = (std::filesystem::temp_directory_path() / "CollisionCraftTests.log").string();
+    std::shared_ptr<Logger> logger = std::make_shared<Logger>(log_path);
+    logger->initLogFile();
+    Logger::setActive(logger);
+
+    int num_run = 0;
+    for (const Testing::TestCase &test : Testing::tests())
+    {
+        if (test.name.rfind(filter, 0) != 0)
+        {
+            continue;
+        }
+
+        const int num_failures = Testing::failures();
+        test.run();
+        num_run++;
+
+        std::cout << (Testing::failures() == num_failures ? "PASSED" : "FAILED") << " - " << test.name << std::endl;
+    }
+
+    if (num_run == 0)
+    {
+        std::cerr << "No tests match -> " << filter << std::endl;
+        return 1;
+    }
+
+    return Testing::failures() == 0 ? 0 : 1;
+}
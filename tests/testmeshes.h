@@ -0,0 +1,54 @@
+#ifndef TEST_MESHES_H
+#define TEST_MESHES_H
+
+#include "mesh.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <QVector3D>
+
+
+/// Small closed meshes and scratch directories shared by the tests.
+class TestMeshes
+{
+public:
+    /// Returns axis aligned box spanning given bounds, triangles wound counter-clockwise from outside.
+    static Mesh box(const QVector3D &min, const QVector3D &max)
+    {
+        std::vector<QVector3D> vertices;
+        for (int i=0; i < 8; i++)
+        {
+            vertices.push_back(QVector3D(
+                i & 1 ? max.x() : min.x(),
+                i & 2 ? max.y() : min.y(),
+                i & 4 ? max.z() : min.z()
+            ));
+        }
+
+        const std::vector<int> indices = {
+            0, 2, 3,  0, 3, 1,
+            4, 5, 7,  4, 7, 6,
+            0, 1, 5,  0, 5, 4,
+            2, 6, 7,  2, 7, 3,
+            0, 4, 6,  0, 6, 2,
+            1, 3, 7,  1, 7, 5
+        };
+
+        Mesh mesh(vertices, indices);
+        mesh.generateNormals();
+        mesh.computeBounds();
+        return mesh;
+    }
+
+    /// Returns empty scratch directory of given name inside the system temporary directory.
+    static std::filesystem::path scratchDirectory(const std::string &name)
+    {
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "CollisionCraftTests" / name;
+        std::filesystem::remove_all(path);
+        std::filesystem::create_directories(path);
+        return path;
+    }
+};
+
+#endif
@@ -0,0 +1,164 @@
+#include "testing.h"
+#include "testmeshes.h"
+#include "collisionvoxelizer.h"
+
+#include <array>
+#include <vector>
+
+
+/// Returns empty grid of given size with unit voxels.
+static VoxelGrid makeGrid(int size_x, int size_y, int size_z)
+{
+    VoxelGrid grid;
+    grid.size = {size_x, size_y, size_z};
+    grid.voxel_size = 1.0f;
+    grid.voxels.assign(size_t(size_x) * size_y * size_z, 0);
+    return grid;
+}
+
+static size_t countSolid(const VoxelGrid &grid)
+{
+    size_t num_solid = 0;
+    for (const uint8_t &voxel : grid.voxels)
+    {
+        num_solid += voxel ? 1 : 0;
+    }
+
+    return num_solid;
+}
+
+static size_t boxVolume(const VoxelBox &box)
+{
+    return size_t(box.max[0] - box.min[0] + 1) * (box.max[1] - box.min[1] + 1) * (box.max[2] - box.min[2] + 1);
+}
+
+
+TEST_CASE(voxelFillInteriorOfShell)
+{
+    /// Closed 5x5x5 shell of solid voxels enclosing 3x3x3 empty voxels, surrounded by empty border.
+    VoxelGrid grid = makeGrid(7, 7, 7);
+    for (int z=1; z <= 5; z++)
+    {
+        for (int y=1; y <= 5; y++)
+        {
+            for (int x=1; x <= 5; x++)
+            {
+                const bool shell = x == 1 || y == 1 || z == 1 || x == 5 || y == 5 || z == 5;
+                grid.voxels[grid.index(x, y, z)] = shell ? 1 : 0;
+            }
+        }
+    }
+
+    TEST_CHECK(CollisionVoxelizer::fillInterior(grid) == 27);
+    TEST_CHECK(countSolid(grid) == 125);
+    TEST_CHECK(grid.voxels[grid.index(3, 3, 3)] == 1);
+    TEST_CHECK(grid.voxels[grid.index(0, 0, 0)] == 0);
+
+    /// Opening in the shell connects the inside with the outside.
+    VoxelGrid open_grid = makeGrid(7, 7, 7);
+    for (int z=1; z <= 5; z++)
+    {
+        for (int y=1; y <= 5; y++)
+        {
+            for (int x=1; x <= 5; x++)
+            {
+                const bool shell = x == 1 || y == 1 || z == 1 || x == 5 || y == 5 || z == 5;
+                open_grid.voxels[open_grid.index(x, y, z)] = shell ? 1 : 0;
+            }
+        }
+    }
+
+    open_grid.voxels[open_grid.index(3, 3, 5)] = 0;
+    TEST_CHECK(CollisionVoxelizer::fillInterior(open_grid) == 0);
+    TEST_CHECK(countSolid(open_grid) == 97);
+}
+
+TEST_CASE(voxelMergeBoxesCoversSolid)
+{
+    /// L shaped solid covered by exactly two boxes.
+    VoxelGrid grid = makeGrid(6, 6, 3);
+    for (int y=0; y < 4; y++)
+    {
+        for (int x=0; x < 4; x++)
+        {
+            grid.voxels[grid.index(x, y, 1)] = x < 1 || y < 1 ? 1 : 0;
+        }
+    }
+
+    std::vector<VoxelBox> boxes;
+    CollisionVoxelizer::mergeBoxes(grid, boxes);
+    TEST_CHECK(boxes.size() == 2);
+
+    /// Boxes never overlap and cover only solid voxels, so their volumes add up to the solid count.
+    size_t volume = 0;
+    std::vector<int> coverage(grid.voxels.size(), 0);
+    for (const VoxelBox &box : boxes)
+    {
+        volume += boxVolume(box);
+        for (int z=box.min[2]; z <= box.max[2]; z++)
+        {
+            for (int y=box.min[1]; y <= box.max[1]; y++)
+            {
+                for (int x=box.min[0]; x <= box.max[0]; x++)
+                {
+                    TEST_CHECK(grid.voxels[grid.index(x, y, z)] == 1);
+                    coverage[grid.index(x, y, z)]++;
+                }
+            }
+        }
+    }
+
+    TEST_CHECK(volume == countSolid(grid));
+    for (size_t i=0; i < coverage.size(); i++)
+    {
+        TEST_CHECK(coverage[i] == (grid.voxels[i] ? 1 : 0));
+    }
+}
+
+TEST_CASE(voxelLimitBoxes)
+{
+    std::vector<VoxelBox> boxes = {
+        {{0, 0, 0}, {0, 0, 0}},
+        {{1, 0, 0}, {1, 0, 0}},
+        {{5, 5, 5}, {5, 5, 5}},
+        {{0, 1, 0}, {1, 1, 0}}
+    };
+
+    /// Boxes forming a rectangle merge without adding any volume.
+    TEST_CHECK(CollisionVoxelizer::limitBoxes(boxes, 2) == 0);
+    TEST_CHECK(boxes.size() == 2);
+
+    TEST_CHECK(CollisionVoxelizer::limitBoxes(boxes, 1) == 211);
+    TEST_CHECK(boxes.size() == 1);
+    TEST_CHECK(boxes.front().min == (std::array<int, 3>{0, 0, 0}));
+    TEST_CHECK(boxes.front().max == (std::array<int, 3>{5, 5, 5}));
+
+    /// Limit below one still keeps single box.
+    TEST_CHECK(CollisionVoxelizer::limitBoxes(boxes, 0) == 0);
+    TEST_CHECK(boxes.size() == 1);
+}
+
+TEST_CASE(voxelizeClosedBox)
+{
+    const Mesh box = TestMeshes::box(QVector3D(0, 0, 0), QVector3D(1, 1, 1));
+
+    VoxelGrid grid;
+    CollisionVoxelizer::initGrid(box.getVertices(), 8, grid);
+    CollisionVoxelizer::voxelizeSurface(box.getVertices(), box.getIndices(), grid);
+    CollisionVoxelizer::fillInterior(grid);
+
+    /// Solid covers the box and the border layer stays empty.
+    TEST_CHECK(countSolid(grid) >= 8 * 8 * 8);
+    for (int z=0; z < grid.size[2]; z++)
+    {
+        for (int y=0; y < grid.size[1]; y++)
+        {
+            TEST_CHECK(grid.voxels[grid.index(0, y, z)] == 0);
+            TEST_CHECK(grid.voxels[grid.index(grid.size[0] - 1, y, z)] == 0);
+        }
+    }
+
+    std::vector<VoxelBox> boxes;
+    CollisionVoxelizer::mergeBoxes(grid, boxes);
+    TEST_CHECK(boxes.size() == 1);
+}
@@ -0,0 +1,89 @@
+#include "testing.h"
+#include "testmeshes.h"
+#include "collisionworker.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+
+/// Byte offsets into serialized worker result, see CollisionWorker::writeWorkerResult.
+static const size_t RESULT_HULLS_OFFSET = 24;
+static const size_t RESULT_NUM_HULLS_OFFSET = 4;
+
+
+static std::vector<unsigned char> writeBoxes(std::vector<std::unique_ptr<Mesh>> &out_meshes)
+{
+    out_meshes.clear();
+    out_meshes.push_back(std::make_unique<Mesh>(TestMeshes::box(QVector3D(0, 0, 0), QVector3D(1, 1, 1))));
+    out_meshes.push_back(std::make_unique<Mesh>(TestMeshes::box(QVector3D(2, 0, 0), QVector3D(3, 2, 1))));
+
+    std::vector<unsigned char> data;
+    CollisionWorker::writeWorkerResult(out_meshes, data);
+    return data;
+}
+
+static void writeUint32(std::vector<unsigned char> &data, size_t offset, uint32_t value)
+{
+    std::memcpy(data.data() + offset, &value, sizeof(value));
+}
+
+/// Returns true if given result is rejected and the output list is left untouched.
+static bool isRejected(const std::vector<unsigned char> &data)
+{
+    std::vector<std::unique_ptr<Mesh>> meshes;
+    meshes.push_back(std::make_unique<Mesh>(TestMeshes::box(QVector3D(0, 0, 0), QVector3D(1, 1, 1))));
+    return !CollisionWorker::readWorkerResult(data.data(), data.size(), meshes) && meshes.size() == 1;
+}
+
+
+TEST_CASE(workerResultRoundTrip)
+{
+    std::vector<std::unique_ptr<Mesh>> meshes;
+    const std::vector<unsigned char> data = writeBoxes(meshes);
+
+    std::vector<std::unique_ptr<Mesh>> loaded;
+    TEST_CHECK(CollisionWorker::readWorkerResult(data.data(), data.size(), loaded));
+    TEST_CHECK(loaded.size() == meshes.size());
+    for (size_t i=0; i < loaded.size() && i < meshes.size(); i++)
+    {
+        TEST_CHECK(std::ranges::equal(loaded[i]->getVertices(), meshes[i]->getVertices()));
+        TEST_CHECK(std::ranges::equal(loaded[i]->getIndices(), meshes[i]->getIndices()));
+    }
+}
+
+TEST_CASE(workerResultRejectsMalformed)
+{
+    std::vector<std::unique_ptr<Mesh>> meshes;
+    const std::vector<unsigned char> data = writeBoxes(meshes);
+
+    TEST_CHECK(isRejected({}));
+    TEST_CHECK(isRejected(std::vector<unsigned char>(data.begin(), data.begin() + RESULT_HULLS_OFFSET - 1)));
+    TEST_CHECK(isRejected(std::vector<unsigned char>(data.begin(), data.end() - 1)));
+
+    std::vector<unsigned char> bad_magic = data;
+    bad_magic[0] ^= 0xff;
+    TEST_CHECK(isRejected(bad_magic));
+
+    /// More hulls than the header sizes leave room for.
+    std::vector<unsigned char> too_many_hulls = data;
+    writeUint32(too_many_hulls, RESULT_NUM_HULLS_OFFSET, 1000000);
+    TEST_CHECK(isRejected(too_many_hulls));
+
+    /// First hull claiming more vertices than the result holds.
+    std::vector<unsigned char> hull_overflow = data;
+    writeUint32(hull_overflow, RESULT_HULLS_OFFSET, 1000);
+    TEST_CHECK(isRejected(hull_overflow));
+
+    /// First hull with index count which is not a multiple of three.
+    std::vector<unsigned char> partial_triangle = data;
+    writeUint32(partial_triangle, RESULT_HULLS_OFFSET + sizeof(uint32_t), 35);
+    TEST_CHECK(isRejected(partial_triangle));
+
+    /// Last index of the last hull pointing past its vertices.
+    std::vector<unsigned char> bad_index = data;
+    writeUint32(bad_index, bad_index.size() - sizeof(int), 8);
+    TEST_CHECK(isRejected(bad_index));
+}